@@ -10,6 +10,17 @@ else ()
     message (FATAL_ERROR "No intrinsics header found")
 endif ()
 
+if (BUILD_AVX512VBMI AND NOT BUILD_AVX512)
+    message (FATAL_ERROR "AVX512VBMI in the fat runtime requires BUILD_AVX512")
+endif ()
+
+if (BUILD_AVX512VBMI)
+    CHECK_C_COMPILER_FLAG(${ICELAKE_FLAG} HAS_ARCH_ICELAKE)
+    if (NOT HAS_ARCH_ICELAKE)
+        message (FATAL_ERROR "AVX512VBMI not supported by compiler")
+    endif ()
+endif ()
+
 if (BUILD_AVX512)
     CHECK_C_COMPILER_FLAG(${SKYLAKE_FLAG} HAS_ARCH_SKYLAKE)
     if (NOT HAS_ARCH_SKYLAKE)
@@ -19,7 +30,9 @@ endif ()
 
 if (FAT_RUNTIME)
     # test the highest level microarch to make sure everything works
-    if (BUILD_AVX512)
+    if (BUILD_AVX512VBMI)
+        set (CMAKE_REQUIRED_FLAGS "${CMAKE_C_FLAGS} ${EXTRA_C_FLAGS} ${ICELAKE_FLAG}")
+    elseif (BUILD_AVX512)
         set (CMAKE_REQUIRED_FLAGS "${CMAKE_C_FLAGS} ${EXTRA_C_FLAGS} ${SKYLAKE_FLAG}")
     else ()
         set (CMAKE_REQUIRED_FLAGS "${CMAKE_C_FLAGS} ${EXTRA_C_FLAGS} -march=core-avx2")
@@ -58,6 +71,17 @@ int main(){
     (void)_mm512_abs_epi8(z);
 }" HAVE_AVX512)
 
+# and AVX512VBMI
+CHECK_C_SOURCE_COMPILES("#include <${INTRIN_INC_H}>
+#if !defined(__AVX512VBMI__)
+#error no avx512vbmi
+#endif
+
+int main(){
+    __m512i z = _mm512_setzero_si512();
+    (void)_mm512_permutexvar_epi8(z, z);
+}" HAVE_AVX512VBMI)
+
 if (FAT_RUNTIME)
     if (NOT HAVE_SSSE3)
         message(FATAL_ERROR "SSSE3 support required to build fat runtime")
@@ -68,6 +92,9 @@ if (FAT_RUNTIME)
     if (BUILD_AVX512 AND NOT HAVE_AVX512)
         message(FATAL_ERROR "AVX512 support requested but not supported")
     endif ()
+    if (BUILD_AVX512VBMI AND NOT HAVE_AVX512VBMI)
+        message(FATAL_ERROR "AVX512VBMI support requested but not supported")
+    endif ()
 else (NOT FAT_RUNTIME)
     if (NOT HAVE_AVX2)
         message(STATUS "Building without AVX2 support")
@@ -75,6 +102,9 @@ else (NOT FAT_RUNTIME)
     if (NOT HAVE_AVX512)
         message(STATUS "Building without AVX512 support")
     endif ()
+    if (NOT HAVE_AVX512VBMI)
+        message(STATUS "Building without AVX512VBMI support")
+    endif ()
     if (NOT HAVE_SSSE3)
         message(FATAL_ERROR "A minimum of SSSE3 compiler support is required")
     endif ()
@@ -114,8 +114,9 @@ hs_error_t HS_CDECL hs_serialize_database(const hs_database_t *db, char **bytes,
 static
 hs_error_t db_check_platform(const u64a p) {
     if (p != hs_current_platform
-        && p != hs_current_platform_no_avx2
-        && p != hs_current_platform_no_avx512) {
+        && p != (hs_current_platform | hs_current_platform_no_avx2)
+        && p != (hs_current_platform | hs_current_platform_no_avx512)
+        && p != (hs_current_platform | hs_current_platform_no_avx512vbmi)) {
         return HS_DB_PLATFORM_ERROR;
     }
     // passed all checks
@@ -288,6 +289,154 @@ hs_error_t HS_CDECL hs_deserialize_database(const char *bytes,
     return HS_SUCCESS;
 }
 
+// A mappable serialized database is laid out exactly as an hs_database would
+// be in memory at a cache-line aligned address, so that it can be used in
+// place. The bytecode starts at this offset, within the header's padding.
+#define DB_MAPPED_BYTECODE ROUNDDOWN_N(offsetof(struct hs_database, bytes), 64)
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_serialize_database_mappable(const hs_database_t *db,
+                                                   char **bytes,
+                                                   size_t *serialized_length) {
+    if (!db || !bytes || !serialized_length) {
+        return HS_INVALID;
+    }
+
+    if (!db_correctly_aligned(db)) {
+        return HS_BAD_ALIGN;
+    }
+
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    size_t length = DB_MAPPED_BYTECODE + db->length;
+
+    char *out = hs_misc_alloc(length);
+    ret = hs_check_alloc(out);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(out);
+        return ret;
+    }
+
+    memset(out, 0, length);
+
+    struct hs_database header;
+    memset(&header, 0, sizeof(header));
+    header.magic = db->magic;
+    header.version = db->version;
+    header.length = db->length;
+    header.platform = db->platform;
+    header.crc32 = db->crc32;
+    header.reserved0 = db->reserved0;
+    header.reserved1 = db->reserved1;
+    header.bytecode = DB_MAPPED_BYTECODE;
+
+    // Only the fields before the padding are written; the bytecode overlays
+    // the rest of the header.
+    memcpy(out, &header, offsetof(struct hs_database, padding));
+    memcpy(out + DB_MAPPED_BYTECODE, hs_get_bytecode(db), db->length);
+
+    *bytes = out;
+    *serialized_length = length;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_deserialize_database_mapped(const char *bytes,
+                                                   const size_t length,
+                                                   unsigned int flags,
+                                                   const hs_database_t **db) {
+    if (!bytes || !db) {
+        return HS_INVALID;
+    }
+
+    *db = NULL;
+
+    if (flags & ~HS_MAPPED_SKIP_CRC) {
+        return HS_INVALID;
+    }
+
+    // The bytecode is used where it lies, so the region must be cache-line
+    // aligned (as the start of a memory-mapped file is).
+    if (!ISALIGNED_CL(bytes)) {
+        return HS_BAD_ALIGN;
+    }
+
+    if (length < DB_MAPPED_BYTECODE) {
+        return HS_INVALID;
+    }
+
+    const struct hs_database *header = (const struct hs_database *)bytes;
+    hs_error_t ret = validDatabase(header);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    // This also rejects the output of hs_serialize_database(), which has a
+    // different length for the same bytecode.
+    if (header->bytecode != DB_MAPPED_BYTECODE ||
+        length != DB_MAPPED_BYTECODE + header->length) {
+        DEBUG_PRINTF("bad layout: bytecode at %u, length %zu\n",
+                     header->bytecode, length);
+        return HS_INVALID;
+    }
+
+    // Make sure the serialized database is for our platform
+    ret = db_check_platform(header->platform);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    if (!(flags & HS_MAPPED_SKIP_CRC) && db_check_crc(header) != HS_SUCCESS) {
+        return HS_INVALID;
+    }
+
+    *db = header;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_clone_database_at(const hs_database_t *db,
+                                         hs_database_t *dest) {
+    if (!dest) {
+        return HS_INVALID;
+    }
+
+    hs_error_t ret = validDatabase(db);
+    if (unlikely(ret != HS_SUCCESS)) {
+        return ret;
+    }
+
+    // As with hs_deserialize_database_at(), the destination must be 8-byte
+    // aligned; the bytecode itself is realigned below.
+    if (!ISALIGNED_N(dest, 8)) {
+        return HS_BAD_ALIGN;
+    }
+
+    size_t dblength = sizeof(struct hs_database) + db->length;
+    const char *src_start = (const char *)db;
+    const char *dest_start = (const char *)dest;
+    if (dest_start < src_start + dblength &&
+        src_start < dest_start + dblength) {
+        DEBUG_PRINTF("source and destination overlap\n");
+        return HS_INVALID;
+    }
+
+    // Zero new space for safety
+    memset(dest, 0, dblength);
+
+    // Copy the header into place
+    memcpy(dest, db, sizeof(struct hs_database));
+
+    // Copy the bytecode into the correctly-aligned location, set offsets. No
+    // CRC check is needed: the source database is already in use.
+    db_copy_bytecode(hs_get_bytecode(db), dest);
+
+    return HS_SUCCESS;
+}
+
 HS_PUBLIC_API
 hs_error_t HS_CDECL hs_database_size(const hs_database_t *db, size_t *size) {
     if (!size) {
@@ -370,9 +519,11 @@ hs_error_t print_database_string(char **s, u32 version, const platform_t plat,
     u8 minor = (version >> 16) & 0xff;
     u8 major = (version >> 24) & 0xff;
 
-    const char *features = (plat & HS_PLATFORM_NOAVX512)
-                               ? (plat & HS_PLATFORM_NOAVX2) ? "" : "AVX2"
-                               : "AVX512";
+    const char *features = (plat & HS_PLATFORM_NOAVX512VBMI)
+                               ? (plat & HS_PLATFORM_NOAVX512)
+                                     ? (plat & HS_PLATFORM_NOAVX2) ? "" : "AVX2"
+                                     : "AVX512"
+                               : "AVX512VBMI";
 
     const char *mode = NULL;
 
@@ -38,8 +38,14 @@
 #define check_avx512() (0)
 #endif
 
+#if defined(DISABLE_AVX512VBMI_DISPATCH)
+#define avx512vbmi_ disabled_
+#define check_avx512vbmi() (0)
+#endif
+
 #define CREATE_DISPATCH(RTYPE, NAME, ...)                                      \
     /* create defns */                                                         \
+    RTYPE JOIN(avx512vbmi_, NAME)(__VA_ARGS__);                                \
     RTYPE JOIN(avx512_, NAME)(__VA_ARGS__);                                    \
     RTYPE JOIN(avx2_, NAME)(__VA_ARGS__);                                      \
     RTYPE JOIN(corei7_, NAME)(__VA_ARGS__);                                    \
@@ -52,6 +58,9 @@
                                                                                \
     /* resolver */                                                             \
     static RTYPE (*JOIN(resolve_, NAME)(void))(__VA_ARGS__) {                  \
+        if (check_avx512vbmi()) {                                              \
+            return JOIN(avx512vbmi_, NAME);                                    \
+        }                                                                      \
         if (check_avx512()) {                                                  \
             return JOIN(avx512_, NAME);                                        \
         }                                                                      \
@@ -91,6 +100,17 @@ CREATE_DISPATCH(hs_error_t, hs_scan_stream, hs_stream_t *id, const char *data,
                 unsigned int length, unsigned int flags, hs_scratch_t *scratch,
                 match_event_handler onEvent, void *ctxt);
 
+CREATE_DISPATCH(hs_error_t, hs_scan_stream_partial, hs_stream_t *id,
+                const char *data, unsigned int length, unsigned int budget,
+                unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *ctxt,
+                unsigned int *consumed);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_stream_batch, hs_stream_t *const *ids,
+                const char *const *data, const unsigned int *length,
+                void *const *context, unsigned int count, unsigned int flags,
+                hs_scratch_t *scratch, match_event_handler onEvent);
+
 CREATE_DISPATCH(hs_error_t, hs_close_stream, hs_stream_t *id,
                 hs_scratch_t *scratch, match_event_handler onEvent, void *ctxt);
 
@@ -99,6 +119,11 @@ CREATE_DISPATCH(hs_error_t, hs_scan_vector, const hs_database_t *db,
                 unsigned int count, unsigned int flags, hs_scratch_t *scratch,
                 match_event_handler onevent, void *context);
 
+CREATE_DISPATCH(hs_error_t, hs_scan_batch, const hs_database_t *db,
+                const char *const *data, const unsigned int *length,
+                void *const *context, unsigned int count, unsigned int flags,
+                hs_scratch_t *scratch, match_event_handler onEvent);
+
 CREATE_DISPATCH(hs_error_t, hs_database_info, const hs_database_t *db, char **info);
 
 CREATE_DISPATCH(hs_error_t, hs_copy_stream, hs_stream_t **to_id,
@@ -130,6 +155,19 @@ CREATE_DISPATCH(hs_error_t, hs_serialized_database_size, const char *bytes,
 CREATE_DISPATCH(hs_error_t, hs_compress_stream, const hs_stream_t *stream,
                 char *buf, size_t buf_space, size_t *used_space);
 
+CREATE_DISPATCH(hs_error_t, hs_compress_stream_dense,
+                const hs_stream_t *stream, char *buf, size_t buf_space,
+                size_t *used_space);
+
+CREATE_DISPATCH(hs_error_t, hs_hibernate_stream, const hs_stream_t *stream,
+                char *buf, size_t buf_space, size_t *used_space);
+
+CREATE_DISPATCH(hs_error_t, hs_wake_stream, const hs_database_t *db,
+                const char *buf, size_t buf_size, const char *data,
+                unsigned int length, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context,
+                hs_stream_t **stream);
+
 CREATE_DISPATCH(hs_error_t, hs_expand_stream, const hs_database_t *db,
                 hs_stream_t **stream, const char *buf,size_t buf_size);
 
@@ -137,6 +175,13 @@ CREATE_DISPATCH(hs_error_t, hs_reset_and_expand_stream, hs_stream_t *to_stream,
                 const char *buf, size_t buf_size, hs_scratch_t *scratch,
                 match_event_handler onEvent, void *context);
 
+CREATE_DISPATCH(hs_error_t, hs_pool_open_stream, hs_stream_pool_t *pool,
+                unsigned int flags, hs_stream_t **stream);
+
+CREATE_DISPATCH(hs_error_t, hs_pool_close_stream, hs_stream_pool_t *pool,
+                hs_stream_t *id, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
 /** INTERNALS **/
 
 CREATE_DISPATCH(u32, Crc32c_ComputeBuf, u32 inCrc32, const void *buf, size_t bufLen);
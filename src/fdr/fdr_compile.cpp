@@ -159,7 +159,8 @@ void FDRCompiler::createInitialState(FDR *fdr) {
  */
 bytecode_ptr<FDR> FDRCompiler::setupFDR() {
     auto floodTable = setupFDRFloodControl(lits, eng, grey);
-    auto confirmTable = setupFullConfs(lits, eng, bucketToLits, make_small);
+    auto confirmTable = setupFullConfs(lits, eng, bucketToLits, make_small,
+                                       grey);
 
     size_t headerSize = sizeof(FDR);
     size_t tabSize = eng.getTabSizeBytes();
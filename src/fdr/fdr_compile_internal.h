@@ -61,7 +61,7 @@ bytecode_ptr<u8> setupFullConfs(
       const std::vector<hwlmLiteral> &lits,
       const EngineDescription &eng,
       const std::map<BucketIndex, std::vector<LiteralIndex>> &bucketToLits,
-      bool make_small);
+      bool make_small, const Grey &grey);
 
 // all suffixes include an implicit max_bucket_width suffix to ensure that
 // we always read a full-scale flood "behind" us in terms of what's in our
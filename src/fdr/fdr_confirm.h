@@ -64,6 +64,32 @@ struct LitInfo {
     u8 next;
 };
 
+/**
+ * \brief Set in a lit index entry when the entry is the offset of a LitBlock
+ * rather than of a chain of LitInfo structures.
+ */
+#define FDRC_LIT_INDEX_BLOCK 1
+
+/** \brief Number of candidates checked by one LitBlock compare. */
+#define FDRC_BLOCK_LANES 4
+
+/**
+ * \brief Block of candidates sharing one confirm hash value.
+ *
+ * Used in place of a LitInfo chain when the chain is long. The v and msk
+ * values of all candidates are stored contiguously so that FDRC_BLOCK_LANES
+ * of them can be checked with one SIMD compare. This structure is followed in
+ * memory by:
+ *
+ * -# LitInfo::v for each candidate, padded to a multiple of FDRC_BLOCK_LANES
+ * -# LitInfo::msk for each candidate, padded in the same way
+ * -# LitInfo for each candidate, in chain order
+ */
+struct LitBlock {
+    u32 count; //!< number of candidates
+    u32 reserved;
+};
+
 #define FDRC_FLAG_NO_CONFIRM 1
 #define FDRC_FLAG_NOREPEAT   2
 
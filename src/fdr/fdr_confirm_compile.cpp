@@ -30,6 +30,7 @@
 #include "fdr_compile_internal.h"
 #include "fdr_confirm.h"
 #include "engine_description.h"
+#include "grey.h"
 #include "teddy_engine_description.h"
 #include "ue2common.h"
 #include "util/alloc.h"
@@ -128,9 +129,52 @@ void fillLitInfo(const vector<hwlmLiteral> &lits, vector<LitInfo> &tmpLitInfo,
 
 //#define FDR_CONFIRM_DUMP 1
 
+/**
+ * Hash chains at least Grey::fdrConfirmBlockMinChain long are laid out as a
+ * LitBlock, so that their candidates can be checked several at a time, rather
+ * than as a LitInfo chain walked one candidate at a time.
+ */
+static
+bool useLitBlock(const vector<LiteralIndex> &vlidx, const Grey &grey) {
+    return grey.fdrConfirmBlockMinChain &&
+           vlidx.size() >= grey.fdrConfirmBlockMinChain;
+}
+
+static
+size_t litBlockSize(size_t count) {
+    return sizeof(LitBlock) +
+           2 * ROUNDUP_N(count, FDRC_BLOCK_LANES) * sizeof(CONF_TYPE) +
+           count * sizeof(LitInfo);
+}
+
+/** Lay out a LitBlock for the given hash chain at ptr. */
+static
+u8 *writeLitBlock(const vector<LiteralIndex> &vlidx,
+                  const vector<LitInfo> &tmpLitInfo, u8 *ptr) {
+    const size_t count = vlidx.size();
+    const size_t padded = ROUNDUP_N(count, FDRC_BLOCK_LANES);
+
+    LitBlock &lb = *(LitBlock *)ptr;
+    lb.count = verify_u32(count);
+    ptr += sizeof(LitBlock);
+
+    CONF_TYPE *vals = (CONF_TYPE *)ptr;
+    CONF_TYPE *msks = vals + padded;
+    LitInfo *li = (LitInfo *)(msks + padded);
+    for (size_t j = 0; j < count; j++) {
+        const LitInfo &info = tmpLitInfo[vlidx[j]];
+        vals[j] = info.v;
+        msks[j] = info.msk;
+        li[j] = info;
+        li[j].next = 0;
+    }
+
+    return (u8 *)(li + count);
+}
+
 static
 bytecode_ptr<FDRConfirm> getFDRConfirm(const vector<hwlmLiteral> &lits,
-                                       bool make_small) {
+                                       bool make_small, const Grey &grey) {
     // Every literal must fit within CONF_TYPE.
     assert(all_of_in(lits, [](const hwlmLiteral &lit) {
         return lit.s.size() <= sizeof(CONF_TYPE);
@@ -229,10 +273,20 @@ bytecode_ptr<FDRConfirm> getFDRConfirm(const vector<hwlmLiteral> &lits,
 
     const size_t bitsToLitIndexSize = (1U << nBits) * sizeof(u32);
 
+    // extra space needed by hash chains laid out as blocks
+    size_t blockExtraSize = 0;
+    for (const auto &m : res2lits) {
+        const vector<LiteralIndex> &vlidx = m.second;
+        if (useLitBlock(vlidx, grey)) {
+            blockExtraSize += litBlockSize(vlidx.size()) -
+                              sizeof(LitInfo) * vlidx.size();
+        }
+    }
+
     // this size can now be a worst-case as we can always be a bit smaller
     size_t size = ROUNDUP_N(sizeof(FDRConfirm), alignof(u32)) +
                   ROUNDUP_N(bitsToLitIndexSize, alignof(LitInfo)) +
-                  sizeof(LitInfo) * lits.size();
+                  sizeof(LitInfo) * lits.size() + blockExtraSize;
     size = ROUNDUP_N(size, alignof(FDRConfirm));
 
     auto fdrc = make_zeroed_bytecode_ptr<FDRConfirm>(size);
@@ -260,6 +314,15 @@ bytecode_ptr<FDRConfirm> getFDRConfirm(const vector<hwlmLiteral> &lits,
     for (const auto &m : res2lits) {
         const u32 hash = m.first;
         const vector<LiteralIndex> &vlidx = m.second;
+        if (useLitBlock(vlidx, grey)) {
+            DEBUG_PRINTF("hash %u: block of %zu\n", hash, vlidx.size());
+            assert(ISALIGNED_N(ptr, alignof(LitBlock)));
+            bitsToLitIndex[hash] =
+                verify_u32(ptr - fdrc_base) | FDRC_LIT_INDEX_BLOCK;
+            ptr = writeLitBlock(vlidx, tmpLitInfo, ptr);
+            assert((size_t)(ptr - fdrc_base) <= size);
+            continue;
+        }
         bitsToLitIndex[hash] = verify_u32(ptr - fdrc_base);
         for (auto i = vlidx.begin(), e = vlidx.end(); i != e; ++i) {
             LiteralIndex litIdx = *i;
@@ -293,7 +356,7 @@ bytecode_ptr<u8>
 setupFullConfs(const vector<hwlmLiteral> &lits,
                const EngineDescription &eng,
                const map<BucketIndex, vector<LiteralIndex>> &bucketToLits,
-               bool make_small) {
+               bool make_small, const Grey &grey) {
     unique_ptr<TeddyEngineDescription> teddyDescr =
         getTeddyDescription(eng.getID());
 
@@ -307,7 +370,7 @@ setupFullConfs(const vector<hwlmLiteral> &lits,
             }
 
             DEBUG_PRINTF("b %d sz %zu\n", b, vl.size());
-            auto fc = getFDRConfirm(vl, make_small);
+            auto fc = getFDRConfirm(vl, make_small, grey);
             totalConfirmSize += fc.size();
             bc2Conf.emplace(b, move(fc));
         }
@@ -36,6 +36,67 @@
 #include "ue2common.h"
 #include "util/bitutils.h"
 #include "util/compare.h"
+#include "util/simd_utils.h"
+
+// Deliver the candidate li, whose v/msk have already been checked against
+// conf_key, if the rest of the confirm checks pass.
+static really_inline
+void confLitInfo(const struct LitInfo *li, const struct FDR_Runtime_Args *a,
+                 size_t i, hwlmcb_rv_t *control, u32 *last_match) {
+    if ((*last_match == li->id) && (li->flags & FDR_LIT_FLAG_NOREPEAT)) {
+        return;
+    }
+
+    const u8 *loc = a->buf + i - li->size + 1;
+
+    if (loc < a->buf) {
+        u32 full_overhang = a->buf - loc;
+        size_t len_history = a->len_history;
+
+        // can't do a vectored confirm either if we don't have
+        // the bytes
+        if (full_overhang > len_history) {
+            return;
+        }
+    }
+    assert(li->size <= sizeof(CONF_TYPE));
+
+    if (unlikely(!(li->groups & *control))) {
+        return;
+    }
+
+    *last_match = li->id;
+    *control = a->cb(i, li->id, a->scratch);
+}
+
+// Check all the candidates in a block, FDRC_BLOCK_LANES at a time.
+static really_inline
+void confLitBlock(const struct LitBlock *lb, const struct FDR_Runtime_Args *a,
+                  size_t i, hwlmcb_rv_t *control, u32 *last_match,
+                  u64a conf_key) {
+    const u32 count = lb->count;
+    const u32 padded = ROUNDUP_N(count, FDRC_BLOCK_LANES);
+    const CONF_TYPE *vals = (const CONF_TYPE *)(lb + 1);
+    const CONF_TYPE *msks = vals + padded;
+    const struct LitInfo *li = (const struct LitInfo *)(msks + padded);
+    assert(ISALIGNED(li));
+
+    const m256 key = set64x4(conf_key, conf_key, conf_key, conf_key);
+    for (u32 base = 0; base < count; base += FDRC_BLOCK_LANES) {
+        m256 v = loadu256(vals + base);
+        m256 m = loadu256(msks + base);
+        // one bit per 64-bit lane, at even positions
+        u32 hits = ~diffrich64_256(and256(key, m), v) & 0x55;
+        u32 remaining = count - base;
+        if (remaining < FDRC_BLOCK_LANES) {
+            hits &= (1U << (2 * remaining)) - 1;
+        }
+        while (hits) {
+            u32 lane = findAndClearLSB_32(&hits) / 2;
+            confLitInfo(li + base + lane, a, i, control, last_match);
+        }
+    }
+}
 
 // this is ordinary confirmation function which runs through
 // the whole confirmation procedure
@@ -47,7 +108,6 @@ void confWithBit(const struct FDRConfirm *fdrc, const struct FDR_Runtime_Args *a
     assert(i >= a->start_offset);
     assert(ISALIGNED(fdrc));
 
-    const u8 * buf = a->buf;
     u32 c = CONF_HASH_CALL(conf_key, fdrc->andmsk, fdrc->mult,
                            fdrc->nBits);
     u32 start = getConfirmLitIndex(fdrc)[c];
@@ -55,49 +115,38 @@ void confWithBit(const struct FDRConfirm *fdrc, const struct FDR_Runtime_Args *a
         return;
     }
 
-    const struct LitInfo *li
-        = (const struct LitInfo *)((const u8 *)fdrc + start);
-
     struct hs_scratch *scratch = a->scratch;
     assert(!scratch->fdr_conf);
     scratch->fdr_conf = conf;
     scratch->fdr_conf_offset = bit;
-    u8 oldNext; // initialized in loop
-    do {
-        assert(ISALIGNED(li));
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_CONFIRM, 0);
+    PROFILE_START(scratch);
 
-        if (unlikely((conf_key & li->msk) != li->v)) {
-            goto out;
-        }
-
-        if ((*last_match == li->id) && (li->flags & FDR_LIT_FLAG_NOREPEAT)) {
-            goto out;
-        }
-
-        const u8 *loc = buf + i - li->size + 1;
+    if (start & FDRC_LIT_INDEX_BLOCK) {
+        const struct LitBlock *lb = (const struct LitBlock *)
+            ((const u8 *)fdrc + (start & ~FDRC_LIT_INDEX_BLOCK));
+        assert(ISALIGNED(lb));
+        confLitBlock(lb, a, i, control, last_match, conf_key);
+    } else {
+        const struct LitInfo *li
+            = (const struct LitInfo *)((const u8 *)fdrc + start);
 
-        if (loc < buf) {
-            u32 full_overhang = buf - loc;
-            size_t len_history = a->len_history;
+        u8 oldNext; // initialized in loop
+        do {
+            assert(ISALIGNED(li));
 
-            // can't do a vectored confirm either if we don't have
-            // the bytes
-            if (full_overhang > len_history) {
+            if (unlikely((conf_key & li->msk) != li->v)) {
                 goto out;
             }
-        }
-        assert(li->size <= sizeof(CONF_TYPE));
 
-        if (unlikely(!(li->groups & *control))) {
-            goto out;
-        }
+            confLitInfo(li, a, i, control, last_match);
+        out:
+            oldNext = li->next; // oldNext is either 0 or an 'adjust' value
+            li++;
+        } while (oldNext);
+    }
 
-        *last_match = li->id;
-        *control = a->cb(i, li->id, scratch);
-    out:
-        oldNext = li->next; // oldNext is either 0 or an 'adjust' value
-        li++;
-    } while (oldNext);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_CONFIRM);
     scratch->fdr_conf = NULL;
 }
 
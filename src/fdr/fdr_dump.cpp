@@ -67,8 +67,12 @@ void dumpLitIndex(const FDRConfirm *fdrc, FILE *f) {
     u32 lits_used = count_if(lit_index, lit_index + num_lits,
                              [](u32 idx) { return idx != 0; });
 
+    u32 blocks = count_if(lit_index, lit_index + num_lits,
+                          [](u32 idx) { return idx & FDRC_LIT_INDEX_BLOCK; });
+
     fprintf(f, "      load    %u/%u (%0.2f%%)\n", lits_used, num_lits,
             (double)lits_used / (double)(num_lits)*100);
+    fprintf(f, "      blocks  %u\n", blocks);
 }
 
 static
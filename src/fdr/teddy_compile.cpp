@@ -482,7 +482,8 @@ bytecode_ptr<FDR> TeddyCompiler::build() {
     size_t reinforcedMaskLen = RTABLE_SIZE * maskWidth;
 
     auto floodTable = setupFDRFloodControl(lits, eng, grey);
-    auto confirmTable = setupFullConfs(lits, eng, bucketToLits, make_small);
+    auto confirmTable = setupFullConfs(lits, eng, bucketToLits, make_small,
+                                       grey);
 
     // Note: we place each major structure here on a cacheline boundary.
     size_t size = ROUNDUP_CL(headerSize) + ROUNDUP_CL(maskLen) +
@@ -53,6 +53,7 @@ Grey::Grey(void) :
                    allowMcClellan(true),
                    allowSheng(true),
                    allowMcSheng(true),
+                   allowMcSheng64(true),
                    allowPuff(true),
                    allowLiteral(true),
                    allowViolet(true),
@@ -64,8 +65,11 @@ Grey::Grey(void) :
                    allowDecoratedLiteral(true),
                    allowApproximateMatching(true),
                    allowNoodle(true),
+                   allowDict(true),
+                   dictMinLiterals(100000),
                    fdrAllowTeddy(true),
                    fdrAllowFlood(true),
+                   fdrConfirmBlockMinChain(16), /* huge literal sets only */
                    violetAvoidSuffixes(true),
                    violetAvoidWeakInfixes(true),
                    violetDoubleCut(true),
@@ -80,6 +84,7 @@ Grey::Grey(void) :
                    mergeSuffixes(true), // suffix nfas inside rose
                    mergeOutfixes(true),
                    onlyOneOutfix(false),
+                   lockstepOutfixes(true),
                    allowShermanStates(true),
                    allowMcClellan8(true),
                    allowWideStates(true), // enable wide state for McClellan8
@@ -97,6 +102,7 @@ Grey::Grey(void) :
                    nfaForceSize(0),
                    maxHistoryAvailable(DEFAULT_MAX_HISTORY),
                    minHistoryAvailable(0), /* debugging only */
+                   adaptiveHistory(true),
                    maxAnchoredRegion(63), /* for rose's atable to run over */
                    minRoseLiteralLength(3),
                    minRoseNetflowLiteralLength(2),
@@ -141,6 +147,7 @@ Grey::Grey(void) :
                    smallWriteMaxPatterns(10000),
                    smallWriteMaxLiterals(10000),
                    smallWriteMergeBatchSize(20),
+                   tinyWriteLargestBuffer(40),
                    allowTamarama(true), // Tamarama engine
                    tamaChunkSize(100),
                    dumpFlags(0),
@@ -231,6 +238,7 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(allowMcClellan);
         G_UPDATE(allowSheng);
         G_UPDATE(allowMcSheng);
+        G_UPDATE(allowMcSheng64);
         G_UPDATE(allowPuff);
         G_UPDATE(allowLiteral);
         G_UPDATE(allowViolet);
@@ -241,9 +249,12 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(allowCastle);
         G_UPDATE(allowDecoratedLiteral);
         G_UPDATE(allowNoodle);
+        G_UPDATE(allowDict);
+        G_UPDATE(dictMinLiterals);
         G_UPDATE(allowApproximateMatching);
         G_UPDATE(fdrAllowTeddy);
         G_UPDATE(fdrAllowFlood);
+        G_UPDATE(fdrConfirmBlockMinChain);
         G_UPDATE(violetAvoidSuffixes);
         G_UPDATE(violetAvoidWeakInfixes);
         G_UPDATE(violetDoubleCut);
@@ -258,6 +269,7 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(mergeSuffixes);
         G_UPDATE(mergeOutfixes);
         G_UPDATE(onlyOneOutfix);
+        G_UPDATE(lockstepOutfixes);
         G_UPDATE(allowShermanStates);
         G_UPDATE(allowMcClellan8);
         G_UPDATE(allowWideStates);
@@ -275,6 +287,7 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(highlanderSquash);
         G_UPDATE(maxHistoryAvailable);
         G_UPDATE(minHistoryAvailable);
+        G_UPDATE(adaptiveHistory);
         G_UPDATE(maxAnchoredRegion);
         G_UPDATE(minRoseLiteralLength);
         G_UPDATE(minRoseNetflowLiteralLength);
@@ -314,6 +327,7 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(smallWriteMaxPatterns);
         G_UPDATE(smallWriteMaxLiterals);
         G_UPDATE(smallWriteMergeBatchSize);
+        G_UPDATE(tinyWriteLargestBuffer);
         G_UPDATE(allowTamarama);
         G_UPDATE(tamaChunkSize);
         G_UPDATE(limitPatternCount);
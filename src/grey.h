@@ -53,6 +53,7 @@ struct Grey {
     bool allowMcClellan;
     bool allowSheng;
     bool allowMcSheng;
+    bool allowMcSheng64;
     bool allowPuff;
     bool allowLiteral;
     bool allowViolet;
@@ -65,8 +66,11 @@ struct Grey {
     bool allowApproximateMatching;
 
     bool allowNoodle;
+    bool allowDict;
+    u32  dictMinLiterals; // smallest literal set for the dictionary matcher
     bool fdrAllowTeddy;
     bool fdrAllowFlood;
+    u32  fdrConfirmBlockMinChain; // 0 disables FDR confirm blocks
 
     u32  violetAvoidSuffixes; /* 0=never, 1=sometimes, 2=always */
     bool violetAvoidWeakInfixes;
@@ -84,6 +88,7 @@ struct Grey {
     bool mergeSuffixes;
     bool mergeOutfixes;
     bool onlyOneOutfix; // if > 1 outfix, fail compile
+    bool lockstepOutfixes; // run McClellan outfixes in lockstep in block mode
 
     bool allowShermanStates;
     bool allowMcClellan8;
@@ -106,6 +111,7 @@ struct Grey {
 
     u32 maxHistoryAvailable;
     u32 minHistoryAvailable;
+    bool adaptiveHistory; // streams keep only the history their state needs
     u32 maxAnchoredRegion;
     u32 minRoseLiteralLength;
     u32 minRoseNetflowLiteralLength;
@@ -160,6 +166,9 @@ struct Grey {
     u32 smallWriteMaxLiterals; // only try small writes if fewer literals
     u32 smallWriteMergeBatchSize; // number of DFAs to merge in a batch
 
+    // Streaming tiny writes
+    u32 tinyWriteLargestBuffer; // largest stream write that may skip rose
+
     // Tamarama engine
     bool allowTamarama;
     u32 tamaChunkSize; //!< max chunk size for exclusivity analysis in Tamarama
@@ -170,6 +170,114 @@ hs_error_t HS_CDECL hs_deserialize_database_at(const char *bytes,
                                                const size_t length,
                                                hs_database_t *db);
 
+/**
+ * Serialize a pattern database to a stream of bytes that can be used in place.
+ *
+ * Unlike the output of @ref hs_serialize_database(), these bytes can be used
+ * for scanning without being copied, using @ref
+ * hs_deserialize_database_mapped(). This allows a large database to be written
+ * to a file once and then memory-mapped read-only by many processes, which
+ * share the same pages of the file. The two serialized forms are not
+ * interchangeable.
+ *
+ * The allocator callback set by @ref hs_set_misc_allocator() (or @ref
+ * hs_set_allocator()) will be used by this function.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param bytes
+ *      On success, a pointer to an array of bytes will be returned here. The
+ *      caller is responsible for freeing this block.
+ *
+ * @param length
+ *      On success, the number of bytes in the generated byte array will be
+ *      returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if the byte array cannot be
+ *      allocated, other values may be returned if errors are detected.
+ */
+hs_error_t HS_CDECL hs_serialize_database_mappable(const hs_database_t *db,
+                                                   char **bytes,
+                                                   size_t *length);
+
+/**
+ * Flag for @ref hs_deserialize_database_mapped(): do not verify the checksum
+ * of the database bytecode.
+ *
+ * Checking the checksum reads every byte of the database. This flag allows a
+ * large database to be put to use immediately; the check may be performed
+ * later by calling @ref hs_deserialize_database_mapped() again without it.
+ */
+#define HS_MAPPED_SKIP_CRC      1
+
+/**
+ * Use a stream of bytes previously generated by @ref
+ * hs_serialize_database_mappable() as a pattern database, in place.
+ *
+ * The header, platform and (unless @ref HS_MAPPED_SKIP_CRC is given) checksum
+ * of the database are checked, but no memory is allocated and nothing is
+ * copied or written: the bytes may be in a read-only memory mapping of a
+ * file, and the returned database remains valid for as long as they do.
+ *
+ * @param bytes
+ *      A byte array generated by @ref hs_serialize_database_mappable(), which
+ *      must be 64-byte aligned. The start of a memory-mapped file is suitably
+ *      aligned.
+ *
+ * @param length
+ *      The length of the byte array generated by @ref
+ *      hs_serialize_database_mappable().
+ *
+ * @param flags
+ *      Zero, or @ref HS_MAPPED_SKIP_CRC.
+ *
+ * @param db
+ *      On success, a pointer to the database (which is at @p bytes) will be
+ *      returned here. This database can then be used for pattern matching. It
+ *      must not be passed to @ref hs_free_database().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_BAD_ALIGN if @p bytes is not
+ *      64-byte aligned, other values on failure.
+ */
+hs_error_t HS_CDECL hs_deserialize_database_mapped(const char *bytes,
+                                                   const size_t length,
+                                                   unsigned int flags,
+                                                   const hs_database_t **db);
+
+/**
+ * Copy a compiled pattern database to a given memory location.
+ *
+ * This function allows a database to be placed in memory chosen by the
+ * caller, such as a region backed by huge pages or one local to a particular
+ * NUMA node. Large databases can then be replicated once per node, with each
+ * copy used by the scratch regions of threads running on that node. Unlike
+ * round-tripping through @ref hs_serialize_database() and @ref
+ * hs_deserialize_database_at(), no intermediate buffer is allocated.
+ *
+ * The amount of space required at the destination can be determined with the
+ * @ref hs_database_size() function. Scratch space allocated for the original
+ * database may be used with the copy, and vice versa.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param dest
+ *      Pointer to an 8-byte aligned block of memory of sufficient size to hold
+ *      the database, which must not overlap @p db. On success, the copy will be
+ *      written to this location and may then be used for pattern matching. The
+ *      user is responsible for freeing this memory; the @ref
+ *      hs_free_database() call should not be used.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_BAD_ALIGN if @p dest is not
+ *      suitably aligned, other values on failure.
+ */
+hs_error_t HS_CDECL hs_clone_database_at(const hs_database_t *db,
+                                         hs_database_t *dest);
+
 /**
  * Provides the size of the stream state allocated by a single stream opened
  * against the given database.
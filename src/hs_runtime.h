@@ -65,6 +65,14 @@ struct hs_scratch;
  */
 typedef struct hs_scratch hs_scratch_t;
 
+struct hs_stream_pool;
+
+/**
+ * A pool of stream slots, created by @ref hs_alloc_stream_pool() or @ref
+ * hs_init_stream_pool_at().
+ */
+typedef struct hs_stream_pool hs_stream_pool_t;
+
 /**
  * Definition of the match event callback function type.
  *
@@ -190,6 +198,143 @@ hs_error_t HS_CDECL hs_scan_stream(hs_stream_t *id, const char *data,
                                    hs_scratch_t *scratch,
                                    match_event_handler onEvent, void *ctxt);
 
+/**
+ * Write data to be scanned to the opened stream, scanning no more than a
+ * given number of bytes before returning.
+ *
+ * This is a resumable form of @ref hs_scan_stream(), allowing a large write to
+ * be broken into bounded units of work, for example so that it can be run as
+ * a cooperative task on an event loop alongside other streams. At most @p
+ * budget bytes of @p data are scanned; the number of bytes scanned is returned
+ * in @p consumed. If this is less than @p length, the scan can be resumed
+ * later by calling this function (or @ref hs_scan_stream()) again with the
+ * remaining data, i.e. @p data + @p consumed. The scratch space is not
+ * required to be preserved between calls, and may be used for other scans in
+ * the meantime.
+ *
+ * The matches produced are identical to those produced by a single call to
+ * @ref hs_scan_stream() over the whole of @p data.
+ *
+ * If a match buffer with the @ref HS_MATCH_BUFFER_RESUME policy is attached
+ * to @p scratch (see @ref hs_set_match_buffer()), the write will also end
+ * early if the buffer fills, just before the end offset of the first match
+ * that did not fit. The caller should drain the buffer with @ref
+ * hs_drain_match_buffer() before resuming.
+ *
+ * @param id
+ *      The stream ID (returned by @ref hs_open_stream()) to which the data
+ *      will be written.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes available in @p data.
+ *
+ * @param budget
+ *      The maximum number of bytes to scan in this call. This must be
+ *      non-zero.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @param consumed
+ *      On return, the number of bytes of @p data that have been scanned.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop; @ref
+ *      HS_INSUFFICIENT_SPACE if an empty match buffer with the @ref
+ *      HS_MATCH_BUFFER_RESUME policy is too small to hold the matches at a
+ *      single offset; other values on error.
+ */
+hs_error_t HS_CDECL hs_scan_stream_partial(hs_stream_t *id, const char *data,
+                                           unsigned int length,
+                                           unsigned int budget,
+                                           unsigned int flags,
+                                           hs_scratch_t *scratch,
+                                           match_event_handler onEvent,
+                                           void *context,
+                                           unsigned int *consumed);
+
+/**
+ * Write data to be scanned to a set of streams.
+ *
+ * This function is equivalent to calling @ref hs_scan_stream() for each
+ * (stream, data block) pair in turn, but amortises the per-call overhead
+ * across the batch and prefetches the stream state and history of upcoming
+ * streams while the current stream is being scanned. It is intended for
+ * applications that service many concurrent flows with short writes, where
+ * fetching stream state dominates the cost of scanning.
+ *
+ * Each stream has its own context pointer, which is passed to the callback
+ * for matches in that stream. If the callback indicates that scanning should
+ * stop, only the corresponding stream is terminated (as with @ref
+ * hs_scan_stream()); scanning continues with the next stream in the batch.
+ *
+ * The streams may have been opened against different databases, provided that
+ * @p scratch has been allocated for all of them. A stream must not appear more
+ * than once in a batch.
+ *
+ * @param ids
+ *      An array of stream identifiers returned from @ref hs_open_stream().
+ *
+ * @param data
+ *      An array of pointers to the data blocks to be scanned, one per stream.
+ *
+ * @param length
+ *      An array of lengths (in bytes) of each data block to scan.
+ *
+ * @param context
+ *      An array of user defined pointers, one per stream, which will be passed
+ *      to the callback function for matches in the corresponding stream. NULL
+ *      may be provided, in which case a NULL context will be passed to the
+ *      callback for every stream.
+ *
+ * @param count
+ *      Number of (stream, data block) pairs to scan. This should correspond to
+ *      the size of the @p ids, @p data, @p length and (if non-NULL) @p context
+ *      arrays.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for the
+ *      databases the streams were opened against.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the match
+ *      callback indicated that scanning should stop for one or more of the
+ *      streams; other values on error. If an error other than @ref
+ *      HS_SCAN_TERMINATED is returned, streams later in the batch may not have
+ *      been scanned.
+ */
+hs_error_t HS_CDECL hs_scan_stream_batch(hs_stream_t *const *ids,
+                                         const char *const *data,
+                                         const unsigned int *length,
+                                         void *const *context,
+                                         unsigned int count, unsigned int flags,
+                                         hs_scratch_t *scratch,
+                                         match_event_handler onEvent);
+
 /**
  * Close a stream.
  *
@@ -366,8 +511,49 @@ hs_error_t HS_CDECL hs_compress_stream(const hs_stream_t *stream, char *buf,
                                        size_t buf_space, size_t *used_space);
 
 /**
- * Decompresses a compressed representation created by @ref hs_compress_stream()
- * into a new stream.
+ * Creates a dense compressed representation of the provided stream in the
+ * buffer provided.
+ *
+ * This behaves as @ref hs_compress_stream(), but codes the stream state more
+ * tightly: runs of zero bytes are elided, state that is unchanged since the
+ * stream was opened takes almost no space, and streams that can no longer
+ * produce matches (because matching was terminated or every pattern is
+ * exhausted) are reduced to their offset and status. Compression and
+ * expansion do more work than for @ref hs_compress_stream(), so this form is
+ * intended for streams that are not expected to be used soon.
+ *
+ * The dense representation is expanded with @ref hs_expand_stream() or @ref
+ * hs_reset_and_expand_stream(), which recognise it automatically.
+ *
+ * @param stream
+ *      The stream (as created by @ref hs_open_stream()) to be compressed.
+ *
+ * @param buf
+ *      Buffer to write the compressed representation into. Note: if the call is
+ *      just being used to determine the amount of space required, it is allowed
+ *      to pass NULL here and @p buf_space as 0.
+ *
+ * @param buf_space
+ *      The number of bytes in @p buf. If buf_space is too small, the call will
+ *      fail with @ref HS_INSUFFICIENT_SPACE.
+ *
+ * @param used_space
+ *      Pointer to where the amount of used space will be written to. If the
+ *      call fails with @ref HS_INSUFFICIENT_SPACE, this pointer will be used to
+ *      write out the amount of buffer space required.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INSUFFICIENT_SPACE if the provided
+ *      buffer is too small.
+ */
+hs_error_t HS_CDECL hs_compress_stream_dense(const hs_stream_t *stream,
+                                             char *buf, size_t buf_space,
+                                             size_t *used_space);
+
+/**
+ * Decompresses a compressed representation created by @ref
+ * hs_compress_stream(), @ref hs_compress_stream_dense() or @ref
+ * hs_hibernate_stream() into a new stream.
  *
  * Note: @p buf must correspond to a complete compressed representation created
  * by @ref hs_compress_stream() of a stream that was opened against @p db. It is
@@ -441,6 +627,353 @@ hs_error_t HS_CDECL hs_reset_and_expand_stream(hs_stream_t *to_stream,
                                                match_event_handler onEvent,
                                                void *context);
 
+/**
+ * Creates a hibernated representation of the provided stream in the buffer
+ * provided, for streams that are expected to stay idle for some time.
+ *
+ * The hibernated representation is the dense form written by @ref
+ * hs_compress_stream_dense(), except that the stream's history (the trailing
+ * bytes of the data scanned so far that later matches may depend on) is kept
+ * uncoded at the end of the buffer. @ref hs_wake_stream() can then scan the
+ * next write against the history where it lies in the buffer, instead of
+ * restoring it into the stream first. Hibernated representations may also be
+ * expanded with @ref hs_expand_stream() or @ref hs_reset_and_expand_stream().
+ *
+ * Note: this function does not close the provided stream, you may continue to
+ * use the stream or to free it with @ref hs_close_stream().
+ *
+ * @param stream
+ *      The stream (as created by @ref hs_open_stream()) to be hibernated.
+ *
+ * @param buf
+ *      Buffer to write the hibernated representation into. Note: if the call
+ *      is just being used to determine the amount of space required, it is
+ *      allowed to pass NULL here and @p buf_space as 0.
+ *
+ * @param buf_space
+ *      The number of bytes in @p buf. If buf_space is too small, the call will
+ *      fail with @ref HS_INSUFFICIENT_SPACE.
+ *
+ * @param used_space
+ *      Pointer to where the amount of used space will be written to. If the
+ *      call fails with @ref HS_INSUFFICIENT_SPACE, this pointer will be used to
+ *      write out the amount of buffer space required.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INSUFFICIENT_SPACE if the provided
+ *      buffer is too small.
+ */
+hs_error_t HS_CDECL hs_hibernate_stream(const hs_stream_t *stream, char *buf,
+                                        size_t buf_space, size_t *used_space);
+
+/**
+ * Wakes a stream from its compressed representation and scans the next write
+ * to it, as @ref hs_expand_stream() followed by @ref hs_scan_stream().
+ *
+ * Only the state of the engines that were active when the stream was
+ * compressed is restored. If @p buf was created by @ref hs_hibernate_stream()
+ * and the write is at least as long as the history the database keeps, the
+ * history is read directly from @p buf and never copied into the stream, as
+ * the write replaces it. Representations created by @ref hs_compress_stream()
+ * and @ref hs_compress_stream_dense() are also accepted.
+ *
+ * Note: @p buf must correspond to a complete compressed representation of a
+ * stream that was opened against @p db. It is not always possible to detect
+ * misuse of this API and behaviour is undefined if these properties are not
+ * satisfied.
+ *
+ * @param db
+ *      The compiled pattern database that the compressed stream was opened
+ *      against.
+ *
+ * @param buf
+ *      A compressed representation of a stream.
+ *
+ * @param buf_size
+ *      The size in bytes of the compressed representation.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch().
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @param stream
+ *      On return, a pointer to the woken @ref hs_stream_t, which must be
+ *      closed as usual, even if the scan itself returned an error; NULL if
+ *      the stream could not be woken.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop; other values on
+ *      error.
+ */
+hs_error_t HS_CDECL hs_wake_stream(const hs_database_t *db, const char *buf,
+                                   size_t buf_size, const char *data,
+                                   unsigned int length, unsigned int flags,
+                                   hs_scratch_t *scratch,
+                                   match_event_handler onEvent, void *context,
+                                   hs_stream_t **stream);
+
+/**
+ * Provides the size of the memory needed by @ref hs_init_stream_pool_at() to
+ * hold a stream pool of the given capacity for the given database.
+ *
+ * @param db
+ *      A streaming mode pattern database.
+ *
+ * @param capacity
+ *      The number of streams the pool can hold at once; must be non-zero.
+ *
+ * @param pool_size
+ *      On success, the size in bytes of the pool is placed in this parameter.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t HS_CDECL hs_stream_pool_size(const hs_database_t *db,
+                                        unsigned int capacity,
+                                        size_t *pool_size);
+
+/**
+ * Allocate a stream pool.
+ *
+ * A stream pool holds up to @p capacity streams for one database in a single
+ * region of memory, divided into fixed-size slots. Streams opened in a pool
+ * with @ref hs_pool_open_stream() need no allocation of their own, and
+ * closing them with @ref hs_pool_close_stream() returns their slot to the
+ * pool for reuse; both are constant-time operations. Applications that keep
+ * very many streams open can use a pool to avoid the per-stream overhead and
+ * fragmentation of the general purpose allocator.
+ *
+ * The pool is allocated in one piece with the stream allocator (see @ref
+ * hs_set_stream_allocator()), so an allocator returning memory backed by huge
+ * pages can be used to reduce TLB pressure. Alternatively, @ref
+ * hs_init_stream_pool_at() places a pool in memory chosen by the caller.
+ *
+ * A stream pool is not thread-safe: like a scratch space, it should only be
+ * used by one thread at a time. Applications scanning on several threads
+ * should give each thread its own pool.
+ *
+ * @param db
+ *      A streaming mode pattern database. It must remain valid for the
+ *      lifetime of the pool.
+ *
+ * @param capacity
+ *      The number of streams the pool can hold at once; must be non-zero.
+ *
+ * @param pool
+ *      On success, a pointer to the new pool is returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t HS_CDECL hs_alloc_stream_pool(const hs_database_t *db,
+                                         unsigned int capacity,
+                                         hs_stream_pool_t **pool);
+
+/**
+ * Create a stream pool in memory provided by the caller.
+ *
+ * This is equivalent to @ref hs_alloc_stream_pool(), but the pool is placed
+ * in a block of memory of at least the size given by @ref
+ * hs_stream_pool_size(), such as a region backed by huge pages or one local
+ * to the NUMA node of the thread that will use it.
+ *
+ * @param db
+ *      A streaming mode pattern database. It must remain valid for the
+ *      lifetime of the pool.
+ *
+ * @param capacity
+ *      The number of streams the pool can hold at once; must be non-zero.
+ *
+ * @param mem
+ *      Pointer to a 64-byte aligned block of memory of sufficient size. The
+ *      user is responsible for freeing this memory once the pool is no longer
+ *      in use.
+ *
+ * @param pool
+ *      On success, a pointer to the new pool is returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_BAD_ALIGN if @p mem is not
+ *      suitably aligned, other values on failure.
+ */
+hs_error_t HS_CDECL hs_init_stream_pool_at(const hs_database_t *db,
+                                           unsigned int capacity, void *mem,
+                                           hs_stream_pool_t **pool);
+
+/**
+ * Free a stream pool.
+ *
+ * Any streams still open in the pool are discarded without raising end of
+ * stream matches. For a pool created with @ref hs_init_stream_pool_at(), the
+ * pool is invalidated but its memory is left for the user to free.
+ *
+ * @param pool
+ *      The pool to be freed. NULL may also be safely provided.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t HS_CDECL hs_free_stream_pool(hs_stream_pool_t *pool);
+
+/**
+ * Open and initialise a stream in a free slot of a stream pool.
+ *
+ * The stream may be used with all stream functions that operate on an
+ * existing stream, such as @ref hs_scan_stream(), @ref hs_reset_stream() and
+ * @ref hs_compress_stream(). It must be closed with @ref
+ * hs_pool_close_stream() rather than @ref hs_close_stream().
+ *
+ * @param pool
+ *      A stream pool.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param stream
+ *      On success, a pointer to the new stream is returned here; NULL on
+ *      failure.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if every slot in the pool is
+ *      in use, other values on failure.
+ */
+hs_error_t HS_CDECL hs_pool_open_stream(hs_stream_pool_t *pool,
+                                        unsigned int flags,
+                                        hs_stream_t **stream);
+
+/**
+ * Close a stream opened with @ref hs_pool_open_stream(), returning its slot
+ * to the pool.
+ *
+ * This behaves as @ref hs_close_stream(), including the raising of matches
+ * at the end of the stream.
+ *
+ * @param pool
+ *      The stream pool that the stream was opened in.
+ *
+ * @param id
+ *      The stream to close.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch(). This is
+ *      allowed to be NULL only if the @p onEvent callback is also NULL.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INVALID if @p id is not an open
+ *      stream in @p pool, other values on failure.
+ */
+hs_error_t HS_CDECL hs_pool_close_stream(hs_stream_pool_t *pool,
+                                         hs_stream_t *id, hs_scratch_t *scratch,
+                                         match_event_handler onEvent,
+                                         void *context);
+
+/**
+ * Definition of the callback type used by @ref hs_iterate_stream_pool().
+ *
+ * @param id
+ *      An open stream in the pool.
+ *
+ * @param context
+ *      The pointer supplied by the user to @ref hs_iterate_stream_pool().
+ *
+ * @return
+ *      Non-zero if the iteration should stop, else zero.
+ */
+typedef int (HS_CDECL *hs_stream_visitor_t)(hs_stream_t *id, void *context);
+
+/**
+ * Call a function for each open stream in a stream pool, in the order that
+ * the streams lie in memory.
+ *
+ * The callback must not open or close streams in the pool.
+ *
+ * @param pool
+ *      A stream pool.
+ *
+ * @param visit
+ *      The function to call for each open stream.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t HS_CDECL hs_iterate_stream_pool(hs_stream_pool_t *pool,
+                                           hs_stream_visitor_t visit,
+                                           void *context);
+
+/**
+ * Definition of the callback type used by @ref hs_compact_stream_pool().
+ *
+ * @param from
+ *      The stream's handle before it was moved; this is no longer valid.
+ *
+ * @param to
+ *      The stream's new handle, which replaces @p from for all purposes.
+ *
+ * @param context
+ *      The pointer supplied by the user to @ref hs_compact_stream_pool().
+ */
+typedef void (HS_CDECL *hs_stream_relocate_t)(hs_stream_t *from,
+                                              hs_stream_t *to, void *context);
+
+/**
+ * Move the open streams in a stream pool into its lowest slots.
+ *
+ * After many streams have been opened and closed, the open streams in a pool
+ * may be scattered across its slots. Compaction packs them together at the
+ * start of the pool, so that they occupy as few pages as possible, and
+ * arranges for new streams to be opened in the slots directly after them.
+ *
+ * Each stream that is moved is reported to @p relocate, which should update
+ * any references the application holds to it.
+ *
+ * @param pool
+ *      A stream pool.
+ *
+ * @param relocate
+ *      The function to call for each stream that is moved. This may only be
+ *      NULL if the application locates its streams with @ref
+ *      hs_iterate_stream_pool().
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t HS_CDECL hs_compact_stream_pool(hs_stream_pool_t *pool,
+                                           hs_stream_relocate_t relocate,
+                                           void *context);
+
 /**
  * The block (non-streaming) regular expression scanner.
  *
@@ -526,6 +1059,65 @@ hs_error_t HS_CDECL hs_scan_vector(const hs_database_t *db,
                                    hs_scratch_t *scratch,
                                    match_event_handler onEvent, void *context);
 
+/**
+ * The batched block mode regular expression scanner.
+ *
+ * This function scans a set of independent data blocks against a block-mode
+ * pattern database, producing the same matches as a call to @ref hs_scan()
+ * for each block in turn. Validation of the database and scratch space, and
+ * other per-call setup, is performed once for the whole batch, and upcoming
+ * blocks are prefetched while the current one is being scanned. This makes
+ * the function suitable for scanning large numbers of small, unrelated
+ * buffers such as network packets.
+ *
+ * Each block is scanned from offset zero and has its own context pointer,
+ * which is passed to the callback for matches in that block. If the callback
+ * indicates that scanning should stop, the scan of the current block ceases
+ * and scanning continues with the next block in the batch.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      An array of pointers to the data blocks to be scanned.
+ *
+ * @param length
+ *      An array of lengths (in bytes) of each data block to scan.
+ *
+ * @param context
+ *      An array of user defined pointers, one per data block, which will be
+ *      passed to the callback function for matches in the corresponding block.
+ *      NULL may be provided, in which case a NULL context will be passed to
+ *      the callback for every block.
+ *
+ * @param count
+ *      Number of data blocks to scan. This should correspond to the size of
+ *      the @p data, @p length and (if non-NULL) @p context arrays.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for
+ *      this database.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the match
+ *      callback indicated that scanning should stop for one or more of the
+ *      blocks; other values on error.
+ */
+hs_error_t HS_CDECL hs_scan_batch(const hs_database_t *db,
+                                  const char *const *data,
+                                  const unsigned int *length,
+                                  void *const *context, unsigned int count,
+                                  unsigned int flags, hs_scratch_t *scratch,
+                                  match_event_handler onEvent);
+
 /**
  * Allocate a "scratch" space for use by Hyperscan.
  *
@@ -608,6 +1200,283 @@ hs_error_t HS_CDECL hs_scratch_size(const hs_scratch_t *scratch,
  */
 hs_error_t HS_CDECL hs_free_scratch(hs_scratch_t *scratch);
 
+/**
+ * A match, as stored in a match buffer attached to a scratch space with @ref
+ * hs_set_match_buffer(). The fields have the same meanings as the
+ * corresponding parameters of @ref match_event_handler.
+ */
+typedef struct hs_match {
+    /** The ID number of the expression that matched. */
+    unsigned int id;
+
+    /** Match flags; provided for future use and zero at present. */
+    unsigned int flags;
+
+    /** The start of match offset, if requested for this expression. */
+    unsigned long long from;
+
+    /** The offset after the last byte that matches the expression. */
+    unsigned long long to;
+} hs_match_t;
+
+/**
+ * @defgroup HS_MATCH_BUFFER_POLICY Match buffer overflow policies
+ *
+ * What to do when a match is raised and the match buffer attached with @ref
+ * hs_set_match_buffer() is full.
+ *
+ * @{
+ */
+
+/**
+ * Stop scanning, as if a match callback had returned non-zero: the scan call
+ * returns @ref HS_SCAN_TERMINATED and, in streaming mode, the stream will
+ * produce no further matches. The match that did not fit is counted as
+ * dropped.
+ */
+#define HS_MATCH_BUFFER_STOP    0
+
+/**
+ * Discard the match and continue scanning. Discarded matches are counted and
+ * the count can be retrieved with @ref hs_drain_match_buffer().
+ */
+#define HS_MATCH_BUFFER_DROP    1
+
+/**
+ * Return to the caller so that the buffer can be drained, leaving the scan in
+ * a state from which it can be resumed. This is only supported by @ref
+ * hs_scan_stream_partial(), which will end its write just before the first
+ * match that did not fit; no matches are lost and none are stored twice. All
+ * other scan calls treat this policy as @ref HS_MATCH_BUFFER_STOP.
+ */
+#define HS_MATCH_BUFFER_RESUME  2
+
+/** @} */
+
+/**
+ * Attach a match buffer to a scratch space.
+ *
+ * While a match buffer is attached, all matches raised by scan calls using
+ * this scratch space are stored in the buffer instead of being passed to a
+ * match callback. This avoids an indirect function call per match and allows
+ * matches to be processed in bulk once the scan call returns. The @p onEvent
+ * and @p context arguments of scan calls are ignored, except that calls which
+ * only raise matches at the end of a stream (such as @ref hs_close_stream())
+ * will do so if either a match buffer is attached or @p onEvent is non-NULL.
+ *
+ * Matches accumulate in the buffer across scan calls until @ref
+ * hs_drain_match_buffer() is called. The buffer is not copied by @ref
+ * hs_clone_scratch(); it is retained if the scratch space is reallocated by
+ * @ref hs_alloc_scratch().
+ *
+ * @param scratch
+ *      A scratch space allocated by @ref hs_alloc_scratch() or @ref
+ *      hs_clone_scratch(). It must not be in use by a scan call.
+ *
+ * @param matches
+ *      An array of @p capacity match records, which must remain valid while
+ *      it is attached. NULL may be provided to detach the current buffer and
+ *      return to callback delivery.
+ *
+ * @param capacity
+ *      The number of entries in @p matches.
+ *
+ * @param policy
+ *      What to do when a match is raised and the buffer is full: one of @ref
+ *      HS_MATCH_BUFFER_STOP, @ref HS_MATCH_BUFFER_DROP or @ref
+ *      HS_MATCH_BUFFER_RESUME.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_SCRATCH_IN_USE if the scratch space
+ *      is in use; other values on failure.
+ */
+hs_error_t HS_CDECL hs_set_match_buffer(hs_scratch_t *scratch,
+                                        hs_match_t *matches,
+                                        unsigned int capacity,
+                                        unsigned int policy);
+
+/**
+ * Retrieve the number of matches stored in the match buffer attached to a
+ * scratch space, and empty it.
+ *
+ * The first @p count entries of the buffer passed to @ref
+ * hs_set_match_buffer() hold the matches raised since the last call to this
+ * function, in the order they were raised. They remain valid until the next
+ * scan call using this scratch space.
+ *
+ * @param scratch
+ *      A scratch space with a match buffer attached by @ref
+ *      hs_set_match_buffer().
+ *
+ * @param count
+ *      On success, the number of matches in the buffer is placed in this
+ *      parameter.
+ *
+ * @param dropped
+ *      On success, the number of matches that were discarded because the
+ *      buffer was full is placed in this parameter. NULL may be provided if
+ *      this is not required.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_SCRATCH_IN_USE if the scratch space
+ *      is in use; other values on failure.
+ */
+hs_error_t HS_CDECL hs_drain_match_buffer(hs_scratch_t *scratch,
+                                          unsigned int *count,
+                                          unsigned long long *dropped);
+
+/**
+ * A runtime profiling counter, as returned by @ref hs_scratch_stats().
+ */
+typedef struct hs_stats_entry {
+    /** The kind of counter; one of the @ref HS_STATS_TYPE values. */
+    unsigned int type;
+
+    /**
+     * The engine, queue, program or expression this counter belongs to. The
+     * meaning depends on @a type, and @ref HS_STATS_KEY_LOST is used for
+     * events that could not be attributed.
+     */
+    unsigned int key;
+
+    /** The number of events counted. */
+    unsigned long long count;
+
+    /** The number of bytes scanned, for engine and queue counters. */
+    unsigned long long bytes;
+
+    /**
+     * The time stamp counter cycles spent in this engine, queue or program,
+     * excluding time spent in other timed work started from it, so that the
+     * cycles of these counters add up to no more than the time spent
+     * scanning.
+     *
+     * For report counters, this is instead the cycles of the literal
+     * programs, queue runs and programs whose first match was for this
+     * expression, which gives an estimate of the cost of each pattern.
+     */
+    unsigned long long cycles;
+} hs_stats_entry_t;
+
+/**
+ * @defgroup HS_STATS_TYPE Runtime profiling counter types
+ *
+ * @{
+ */
+
+/**
+ * Work done by one of the fixed parts of the runtime, such as the literal
+ * matchers, keyed by an @ref HS_STATS_ENGINE value.
+ */
+#define HS_STATS_ENGINE     0
+
+/**
+ * Runs of an engine queue, keyed by queue index. Queue indices are shown in
+ * the output of the `hsdump` tool.
+ */
+#define HS_STATS_QUEUE      1
+
+/** Literal matches, keyed by the offset of the literal's Rose program. */
+#define HS_STATS_LITERAL    2
+
+/** Rose program invocations, keyed by program offset. */
+#define HS_STATS_PROGRAM    3
+
+/** Matches delivered to the user, keyed by expression ID. */
+#define HS_STATS_REPORT     4
+
+/** Key for events that could not be given their own counter. */
+#define HS_STATS_KEY_LOST   0xffffffffU
+
+/** @} */
+
+/**
+ * @defgroup HS_STATS_ENGINE Runtime profiling engine keys
+ *
+ * @{
+ */
+
+/** The anchored literal matcher. */
+#define HS_STATS_ENGINE_ANCHORED        0
+
+/** The floating literal matcher. */
+#define HS_STATS_ENGINE_FLOATING        1
+
+/** The EOD-anchored literal matcher. */
+#define HS_STATS_ENGINE_EOD             2
+
+/** The literal matcher used for small blocks. */
+#define HS_STATS_ENGINE_SMALL_BLOCK     3
+
+/** The delayed literal rebuild matcher used at the start of stream writes. */
+#define HS_STATS_ENGINE_DELAY_REBUILD   4
+
+/** The small write engine. */
+#define HS_STATS_ENGINE_SMALL_WRITE     5
+
+/** Catching up engine queues before a match is reported. */
+#define HS_STATS_ENGINE_CATCHUP         6
+
+/** Confirmation of candidate matches from the FDR and Teddy matchers. */
+#define HS_STATS_ENGINE_CONFIRM         7
+
+/** Calls to the user's match callback. */
+#define HS_STATS_ENGINE_CALLBACK        8
+
+/** @} */
+
+/**
+ * Retrieve the runtime profiling counters gathered in a scratch space.
+ *
+ * Counters are only kept if the library was built with the
+ * `RUNTIME_PROFILING` CMake option; this instrumentation has a cost and is
+ * intended for investigating performance problems, not for production use.
+ *
+ * Counters accumulate over all scan calls made with the scratch space, until
+ * reset with @ref hs_reset_scratch_stats(). They are also reset if the
+ * scratch space is reallocated by @ref hs_alloc_scratch(). Counters from
+ * different databases are not kept apart, so a scratch space should only be
+ * used with one database while profiling.
+ *
+ * Only non-zero counters are returned, in no particular order.
+ *
+ * @param scratch
+ *      A scratch space that has been used for scanning.
+ *
+ * @param entries
+ *      An array in which to place the counters. NULL may be provided if @p
+ *      capacity is zero.
+ *
+ * @param capacity
+ *      The number of entries in @p entries.
+ *
+ * @param count
+ *      On success, the number of counters placed in @p entries. If @ref
+ *      HS_INSUFFICIENT_SPACE is returned, the number of entries required.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INSUFFICIENT_SPACE if @p capacity
+ *      is too small; @ref HS_INVALID if the library was built without
+ *      runtime profiling or the parameters are invalid.
+ */
+hs_error_t HS_CDECL hs_scratch_stats(const hs_scratch_t *scratch,
+                                     hs_stats_entry_t *entries,
+                                     unsigned int capacity,
+                                     unsigned int *count);
+
+/**
+ * Reset the runtime profiling counters in a scratch space to zero.
+ *
+ * @param scratch
+ *      A scratch space allocated by @ref hs_alloc_scratch() or @ref
+ *      hs_clone_scratch().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without runtime profiling or the parameters are invalid.
+ */
+hs_error_t HS_CDECL hs_reset_scratch_stats(hs_scratch_t *scratch);
+
 /**
  * Callback 'from' return value, indicating that the start of this match was
  * too early to be tracked with the requested SOM_HORIZON precision.
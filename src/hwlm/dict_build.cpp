@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Dictionary literal matcher: build code.
+ */
+
+#include "dict_build.h"
+
+#include "dict_internal.h"
+#include "hwlm_literal.h"
+#include "util/bitutils.h"
+#include "util/compare.h"
+#include "util/verify_types.h"
+#include "ue2common.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace ue2 {
+
+/** \brief Smallest bloom filter we will build, as log2 of its size in bits. */
+static const u32 DICT_MIN_BLOOM_BITS = 10;
+
+/** \brief Largest bloom filter we will build, as log2 of its size in bits. */
+static const u32 DICT_MAX_BLOOM_BITS = 30;
+
+// odd multipliers for the per-class hashes
+static const u64a DICT_MULTS[DICT_MAX_CLASSES][2] = {
+    {0x0b4e0ef37bc32127ULL, 0x9e3779b97f4a7c15ULL},
+    {0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL},
+    {0x85ebca77c2b2ae63ULL, 0x27d4eb2f165667c5ULL},
+    {0xff51afd7ed558ccdULL, 0xc4ceb9fe1a85ec53ULL},
+    {0x94d049bb133111ebULL, 0xbf58476d1ce4e5b9ULL},
+    {0xd6e8feb86659fd93ULL, 0xa0761d6478bd642fULL},
+    {0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL},
+    {0x589965cc75374cc3ULL, 0x1d8e4e27c47d124fULL},
+};
+
+/**
+ * Compute the value and mask of the last eight bytes of a literal, laid out
+ * as they would be loaded from the data on a little-endian machine with the
+ * last byte of the literal in the most significant position.
+ */
+static
+void makeValMask(const hwlmLiteral &lit, u64a &v, u64a &msk) {
+    v = 0;
+    msk = 0;
+
+    const auto &s = lit.s;
+    for (u32 j = 0; j < sizeof(u64a) && j < s.size(); j++) {
+        u32 shiftLoc = (sizeof(u64a) - j - 1) * 8;
+        u8 c = s[s.size() - j - 1];
+        u8 m = lit.nocase && ourisalpha(c) ? (u8)CASE_CLEAR : (u8)0xff;
+        msk |= (u64a)m << shiftLoc;
+        v |= (u64a)(c & m) << shiftLoc;
+    }
+
+    // incorporate lit.msk, lit.cmp, which are aligned to the end of the
+    // literal
+    assert(lit.msk.size() == lit.cmp.size());
+    assert(lit.msk.size() <= sizeof(u64a));
+    for (size_t j = 0; j < lit.msk.size(); j++) {
+        size_t idx = lit.msk.size() - j - 1;
+        u32 shiftLoc = (sizeof(u64a) - j - 1) * 8;
+        msk |= (u64a)lit.msk[idx] << shiftLoc;
+        v |= (u64a)(lit.cmp[idx] & lit.msk[idx]) << shiftLoc;
+    }
+}
+
+static
+u64a topBytesMask(u32 len) {
+    assert(len && len <= 8);
+    return len == 8 ? ~0ULL : ~((~0ULL) >> (8 * len));
+}
+
+static
+void setBloomBit(u64a *bloom, u32 h) {
+    bloom[h >> 6] |= 1ULL << (h & 63);
+}
+
+bytecode_ptr<dictTable> dictBuildTable(const vector<hwlmLiteral> &lits) {
+    assert(!lits.empty());
+
+    // One class per distinct key length, sorted by length.
+    map<u32, u32> lenToClass;
+    for (const auto &lit : lits) {
+        assert(!lit.s.empty());
+        lenToClass[min(verify_u32(lit.s.size()), 8U)] = 0;
+    }
+    if (lenToClass.size() > DICT_MAX_CLASSES) {
+        assert(0);
+        return nullptr;
+    }
+
+    const u32 n = verify_u32(lits.size());
+    const u32 bloomBits = max(DICT_MIN_BLOOM_BITS,
+                              min(DICT_MAX_BLOOM_BITS, lg2(n) + 5));
+    const u32 tableBits = min(bloomBits, lg2(n) + 2);
+    DEBUG_PRINTF("%u lits, bloomBits %u tableBits %u\n", n, bloomBits,
+                 tableBits);
+
+    dictClass classes[DICT_MAX_CLASSES];
+    memset(classes, 0, sizeof(classes));
+    u32 numClasses = 0;
+    for (auto &m : lenToClass) {
+        dictClass &dc = classes[numClasses];
+        dc.len = verify_u8(m.first);
+        dc.shift = verify_u8(64 - 8 * m.first);
+        dc.andmsk = topBytesMask(m.first);
+        dc.mult1 = DICT_MULTS[numClasses][0];
+        dc.mult2 = DICT_MULTS[numClasses][1];
+        m.second = numClasses++;
+    }
+
+    vector<dictEntry> tmp(n);
+    vector<u32> litClass(n);
+    for (u32 i = 0; i < n; i++) {
+        const hwlmLiteral &lit = lits[i];
+        dictEntry &e = tmp[i];
+        memset(&e, 0, sizeof(e));
+        makeValMask(lit, e.v, e.msk);
+        e.id = lit.id;
+        e.groups = lit.groups;
+        e.size = verify_u8(max(lit.s.size(), lit.msk.size()));
+        litClass[i] = lenToClass.at(min(verify_u32(lit.s.size()), 8U));
+        e.cls = verify_u8(litClass[i]);
+
+        // the class hashes only bytes that every literal in it must match
+        classes[e.cls].andmsk &= e.msk;
+    }
+
+    const size_t bloomSize = max((size_t)1 << (bloomBits - 3), (size_t)64);
+    const size_t tableSize = ((size_t)1 << tableBits) * sizeof(u32);
+    const size_t bloomOffset = ROUNDUP_CL(sizeof(dictTable));
+    const size_t tableOffset = bloomOffset + ROUNDUP_CL(bloomSize);
+    const size_t entryOffset = tableOffset + ROUNDUP_CL(tableSize);
+    const size_t size = entryOffset + n * sizeof(dictEntry);
+
+    auto t = make_zeroed_bytecode_ptr<dictTable>(size, 64);
+    assert(t); // otherwise would have thrown std::bad_alloc
+
+    t->size = verify_u32(size);
+    t->numEntries = n;
+    t->bloomOffset = verify_u32(bloomOffset);
+    t->tableOffset = verify_u32(tableOffset);
+    t->entryOffset = verify_u32(entryOffset);
+    t->bloomBits = verify_u8(bloomBits);
+    t->tableBits = verify_u8(tableBits);
+    t->numClasses = verify_u8(numClasses);
+    memcpy(t->classes, classes, sizeof(classes));
+
+    u8 *base = (u8 *)t.get();
+    u64a *bloom = (u64a *)(base + bloomOffset);
+    u32 *table = (u32 *)(base + tableOffset);
+    dictEntry *entries = (dictEntry *)(base + entryOffset);
+
+    // Hash every literal and lay out the entries grouped by slot.
+    vector<pair<u32, u32>> slotToLit(n);
+    for (u32 i = 0; i < n; i++) {
+        const dictClass &dc = classes[litClass[i]];
+        u64a key = (tmp[i].v & dc.andmsk) >> dc.shift;
+        u32 h1 = dictHash(key, dc.mult1, bloomBits);
+        u32 h2 = dictHash(key, dc.mult2, bloomBits);
+        setBloomBit(bloom, h1);
+        setBloomBit(bloom, h2);
+        slotToLit[i] = make_pair(h1 >> (bloomBits - tableBits), i);
+    }
+    stable_sort(slotToLit.begin(), slotToLit.end(),
+                [](const pair<u32, u32> &a, const pair<u32, u32> &b) {
+                    return a.first < b.first;
+                });
+
+    for (u32 j = 0; j < n; j++) {
+        u32 slot = slotToLit[j].first;
+        if (!table[slot]) {
+            table[slot] = j + 1;
+        }
+        entries[j] = tmp[slotToLit[j].second];
+        entries[j].last = j + 1 == n || slotToLit[j + 1].first != slot;
+    }
+
+    return t;
+}
+
+size_t dictSize(const dictTable *t) {
+    return t->size;
+}
+
+} // namespace ue2
+
+#ifdef DUMP_SUPPORT
+
+namespace ue2 {
+
+void dictPrintStats(const dictTable *t, FILE *f) {
+    const u8 *base = (const u8 *)t;
+    const u64a *bloom = (const u64a *)(base + t->bloomOffset);
+    const u32 *table = (const u32 *)(base + t->tableOffset);
+
+    u32 bloomSet = 0;
+    for (u32 i = 0; i < (1U << t->bloomBits) / 64; i++) {
+        bloomSet += popcount64(bloom[i]);
+    }
+    u32 slots = 1U << t->tableBits;
+    u32 slotsUsed = count_if(table, table + slots, [](u32 i) { return i; });
+
+    fprintf(f, "Dictionary table\n");
+    fprintf(f, "Literals: %u Size: %u bytes\n", t->numEntries, t->size);
+    fprintf(f, "Bloom: %u/%u bits set\n", bloomSet, 1U << t->bloomBits);
+    fprintf(f, "Table: %u/%u slots used\n", slotsUsed, slots);
+    for (u32 c = 0; c < t->numClasses; c++) {
+        const dictClass &dc = t->classes[c];
+        fprintf(f, "Class %u: len %u andmsk %016llx\n", c, dc.len, dc.andmsk);
+    }
+}
+
+} // namespace ue2
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Dictionary literal matcher: runtime.
+ */
+#include "hwlm.h"
+#include "dict_engine.h"
+#include "dict_internal.h"
+#include "scratch.h"
+#include "ue2common.h"
+#include "util/unaligned.h"
+
+#include <string.h>
+
+/** \brief Dictionary matcher runtime context. */
+struct dict_ctx {
+    const struct dictTable *t; //!< table being scanned
+    const u64a *bloom; //!< bloom filter
+    const u32 *table; //!< hash table
+    const struct dictEntry *entries; //!< hash table entries
+    HWLMCallback cb; //!< callback function called on match
+    struct hs_scratch *scratch; //!< scratch to pass to callback
+    hwlm_group_t groups; //!< current groups, updated by the callback
+    ptrdiff_t floor; //!< earliest offset at which a match may start
+};
+
+static really_inline
+int bloomTest(const u64a *bloom, u32 h) {
+    return (bloom[h >> 6] >> (h & 63)) & 1;
+}
+
+static really_inline
+hwlm_error_t confirmSlot(const struct dictEntry *e, u32 cls, u64a window,
+                         size_t end, struct dict_ctx *ctx) {
+    for (;; e++) {
+        if (e->cls == cls && (window & e->msk) == e->v &&
+            (ptrdiff_t)end + 1 - e->size >= ctx->floor &&
+            (e->groups & ctx->groups)) {
+            DEBUG_PRINTF("match @ %zu id %u\n", end, e->id);
+            hwlmcb_rv_t rv = ctx->cb(end, e->id, ctx->scratch);
+            if (rv == HWLM_TERMINATE_MATCHING) {
+                return HWLM_TERMINATED;
+            }
+            ctx->groups = rv;
+        }
+        if (e->last) {
+            return HWLM_SUCCESS;
+        }
+    }
+}
+
+/*
+ * Check for literals ending at end. window holds the eight bytes of data
+ * ending at end, with the last byte in the most significant position.
+ */
+static really_inline
+hwlm_error_t checkEnd(u64a window, size_t end, struct dict_ctx *ctx) {
+    const struct dictTable *t = ctx->t;
+
+    for (u32 c = 0; c < t->numClasses; c++) {
+        const struct dictClass *dc = &t->classes[c];
+        if ((ptrdiff_t)end + 1 - dc->len < ctx->floor) {
+            // classes are sorted by length, longer ones can't fit either
+            break;
+        }
+
+        u64a key = (window & dc->andmsk) >> dc->shift;
+        u32 h1 = dictHash(key, dc->mult1, t->bloomBits);
+        if (likely(!bloomTest(ctx->bloom, h1))) {
+            continue;
+        }
+        u32 h2 = dictHash(key, dc->mult2, t->bloomBits);
+        if (!bloomTest(ctx->bloom, h2)) {
+            continue;
+        }
+
+        u32 idx = ctx->table[h1 >> (t->bloomBits - t->tableBits)];
+        if (!idx) {
+            continue;
+        }
+
+        hwlm_error_t rv = confirmSlot(ctx->entries + idx - 1, c, window, end,
+                                      ctx);
+        if (rv == HWLM_TERMINATED) {
+            return HWLM_TERMINATED;
+        }
+    }
+
+    return HWLM_SUCCESS;
+}
+
+/*
+ * Scan for literals ending at or after from. before holds the eight bytes
+ * preceding buf (zero where there is no data).
+ */
+static really_inline
+hwlm_error_t scan(const u8 *buf, size_t len, size_t from, const u8 *before,
+                  struct dict_ctx *ctx) {
+    size_t i = from;
+    hwlm_error_t rv;
+
+    if (i < 7) {
+        // Windows ending in the first seven bytes include bytes from before
+        // the buffer.
+        u8 temp[16];
+        memcpy(temp, before, 8);
+        memset(temp + 8, 0, 8);
+        memcpy(temp + 8, buf, MIN(len, 8));
+        for (; i < MIN(len, 7); i++) {
+            rv = checkEnd(unaligned_load_u64a(temp + i + 1), i, ctx);
+            if (rv == HWLM_TERMINATED) {
+                return HWLM_TERMINATED;
+            }
+        }
+    }
+
+    for (; i < len; i++) {
+        rv = checkEnd(unaligned_load_u64a(buf + i - 7), i, ctx);
+        if (rv == HWLM_TERMINATED) {
+            return HWLM_TERMINATED;
+        }
+    }
+
+    return HWLM_SUCCESS;
+}
+
+static really_inline
+void initCtx(struct dict_ctx *ctx, const struct dictTable *t, HWLMCallback cb,
+             struct hs_scratch *scratch, hwlm_group_t groups,
+             ptrdiff_t floor) {
+    const u8 *base = (const u8 *)t;
+    ctx->t = t;
+    ctx->bloom = (const u64a *)(base + t->bloomOffset);
+    ctx->table = (const u32 *)(base + t->tableOffset);
+    ctx->entries = (const struct dictEntry *)(base + t->entryOffset);
+    ctx->cb = cb;
+    ctx->scratch = scratch;
+    ctx->groups = groups;
+    ctx->floor = floor;
+}
+
+/** \brief Block-mode scanner. */
+hwlm_error_t dictExec(const struct dictTable *t, const u8 *buf, size_t len,
+                      size_t start, HWLMCallback cb,
+                      struct hs_scratch *scratch, hwlm_group_t groups) {
+    assert(t && buf);
+    assert(start < len);
+
+    DEBUG_PRINTF("dict scan of %zu bytes from %zu\n", len, start);
+
+    struct dict_ctx ctx;
+    initCtx(&ctx, t, cb, scratch, groups, start);
+
+    static const u8 zeroes[8] = {0};
+    return scan(buf, len, start, zeroes, &ctx);
+}
+
+/** \brief Streaming-mode scanner. */
+hwlm_error_t dictExecStreaming(const struct dictTable *t, const u8 *hbuf,
+                               size_t hlen, const u8 *buf, size_t len,
+                               HWLMCallback cb, struct hs_scratch *scratch,
+                               hwlm_group_t groups) {
+    assert(t && buf);
+
+    DEBUG_PRINTF("dict scan of %zu bytes (%zu hlen)\n", len, hlen);
+
+    // Literals may start up to seven bytes back in history.
+    size_t tl = MIN(hlen, 8);
+    struct dict_ctx ctx;
+    initCtx(&ctx, t, cb, scratch, groups, -(ptrdiff_t)tl);
+
+    u8 before[8];
+    memset(before, 0, sizeof(before));
+    if (tl) {
+        assert(hbuf);
+        memcpy(before + 8 - tl, hbuf + hlen - tl, tl);
+    }
+
+    return scan(buf, len, 0, before, &ctx);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Data structures for the dictionary literal matcher engine.
+ *
+ * The dictionary matcher is intended for very large literal sets, where
+ * FDR's buckets and confirm chains degrade. Literals are divided into classes
+ * by length; at each end position in the data, each class hashes the last
+ * bytes of the data and probes a bloom filter shared by all classes. Only
+ * positions which pass the filter look up the hash table, whose slots hold
+ * contiguous runs of entries confirmed with a masked compare.
+ */
+
+#ifndef DICT_INTERNAL_H
+#define DICT_INTERNAL_H
+
+#include "hwlm.h"
+#include "ue2common.h"
+
+/** \brief Maximum number of key length classes. */
+#define DICT_MAX_CLASSES 8
+
+/** \brief A class of literals sharing a key length. */
+struct dictClass {
+    u64a andmsk; //!< bytes of the last 8 hashed for this class
+    u64a mult1; //!< multiplier for the first bloom probe and table index
+    u64a mult2; //!< multiplier for the second bloom probe
+    u8 shift; //!< right shift applied to the masked key before hashing
+    u8 len; //!< key length in bytes
+};
+
+/** \brief A literal in the dictionary hash table. */
+struct dictEntry {
+    u64a v; //!< value of the last 8 bytes of the literal, under msk
+    u64a msk; //!< mask of the last 8 bytes of the literal
+    hwlm_group_t groups; //!< groups this literal belongs to
+    u32 id; //!< ID to pass to callback on match
+    u8 size; //!< length of the literal, including any leading msk bytes
+    u8 cls; //!< key length class this literal was hashed in
+    u8 last; //!< last entry in this hash slot
+};
+
+/**
+ * \brief Dictionary matcher header.
+ *
+ * Followed in memory by the bloom filter (1 << bloomBits bits), the hash
+ * table (1 << tableBits u32 entries, each zero or one more than the index of
+ * the first dictEntry in the slot) and the dictEntry array.
+ */
+struct dictTable {
+    u32 size; //!< total size of this structure, in bytes
+    u32 numEntries;
+    u32 bloomOffset; //!< offset of the bloom filter from the header
+    u32 tableOffset; //!< offset of the hash table from the header
+    u32 entryOffset; //!< offset of the entries from the header
+    u8 bloomBits; //!< log2 of the bloom filter size, in bits
+    u8 tableBits; //!< log2 of the number of hash table slots
+    u8 numClasses;
+    struct dictClass classes[DICT_MAX_CLASSES];
+};
+
+static really_inline
+u32 dictHash(u64a key, u64a mult, u32 bits) {
+    return (u32)((key * mult) >> (64 - bits));
+}
+
+#endif /* DICT_INTERNAL_H */
@@ -31,6 +31,7 @@
  */
 #include "hwlm.h"
 #include "hwlm_internal.h"
+#include "dict_engine.h"
 #include "noodle_engine.h"
 #include "scratch.h"
 #include "ue2common.h"
@@ -68,6 +69,12 @@ const u8 *run_hwlm_accel(const union AccelAux *aux, const u8 *ptr,
     case ACCEL_TRUFFLE:
         DEBUG_PRINTF("truffle\n");
         return truffleExec(aux->truffle.mask1, aux->truffle.mask2, ptr, end);
+    case ACCEL_MSHUFTI:
+        DEBUG_PRINTF("multi shufti\n");
+        return shuftiMultiExec(aux->mshufti.lo1, aux->mshufti.hi1,
+                               aux->mshufti.lo2, aux->mshufti.hi2,
+                               aux->mshufti.onechar, aux->mshufti.buckets,
+                               aux->mshufti.len, ptr, end);
     default:
         /* no acceleration, fall through and return current ptr */
         DEBUG_PRINTF("no accel; %u\n", (int)aux->accel_type);
@@ -126,7 +133,23 @@ void do_accel_streaming(const union AccelAux *aux, const u8 *hbuf, size_t hlen,
             ptr1 = run_hwlm_accel(aux, ptr1, end1);
         }
 
-        if ((hlen <= 16 || inaccurate_accel(aux->accel_type))
+        if (aux->accel_type == ACCEL_MSHUFTI && end1 != ptr1
+            && end1 - ptr1 <= 16) {
+            /* a sequence may run on into buf, so finish off the history
+             * buffer with the start of buf behind it */
+            u8 ALIGN_DIRECTIVE temp[32];
+            ptrdiff_t tlen = end1 - ptr1;
+            assert(len >= 16);
+            memcpy(temp, ptr1, tlen);
+            memcpy(temp + tlen, buf, 16);
+
+            const u8 *tempp = run_hwlm_accel(aux, temp, temp + tlen + 16);
+
+            if (tempp - temp >= tlen) {
+                ptr1 = end1;
+            }
+            DEBUG_PRINTF("got %zu\n", tempp - temp);
+        } else if ((hlen <= 16 || inaccurate_accel(aux->accel_type))
             && end1 != ptr1 && end1 - ptr1 <= 16) {
             DEBUG_PRINTF("already scanned %zu/%zu\n", ptr1 - hbuf, hlen);
             /* see if we can finish off the history buffer completely */
@@ -187,6 +210,11 @@ hwlm_error_t hwlmExec(const struct HWLM *t, const u8 *buf, size_t len,
         return noodExec(HWLM_C_DATA(t), buf, len, start, cb, scratch);
     }
 
+    if (t->type == HWLM_ENGINE_DICT) {
+        DEBUG_PRINTF("calling dictExec\n");
+        return dictExec(HWLM_C_DATA(t), buf, len, start, cb, scratch, groups);
+    }
+
     assert(t->type == HWLM_ENGINE_FDR);
     const union AccelAux *aa = &t->accel0;
     if ((groups & ~t->accel1_groups) == 0) {
@@ -229,6 +257,17 @@ hwlm_error_t hwlmExecStreaming(const struct HWLM *t, size_t len, size_t start,
         }
     }
 
+    if (t->type == HWLM_ENGINE_DICT) {
+        DEBUG_PRINTF("calling dictExec\n");
+        if (start) {
+            return dictExec(HWLM_C_DATA(t), buf, len, start, cb, scratch,
+                            groups);
+        } else {
+            return dictExecStreaming(HWLM_C_DATA(t), hbuf, hlen, buf, len, cb,
+                                     scratch, groups);
+        }
+    }
+
     assert(t->type == HWLM_ENGINE_FDR);
     const union AccelAux *aa = &t->accel0;
     if ((groups & ~t->accel1_groups) == 0) {
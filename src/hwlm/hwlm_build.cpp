@@ -36,6 +36,7 @@
 #include "hwlm.h"
 #include "hwlm_internal.h"
 #include "hwlm_literal.h"
+#include "dict_build.h"
 #include "noodle_engine.h"
 #include "noodle_build.h"
 #include "scratch.h"
@@ -118,6 +119,38 @@ bool isNoodleable(const vector<hwlmLiteral> &lits,
     return true;
 }
 
+static
+bool useDict(size_t numLiterals, const CompileContext &cc) {
+    if (!cc.grey.allowDict) {
+        return false;
+    }
+
+    return numLiterals >= cc.grey.dictMinLiterals;
+}
+
+/**
+ * Very large literal sets overwhelm FDR's buckets: confirm chains grow with
+ * the number of literals per bucket. These go to the dictionary matcher,
+ * whose per-byte cost depends on the number of distinct literal lengths
+ * instead.
+ */
+static
+bool isDictable(const vector<hwlmLiteral> &lits, const CompileContext &cc) {
+    if (!useDict(lits.size(), cc)) {
+        DEBUG_PRINTF("too few literals for dict\n");
+        return false;
+    }
+
+    for (const auto &lit : lits) {
+        if (max(lit.s.length(), lit.msk.size()) > HWLM_MASKLEN) {
+            DEBUG_PRINTF("literal too long for dict\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bytecode_ptr<HWLM> hwlmBuild(const HWLMProto &proto, const CompileContext &cc,
                              UNUSED hwlm_group_t expected_groups) {
     size_t engSize = 0;
@@ -134,6 +167,13 @@ bytecode_ptr<HWLM> hwlmBuild(const HWLMProto &proto, const CompileContext &cc,
             engSize = noodle.size();
         }
         eng = move(noodle);
+    } else if (proto.engType == HWLM_ENGINE_DICT) {
+        DEBUG_PRINTF("build dict table\n");
+        auto dict = dictBuildTable(lits);
+        if (dict) {
+            engSize = dict.size();
+        }
+        eng = move(dict);
     } else {
         DEBUG_PRINTF("building a new deal\n");
         auto fdr = fdrBuildTable(proto, cc.grey);
@@ -202,6 +242,9 @@ hwlmBuildProto(vector<hwlmLiteral> &lits, bool make_small,
     if (isNoodleable(lits, cc)) {
         DEBUG_PRINTF("build noodle table\n");
         proto = ue2::make_unique<HWLMProto>(HWLM_ENGINE_NOOD, lits);
+    } else if (isDictable(lits, cc)) {
+        DEBUG_PRINTF("build dict table\n");
+        proto = ue2::make_unique<HWLMProto>(HWLM_ENGINE_DICT, lits);
     } else {
         DEBUG_PRINTF("building a new deal\n");
         proto = fdrBuildProto(HWLM_ENGINE_FDR, lits, make_small,
@@ -221,6 +264,9 @@ size_t hwlmSize(const HWLM *h) {
     case HWLM_ENGINE_NOOD:
         engSize = noodSize((const noodTable *)HWLM_C_DATA(h));
         break;
+    case HWLM_ENGINE_DICT:
+        engSize = dictSize((const dictTable *)HWLM_C_DATA(h));
+        break;
     case HWLM_ENGINE_FDR:
         engSize = fdrSize((const FDR *)HWLM_C_DATA(h));
         break;
@@ -34,6 +34,7 @@
 
 #include "hwlm_dump.h"
 #include "hwlm_internal.h"
+#include "dict_build.h"
 #include "noodle_build.h"
 #include "ue2common.h"
 #include "fdr/fdr_dump.h"
@@ -55,6 +56,9 @@ void hwlmGenerateDumpFiles(const HWLM *h, const string &base) {
     case HWLM_ENGINE_NOOD:
         noodPrintStats((const noodTable *)HWLM_C_DATA(h), f);
         break;
+    case HWLM_ENGINE_DICT:
+        dictPrintStats((const dictTable *)HWLM_C_DATA(h), f);
+        break;
     case HWLM_ENGINE_FDR:
         fdrPrintStats((const FDR *)HWLM_C_DATA(h), f);
         break;
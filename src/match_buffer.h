@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Delivery of matches to the user, either through the match callback
+ * or into a caller-supplied match buffer.
+ */
+
+#ifndef MATCH_BUFFER_H
+#define MATCH_BUFFER_H
+
+#include "hs_runtime.h"
+#include "scratch.h"
+#include "ue2common.h"
+
+/** \brief Store a match in the scratch's match buffer, applying the overflow
+ * policy if it is full. Returns non-zero if matching should halt. */
+static really_inline
+int bufferUserMatch(struct match_buffer *mb, u32 id, u64a from, u64a to,
+                    u32 flags) {
+    if (likely(mb->count < mb->capacity)) {
+        hs_match_t *m = mb->buf + mb->count++;
+        m->id = id;
+        m->flags = flags;
+        m->from = from;
+        m->to = to;
+        return 0;
+    }
+
+    DEBUG_PRINTF("match buffer full (%u entries)\n", mb->capacity);
+    mb->dropped++;
+    if (mb->policy == HS_MATCH_BUFFER_DROP) {
+        return 0;
+    }
+
+    if (mb->overflow_offset == ~0ULL) {
+        mb->overflow_offset = to;
+    }
+    return 1;
+}
+
+/** \brief Hand a match to the user. Returns non-zero if matching should
+ * halt. */
+static really_inline
+int deliverUserMatch(struct hs_scratch *scratch, u32 id, u64a from, u64a to,
+                     u32 flags) {
+    struct core_info *ci = &scratch->core_info;
+
+    PROFILE_REPORT(scratch, id);
+
+    if (unlikely(scratch->mbuf.buf != NULL)) {
+        return bufferUserMatch(&scratch->mbuf, id, from, to, flags);
+    }
+
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_CALLBACK, 0);
+    PROFILE_START(scratch);
+    int halt = ci->userCallback(id, from, to, flags, ci->userContext);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_CALLBACK);
+    return halt;
+}
+
+#endif // MATCH_BUFFER_H
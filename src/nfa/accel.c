@@ -124,6 +124,20 @@ const u8 *run_accel(const union AccelAux *accel, const u8 *c, const u8 *c_end) {
                               accel->dshufti.hi2, c, c_end - 1);
         break;
 
+    case ACCEL_MSHUFTI:
+        DEBUG_PRINTF("accel mshufti %p %p\n", c, c_end);
+        if (c + 15 >= c_end) {
+            return c;
+        }
+
+        /* sequences running off the end are treated as matches, so there is
+         * no need to stop early */
+        rv = shuftiMultiExec(accel->mshufti.lo1, accel->mshufti.hi1,
+                             accel->mshufti.lo2, accel->mshufti.hi2,
+                             accel->mshufti.onechar, accel->mshufti.buckets,
+                             accel->mshufti.len, c, c_end);
+        break;
+
     case ACCEL_RED_TAPE:
         DEBUG_PRINTF("accel red tape %p %p\n", c, c_end);
         rv = c_end;
@@ -62,8 +62,15 @@ enum AccelType {
     ACCEL_TRUFFLE,
     ACCEL_RED_TAPE,
     ACCEL_DVERM_MASKED,
+    ACCEL_MSHUFTI,
 };
 
+/** \brief Shortest class sequence handled by multi-byte shufti. */
+#define MSHUFTI_MIN_LEN 3
+
+/** \brief Longest class sequence handled by multi-byte shufti. */
+#define MSHUFTI_MAX_LEN 4
+
 /** \brief Structure for accel framework. */
 union AccelAux {
     u8 accel_type;
@@ -111,6 +118,17 @@ union AccelAux {
         m128 lo2;
         m128 hi2;
     } dshufti;
+    struct {
+        u8 accel_type;
+        u8 offset;
+        u8 len; // number of classes in the sequence
+        u16 onechar; // buckets for single-byte stops
+        u16 buckets[MSHUFTI_MAX_LEN]; // buckets for each class in turn
+        m128 lo1;
+        m128 hi1;
+        m128 lo2;
+        m128 hi2;
+    } mshufti;
     struct {
         u8 accel_type;
         u8 offset;
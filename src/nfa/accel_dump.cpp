@@ -91,6 +91,8 @@ const char *accelName(u8 accel_type) {
         return "shufti";
     case ACCEL_DSHUFTI:
         return "double-shufti";
+    case ACCEL_MSHUFTI:
+        return "multi-shufti";
     case ACCEL_TRUFFLE:
         return "truffle";
     case ACCEL_RED_TAPE:
@@ -165,6 +167,22 @@ void dumpDShuftiCharReach(FILE *f, const u8 *lo1, const u8 *hi1,
     fprintf(f, "}\n");
 }
 
+static
+void dumpMShuftiCharReach(FILE *f, const AccelAux &accel) {
+    const u8 *lo1 = (const u8 *)&accel.mshufti.lo1;
+    const u8 *hi1 = (const u8 *)&accel.mshufti.hi1;
+    const u8 *lo2 = (const u8 *)&accel.mshufti.lo2;
+    const u8 *hi2 = (const u8 *)&accel.mshufti.hi2;
+    CharReach onechar = mshufti2cr(lo1, hi1, lo2, hi2, accel.mshufti.onechar);
+    fprintf(f, "escapes: %s {", describeClass(onechar).c_str());
+    for (u32 i = 0; i < accel.mshufti.len; i++) {
+        CharReach cr = mshufti2cr(lo1, hi1, lo2, hi2,
+                                  accel.mshufti.buckets[i]);
+        fprintf(f, "%s", describeClass(cr).c_str());
+    }
+    fprintf(f, "}\n");
+}
+
 static
 void dumpShuftiMasks(FILE *f, const u8 *lo, const u8 *hi) {
     fprintf(f, "lo %s\n", dumpMask(lo, 128).c_str());
@@ -229,6 +247,16 @@ void dumpAccelInfo(FILE *f, const AccelAux &accel) {
                              (const u8 *)&accel.dshufti.lo2,
                              (const u8 *)&accel.dshufti.hi2);
         break;
+    case ACCEL_MSHUFTI:
+        fprintf(f, "\n");
+        fprintf(f, "mask 1\n");
+        dumpShuftiMasks(f, (const u8 *)&accel.mshufti.lo1,
+                        (const u8 *)&accel.mshufti.hi1);
+        fprintf(f, "mask 2\n");
+        dumpShuftiMasks(f, (const u8 *)&accel.mshufti.lo2,
+                        (const u8 *)&accel.mshufti.hi2);
+        dumpMShuftiCharReach(f, accel);
+        break;
     case ACCEL_TRUFFLE: {
         fprintf(f, "\n");
         dumpTruffleMasks(f, (const u8 *)&accel.truffle.mask1,
@@ -225,6 +225,27 @@ void buildAccelDouble(const AccelInfo &info, AccelAux *aux) {
     aux->accel_type = ACCEL_NONE;
 }
 
+static
+void buildAccelMulti(const AccelInfo &info, AccelAux *aux) {
+    assert(aux->accel_type == ACCEL_NONE);
+    if (info.multi_stops.empty()) {
+        return;
+    }
+
+    assert(info.multi_stops.size() >= MSHUFTI_MIN_LEN);
+    assert(info.multi_stops.size() <= MSHUFTI_MAX_LEN);
+    DEBUG_PRINTF("building multi-shufti for %zu one-byte stops and %zu "
+                 "classes\n", info.multi_stop1.count(),
+                 info.multi_stops.size());
+    aux->accel_type = ACCEL_MSHUFTI;
+    aux->mshufti.offset = verify_u8(info.multi_offset);
+    aux->mshufti.len = verify_u8(info.multi_stops.size());
+    shuftiBuildMultiMasks(info.multi_stop1, info.multi_stops,
+                          (u8 *)&aux->mshufti.lo1, (u8 *)&aux->mshufti.hi1,
+                          (u8 *)&aux->mshufti.lo2, (u8 *)&aux->mshufti.hi2,
+                          &aux->mshufti.onechar, aux->mshufti.buckets);
+}
+
 bool buildAccelAux(const AccelInfo &info, AccelAux *aux) {
     assert(aux->accel_type == ACCEL_NONE);
     if (info.single_stops.none()) {
@@ -232,6 +253,9 @@ bool buildAccelAux(const AccelInfo &info, AccelAux *aux) {
         aux->accel_type = ACCEL_RED_TAPE;
         aux->generic.offset = info.single_offset;
     }
+    if (aux->accel_type == ACCEL_NONE) {
+        buildAccelMulti(info, aux);
+    }
     if (aux->accel_type == ACCEL_NONE) {
         buildAccelDouble(info, aux);
     }
@@ -241,7 +265,8 @@ bool buildAccelAux(const AccelInfo &info, AccelAux *aux) {
 
     assert(aux->accel_type == ACCEL_NONE
            || aux->generic.offset == info.single_offset
-           || aux->generic.offset == info.double_offset);
+           || aux->generic.offset == info.double_offset
+           || aux->generic.offset == info.multi_offset);
     return aux->accel_type != ACCEL_NONE;
 }
 
@@ -33,20 +33,31 @@
 #include "util/charreach.h"
 #include "util/flat_containers.h"
 
+#include <vector>
+
 union AccelAux;
 
 namespace ue2 {
 
+/** \brief A multi-byte scheme must stop this many times less often than the
+ * scheme it would replace to be worth its extra work per block. */
+static constexpr u32 MULTI_ACCEL_GAIN = 4;
+
 struct AccelInfo {
-    AccelInfo() : single_offset(0U), double_offset(0U),
+    AccelInfo() : single_offset(0U), double_offset(0U), multi_offset(0U),
                   single_stops(CharReach::dot()) {}
     u32 single_offset; /**< offset correction to apply to single schemes */
     u32 double_offset; /**< offset correction to apply to double schemes */
+    u32 multi_offset; /**< offset correction to apply to multi-byte schemes */
     CharReach double_stop1;  /**<  single-byte accel stop literals for double
                             * schemes */
     flat_set<std::pair<u8, u8>> double_stop2; /**< double-byte accel stop
                                                * literals */
     CharReach single_stops; /**< escapes for single byte acceleration */
+    CharReach multi_stop1; /**< single-byte accel stop literals for
+                            * multi-byte schemes */
+    std::vector<CharReach> multi_stops; /**< class sequence for multi-byte
+                                         * schemes */
 };
 
 bool buildAccelAux(const AccelInfo &info, AccelAux *aux);
@@ -88,13 +88,17 @@ static constexpr u32 NO_STATE = ~0;
 namespace {
 
 struct precalcAccel {
-    precalcAccel() : single_offset(0), double_offset(0) {}
+    precalcAccel() : single_offset(0), double_offset(0), multi_offset(0) {}
     CharReach single_cr;
     u32 single_offset;
 
     CharReach double_cr;
     flat_set<pair<u8, u8>> double_lits; /* double-byte accel stop literals */
     u32 double_offset;
+
+    CharReach multi_cr;
+    vector<CharReach> multi_classes; /* multi-byte accel class sequence */
+    u32 multi_offset;
 };
 
 struct limex_accel_info {
@@ -645,7 +649,7 @@ void fillAccelInfo(build_info &bi) {
         const bool allow_wide = allow_wide_accel(states, g, sds_or_proxy);
 
         AccelScheme as = nfaFindAccel(g, states, refined_cr, br_cyclic,
-                                      allow_wide, true);
+                                      allow_wide, true, true);
         if (is_too_wide(as)) {
             DEBUG_PRINTF("accel %u too wide (%zu, %d)\n", i,
                          as.cr.count(), MAX_MERGED_ACCEL_STOPS);
@@ -665,6 +669,12 @@ void fillAccelInfo(build_info &bi) {
             pa.double_cr = as.double_cr;
         }
 
+        if (!as.multi_classes.empty()) {
+            pa.multi_offset = as.multi_offset;
+            pa.multi_classes = as.multi_classes;
+            pa.multi_cr = as.multi_cr;
+        }
+
         useful |= state_set;
     }
 
@@ -927,6 +937,9 @@ void buildAccel(const build_info &args, NFAStateSet &accelMask,
                 const auto &precalc = accel.precalc.at(effective_states);
                 ainfo.single_offset = precalc.single_offset;
                 ainfo.single_stops = precalc.single_cr;
+                ainfo.multi_offset = precalc.multi_offset;
+                ainfo.multi_stop1 = precalc.multi_cr;
+                ainfo.multi_stops = precalc.multi_classes;
             }
         }
 
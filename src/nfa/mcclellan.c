@@ -1140,6 +1140,197 @@ char nfaExecMcClellan16_Q2(const struct NFA *n, struct mq *q, s64a end) {
                                   STOP_AT_MATCH);
 }
 
+/** \brief Per-lane tables used by the lockstep loop. */
+struct mcclellan_lockstep {
+    const u8 *succ_table[MCCLELLAN_LOCKSTEP_MAX];
+    const u8 *remap[MCCLELLAN_LOCKSTEP_MAX];
+    const u8 *buf[MCCLELLAN_LOCKSTEP_MAX];
+    u32 alpha_shift[MCCLELLAN_LOCKSTEP_MAX];
+    u32 accel_limit[MCCLELLAN_LOCKSTEP_MAX];
+    u32 s[MCCLELLAN_LOCKSTEP_MAX];
+    struct mcclellan_lane *lane[MCCLELLAN_LOCKSTEP_MAX];
+};
+
+/** \brief True if the transition into state s must be taken by the normal
+ * exec path: dead, accelerable and accepting states all qualify. */
+static really_inline
+u32 lockstepLeaves(const struct mcclellan_lockstep *ls, u32 i, u32 s) {
+    return s - 1 >= ls->accel_limit[i] - 1;
+}
+
+static really_inline
+u32 lockstepNext(const struct mcclellan_lockstep *ls, u32 i, size_t p) {
+    return ls->succ_table[i][(ls->s[i] << ls->alpha_shift[i])
+                             + ls->remap[i][ls->buf[i][p]]];
+}
+
+/**
+ * Advances all count lanes over [p, end) until the next byte would take any
+ * of them out of the group. The loads for the different lanes are
+ * independent, so they overlap rather than queueing up behind one another.
+ */
+static really_inline
+size_t lockstepRun(struct mcclellan_lockstep *ls, size_t p, size_t end,
+                   const u32 count) {
+    for (; p < end; p++) {
+        u32 next[MCCLELLAN_LOCKSTEP_MAX];
+        u32 leave = 0;
+        for (u32 i = 0; i < count; i++) {
+            next[i] = lockstepNext(ls, i, p);
+            leave |= lockstepLeaves(ls, i, next[i]);
+        }
+        if (leave) {
+            break;
+        }
+        for (u32 i = 0; i < count; i++) {
+            ls->s[i] = next[i];
+        }
+    }
+    return p;
+}
+
+static really_inline
+void lockstepMove(struct mcclellan_lockstep *ls, u32 to, u32 from) {
+    ls->succ_table[to] = ls->succ_table[from];
+    ls->remap[to] = ls->remap[from];
+    ls->buf[to] = ls->buf[from];
+    ls->alpha_shift[to] = ls->alpha_shift[from];
+    ls->accel_limit[to] = ls->accel_limit[from];
+    ls->s[to] = ls->s[from];
+    ls->lane[to] = ls->lane[from];
+}
+
+void nfaExecMcClellan8_initLane(struct mcclellan_lane *lane,
+                                const struct NFA *nfa, const u8 *buf,
+                                size_t len, const char *streamState,
+                                u64a offset) {
+    assert(nfa->type == MCCLELLAN_NFA_8);
+    assert(nfa->streamStateSize == 1);
+    const struct mcclellan *m = getImplNfa(nfa);
+
+    lane->nfa = nfa;
+    lane->buf = buf;
+    lane->len = len;
+    lane->loc = 0;
+    /* a write at offset zero begins with a top, as in the queue */
+    lane->state = offset ? *(const u8 *)streamState : m->start_anchored;
+}
+
+void nfaExecMcClellan8_Lockstep(struct mcclellan_lane *lanes, u32 count) {
+    assert(count <= MCCLELLAN_LOCKSTEP_MAX);
+
+    struct mcclellan_lockstep ls;
+    u32 live = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        struct mcclellan_lane *lane = &lanes[i];
+        assert(!lane->loc);
+        if (!lane->len || !lane->state) {
+            continue;
+        }
+        assert(lane->nfa->type == MCCLELLAN_NFA_8);
+
+        const struct mcclellan *m = getImplNfa(lane->nfa);
+        ls.succ_table[live] = (const u8 *)((const char *)m
+                                           + sizeof(struct mcclellan));
+        ls.remap[live] = m->remap;
+        ls.buf[live] = lane->buf;
+        ls.alpha_shift[live] = m->alphaShift;
+        ls.accel_limit[live] = m->accel_limit_8;
+        ls.s[live] = lane->state;
+        ls.lane[live] = lane;
+        live++;
+    }
+
+    size_t p = 0;
+    while (live > 1) {
+        size_t end = ls.lane[0]->len;
+        for (u32 i = 1; i < live; i++) {
+            end = MIN(end, ls.lane[i]->len);
+        }
+
+        switch (live) {
+        case 2:
+            p = lockstepRun(&ls, p, end, 2);
+            break;
+        case 3:
+            p = lockstepRun(&ls, p, end, 3);
+            break;
+        case 4:
+            p = lockstepRun(&ls, p, end, 4);
+            break;
+        default:
+            p = lockstepRun(&ls, p, end, live);
+            break;
+        }
+
+        /* retire the lanes which stopped the group, keep the rest going */
+        u32 kept = 0;
+        for (u32 i = 0; i < live; i++) {
+            struct mcclellan_lane *lane = ls.lane[i];
+            u32 next = p < lane->len ? lockstepNext(&ls, i, p) : 0;
+            if (!lockstepLeaves(&ls, i, next)) {
+                lockstepMove(&ls, kept++, i);
+                continue;
+            }
+            DEBUG_PRINTF("lane %zd leaves lockstep at %zu in state %u\n",
+                         lane - lanes, p, ls.s[i]);
+            lane->loc = p;
+            lane->state = ls.s[i];
+        }
+        assert(kept < live);
+        live = kept;
+    }
+
+    /* a lone lane is left to the normal exec path */
+    if (live) {
+        ls.lane[0]->loc = p;
+        ls.lane[0]->state = ls.s[0];
+    }
+}
+
+void nfaExecMcClellan8_QResume(struct mq *q,
+                               const struct mcclellan_lane *lane) {
+    assert(q->nfa == lane->nfa);
+    assert(q->end >= 2 && q->items[q->end - 1].type == MQE_END);
+    assert(lane->loc <= (size_t)q->items[q->end - 1].location);
+
+    if (!lane->loc) {
+        return; /* nothing consumed, the queue starts as it was */
+    }
+
+    /* everything before the END is at location zero and has already been
+     * applied to the lane's state */
+    q->cur = q->end - 2;
+    q->items[q->cur].type = MQE_START;
+    q->items[q->cur].location = lane->loc;
+    *(u8 *)q->state = lane->state;
+}
+
+void nfaExecMcClellan8_QLockstep(struct mq *const *qs, u32 count) {
+    assert(count >= 2 && count <= MCCLELLAN_LOCKSTEP_MAX);
+
+    struct mcclellan_lane lanes[MCCLELLAN_LOCKSTEP_MAX];
+
+    for (u32 i = 0; i < count; i++) {
+        const struct mq *q = qs[i];
+        assert(!q->offset && !q->report_current);
+        assert(q->cur == 0 && q->end == 3);
+        assert(q->items[0].type == MQE_START && !q->items[0].location);
+        assert(q->items[1].type == MQE_TOP && !q->items[1].location);
+        assert(q->items[2].type == MQE_END);
+
+        size_t len = MIN(q->length, (size_t)q->items[2].location);
+        nfaExecMcClellan8_initLane(&lanes[i], q->nfa, q->buffer, len, NULL, 0);
+    }
+
+    nfaExecMcClellan8_Lockstep(lanes, count);
+
+    for (u32 i = 0; i < count; i++) {
+        nfaExecMcClellan8_QResume(qs[i], &lanes[i]);
+    }
+}
+
 char nfaExecMcClellan8_QR(const struct NFA *n, struct mq *q, ReportID report) {
     u64a offset = q->offset;
     const u8 *buffer = q->buffer;
@@ -106,4 +106,40 @@ char nfaExecMcClellan8_B(const struct NFA *n, u64a offset, const u8 *buffer,
 char nfaExecMcClellan16_B(const struct NFA *n, u64a offset, const u8 *buffer,
                           size_t length, NfaCallback cb, void *context);
 
+/** \brief Largest number of lanes advanced by nfaExecMcClellan8_Lockstep. */
+#define MCCLELLAN_LOCKSTEP_MAX 8
+
+/** \brief One buffer being scanned by nfaExecMcClellan8_Lockstep. */
+struct mcclellan_lane {
+    const struct NFA *nfa; /**< 8-bit McClellan DFA for this lane */
+    const u8 *buf; /**< data to scan */
+    size_t len; /**< length of buf */
+    size_t loc; /**< bytes of buf consumed so far */
+    u32 state; /**< DFA state at loc */
+};
+
+/**
+ * Lockstep calls, for running several 8-bit McClellan DFAs (or one DFA over
+ * several buffers) with their transition loads overlapped:
+ * - nfaExecMcClellan8_initLane starts a lane at the beginning of a block or
+ *   stream write; streamState is only read if offset is non-zero
+ * - nfaExecMcClellan8_Lockstep advances all of the lanes together, each until
+ *   its next byte would take it into a dead, accelerable or accepting state,
+ *   so no matches are raised
+ * - nfaExecMcClellan8_QResume moves a queue, set up as usual for the block or
+ *   write, past the bytes consumed by its lane; the rest of the queue must
+ *   still be run as normal
+ * - nfaExecMcClellan8_QLockstep does all of the above for a group of queues
+ *   holding only START and TOP at 0 and an END, as set up for a new outfix at
+ *   the start of a block
+ */
+void nfaExecMcClellan8_initLane(struct mcclellan_lane *lane,
+                                const struct NFA *nfa, const u8 *buf,
+                                size_t len, const char *streamState,
+                                u64a offset);
+void nfaExecMcClellan8_Lockstep(struct mcclellan_lane *lanes, u32 count);
+void nfaExecMcClellan8_QResume(struct mq *q,
+                               const struct mcclellan_lane *lane);
+void nfaExecMcClellan8_QLockstep(struct mq *const *qs, u32 count);
+
 #endif
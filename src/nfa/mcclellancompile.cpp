@@ -1549,4 +1549,15 @@ bool has_accel_mcclellan(const NFA *nfa) {
     return m->has_accel;
 }
 
+bool can_lockstep_mcclellan(const NFA *nfa) {
+    if (nfa->type != MCCLELLAN_NFA_8) {
+        return false;
+    }
+
+    /* a DFA that accelerates from its floating start already skips most of
+     * the block on its own, and would only leave the group straight away */
+    const mcclellan *m = (const mcclellan *)getImplNfa(nfa);
+    return m->start_floating && m->start_floating < m->accel_limit_8;
+}
+
 } // namespace ue2
@@ -101,6 +101,12 @@ std::set<ReportID> all_reports(const raw_dfa &rdfa);
 
 bool has_accel_mcclellan(const NFA *nfa);
 
+/**
+ * \brief True if the DFA is suitable for nfaExecMcClellan8_QLockstep: an
+ * 8-bit McClellan whose floating start state is not accelerated.
+ */
+bool can_lockstep_mcclellan(const NFA *nfa);
+
 } // namespace ue2
 
 #endif // MCCLELLANCOMPILE_H
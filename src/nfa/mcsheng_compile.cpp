@@ -142,11 +142,35 @@ u8 dfa_info::getAlphaShift() const {
     }
 }
 
+#define MAX_SHENG_STATES 16
+#define MAX_SHENG64_STATES 64
+
+/** \brief Layout details of the McSheng with a given engine structure. */
+template<typename T> struct McShengTraits;
+
+template<> struct McShengTraits<mcsheng> {
+    using mask_type = m128;
+    static constexpr NFAEngineType type_8 = MCSHENG_NFA_8;
+    static constexpr NFAEngineType type_16 = MCSHENG_NFA_16;
+    static constexpr u32 min_sheng_states = MIN_SHENG_SIZE;
+    static constexpr u32 max_sheng_states = MAX_SHENG_STATES;
+};
+
+template<> struct McShengTraits<mcsheng64> {
+    using mask_type = m512;
+    static constexpr NFAEngineType type_8 = MCSHENG_64_NFA_8;
+    static constexpr NFAEngineType type_16 = MCSHENG_64_NFA_16;
+    /* smaller regions are better served by the 16 state head */
+    static constexpr u32 min_sheng_states = MAX_SHENG_STATES + 1;
+    static constexpr u32 max_sheng_states = MAX_SHENG64_STATES;
+};
+
 } // namespace
 
+template<typename T>
 static
 mstate_aux *getAux(NFA *n, dstate_id_t i) {
-    mcsheng *m = (mcsheng *)getMutableImplNfa(n);
+    T *m = (T *)getMutableImplNfa(n);
     mstate_aux *aux_base = (mstate_aux *)((char *)n + m->aux_offset);
 
     mstate_aux *aux = aux_base + i;
@@ -154,14 +178,16 @@ mstate_aux *getAux(NFA *n, dstate_id_t i) {
     return aux;
 }
 
+template<typename T>
 static
-void createShuffleMasks(mcsheng *m, const dfa_info &info,
+void createShuffleMasks(T *m, const dfa_info &info,
                        dstate_id_t sheng_end,
                        const map<dstate_id_t, AccelScheme> &accel_escape_info) {
+    using mask_type = typename McShengTraits<T>::mask_type;
     DEBUG_PRINTF("using first %hu states for a sheng\n", sheng_end);
     assert(sheng_end > DEAD_STATE + 1);
-    assert(sheng_end <= sizeof(m128) + 1);
-    vector<array<u8, sizeof(m128)>> masks;
+    assert(sheng_end <= sizeof(mask_type) + 1);
+    vector<array<u8, sizeof(mask_type)>> masks;
     masks.resize(info.alpha_size);
     /* -1 to avoid wasting a slot as we do not include dead state */
     vector<dstate_id_t> raw_ids;
@@ -177,7 +203,7 @@ void createShuffleMasks(mcsheng *m, const dfa_info &info,
             continue;
         }
         auto &mask = masks[i];
-        assert(sizeof(mask) == sizeof(m128));
+        assert(sizeof(mask) == sizeof(mask_type));
         mask.fill(0);
 
         for (dstate_id_t sheng_id = 0; sheng_id < sheng_end - 1; sheng_id++) {
@@ -195,7 +221,7 @@ void createShuffleMasks(mcsheng *m, const dfa_info &info,
     for (u32 i = 0; i < N_CHARS; i++) {
         assert(info.alpha_remap[i] != info.alpha_remap[TOP]);
         memcpy((u8 *)&m->sheng_masks[i],
-               (u8 *)masks[info.alpha_remap[i]].data(), sizeof(m128));
+               (u8 *)masks[info.alpha_remap[i]].data(), sizeof(mask_type));
     }
     m->sheng_end = sheng_end;
     m->sheng_accel_limit = sheng_end - 1;
@@ -207,6 +233,7 @@ void createShuffleMasks(mcsheng *m, const dfa_info &info,
     }
 }
 
+template<typename T>
 static
 void populateBasicInfo(size_t state_size, const dfa_info &info,
                        u32 total_size, u32 aux_offset, u32 accel_offset,
@@ -220,12 +247,12 @@ void populateBasicInfo(size_t state_size, const dfa_info &info,
     nfa->streamStateSize = verify_u32(state_size);
 
     if (state_size == sizeof(u8)) {
-        nfa->type = MCSHENG_NFA_8;
+        nfa->type = McShengTraits<T>::type_8;
     } else {
-        nfa->type = MCSHENG_NFA_16;
+        nfa->type = McShengTraits<T>::type_16;
     }
 
-    mcsheng *m = (mcsheng *)getMutableImplNfa(nfa);
+    T *m = (T *)getMutableImplNfa(nfa);
     for (u32 i = 0; i < 256; i++) {
         m->remap[i] = verify_u8(info.alpha_remap[i]);
     }
@@ -381,7 +408,6 @@ CharReach get_edge_reach(dstate_id_t u, dstate_id_t v, const dfa_info &info) {
     return rv;
 }
 
-#define MAX_SHENG_STATES 16
 #define MAX_SHENG_LEAKINESS 0.05
 
 using LeakinessCache = ue2_unordered_map<pair<RdfaVertex, u32>, double>;
@@ -435,7 +461,14 @@ double leakiness(const RdfaGraph &g, dfa_info &info,
 
 static
 dstate_id_t find_sheng_states(dfa_info &info,
-                             map<dstate_id_t, AccelScheme> &accel_escape_info) {
+                              map<dstate_id_t, AccelScheme> &accel_escape_info,
+                              u32 min_sheng_states, u32 max_sheng_states) {
+    /* impl ids may be left over from building this dfa with a different
+     * sheng limit */
+    for (auto &ds : info.states) {
+        ds.impl_id = 0;
+    }
+
     RdfaGraph g(info.raw);
     auto cyclics = find_vertices_in_cycles(g);
 
@@ -470,7 +503,7 @@ dstate_id_t find_sheng_states(dfa_info &info,
     flat_set<dstate_id_t> considered = { DEAD_STATE };
     bool seen_back_edge = false;
     while (!to_consider.empty()
-           && sheng_states.size() < MAX_SHENG_STATES) {
+           && sheng_states.size() < max_sheng_states) {
         auto v = to_consider.front();
         to_consider.pop_front();
         if (!considered.insert(g[v].index).second) {
@@ -516,7 +549,7 @@ dstate_id_t find_sheng_states(dfa_info &info,
         }
     }
 
-    if (sheng_states.size() < MIN_SHENG_SIZE) {
+    if (sheng_states.size() < min_sheng_states) {
         DEBUG_PRINTF("sheng region too small\n");
         return DEAD_STATE;
     }
@@ -542,6 +575,7 @@ dstate_id_t find_sheng_states(dfa_info &info,
     return sheng_end;
 }
 
+template<typename T>
 static
 void fill_in_aux_info(NFA *nfa, const dfa_info &info,
                       const map<dstate_id_t, AccelScheme> &accel_escape_info,
@@ -550,7 +584,7 @@ void fill_in_aux_info(NFA *nfa, const dfa_info &info,
                       const vector<u32> &reports_eod,
                       u32 report_base_offset,
                       const raw_report_info &ri) {
-    mcsheng *m = (mcsheng *)getMutableImplNfa(nfa);
+    T *m = (T *)getMutableImplNfa(nfa);
 
     vector<u32> reportOffsets;
 
@@ -558,7 +592,7 @@ void fill_in_aux_info(NFA *nfa, const dfa_info &info,
 
     for (u32 i = 0; i < info.size(); i++) {
         u16 impl_id = info.implId(i);
-        mstate_aux *this_aux = getAux(nfa, impl_id);
+        mstate_aux *this_aux = getAux<T>(nfa, impl_id);
 
         fillInAux(this_aux, i, info, reports, reports_eod, reportOffsets);
         if (contains(accel_escape_info, i)) {
@@ -572,9 +606,10 @@ void fill_in_aux_info(NFA *nfa, const dfa_info &info,
     }
 }
 
+template<typename T>
 static
 u16 get_edge_flags(NFA *nfa, dstate_id_t target_impl_id) {
-    mstate_aux *aux = getAux(nfa, target_impl_id);
+    mstate_aux *aux = getAux<T>(nfa, target_impl_id);
     u16 flags = 0;
 
     if (aux->accept) {
@@ -588,11 +623,12 @@ u16 get_edge_flags(NFA *nfa, dstate_id_t target_impl_id) {
     return flags;
 }
 
+template<typename T>
 static
 void fill_in_succ_table_16(NFA *nfa, const dfa_info &info,
                            dstate_id_t sheng_end,
                            UNUSED dstate_id_t sherman_base) {
-    u16 *succ_table = (u16 *)((char *)nfa + sizeof(NFA) + sizeof(mcsheng));
+    u16 *succ_table = (u16 *)((char *)nfa + sizeof(NFA) + sizeof(T));
 
     u8 alphaShift = info.getAlphaShift();
     assert(alphaShift <= 8);
@@ -611,7 +647,7 @@ void fill_in_succ_table_16(NFA *nfa, const dfa_info &info,
             u16 &entry = succ_table[((size_t)normal_id << alphaShift) + s];
 
             entry = info.implId(raw_succ);
-            entry |= get_edge_flags(nfa, entry);
+            entry |= get_edge_flags<T>(nfa, entry);
         }
     }
 }
@@ -780,10 +816,11 @@ bool is_cyclic_near(const raw_dfa &raw, dstate_id_t root) {
     return false;
 }
 
+template<typename T>
 static
 void fill_in_sherman(NFA *nfa, dfa_info &info, UNUSED u16 sherman_limit) {
     char *nfa_base = (char *)nfa;
-    mcsheng *m = (mcsheng *)getMutableImplNfa(nfa);
+    T *m = (T *)getMutableImplNfa(nfa);
     char *sherman_table = nfa_base + m->sherman_offset;
 
     assert(ISALIGNED_16(sherman_table));
@@ -822,13 +859,14 @@ void fill_in_sherman(NFA *nfa, dfa_info &info, UNUSED u16 sherman_limit) {
                              info.implId(d),
                              info.implId(info.states[i].next[s]));
                 u16 entry_val = info.implId(info.states[i].next[s]);
-                entry_val |= get_edge_flags(nfa, entry_val);
+                entry_val |= get_edge_flags<T>(nfa, entry_val);
                 unaligned_store_u16((u8 *)states++, entry_val);
             }
         }
     }
 }
 
+template<typename T>
 static
 bytecode_ptr<NFA> mcshengCompile16(dfa_info &info, dstate_id_t sheng_end,
                         const map<dstate_id_t, AccelScheme> &accel_escape_info,
@@ -869,7 +907,7 @@ bytecode_ptr<NFA> mcshengCompile16(dfa_info &info, dstate_id_t sheng_end,
 
     size_t aux_size = sizeof(mstate_aux) * info.size();
 
-    size_t aux_offset = ROUNDUP_16(sizeof(NFA) + sizeof(mcsheng) + tran_size);
+    size_t aux_offset = ROUNDUP_16(sizeof(NFA) + sizeof(T) + tran_size);
     size_t accel_size = info.strat.accelSize() * accel_escape_info.size();
     size_t accel_offset = ROUNDUP_N(aux_offset + aux_size
                                     + ri->getReportListSize(), 32);
@@ -882,10 +920,11 @@ bytecode_ptr<NFA> mcshengCompile16(dfa_info &info, dstate_id_t sheng_end,
     assert(ISALIGNED_N(accel_offset, alignof(union AccelAux)));
 
     auto nfa = make_zeroed_bytecode_ptr<NFA>(total_size);
-    mcsheng *m = (mcsheng *)getMutableImplNfa(nfa.get());
+    T *m = (T *)getMutableImplNfa(nfa.get());
 
-    populateBasicInfo(sizeof(u16), info, total_size, aux_offset, accel_offset,
-                      accel_escape_info.size(), arb, single, nfa.get());
+    populateBasicInfo<T>(sizeof(u16), info, total_size, aux_offset,
+                         accel_offset, accel_escape_info.size(), arb, single,
+                         nfa.get());
     createShuffleMasks(m, info, sheng_end, accel_escape_info);
 
     /* copy in the mc header information */
@@ -896,21 +935,22 @@ bytecode_ptr<NFA> mcshengCompile16(dfa_info &info, dstate_id_t sheng_end,
     DEBUG_PRINTF("%hu sheng, %hu norm, %zu total\n", sheng_end,
                  count_real_states, info.size());
 
-    fill_in_aux_info(nfa.get(), info, accel_escape_info, accel_offset,
-                     sherman_offset - sizeof(NFA), reports, reports_eod,
-                     aux_offset + aux_size, *ri);
+    fill_in_aux_info<T>(nfa.get(), info, accel_escape_info, accel_offset,
+                        sherman_offset - sizeof(NFA), reports, reports_eod,
+                        aux_offset + aux_size, *ri);
 
-    fill_in_succ_table_16(nfa.get(), info, sheng_end, sherman_limit);
+    fill_in_succ_table_16<T>(nfa.get(), info, sheng_end, sherman_limit);
 
-    fill_in_sherman(nfa.get(), info, sherman_limit);
+    fill_in_sherman<T>(nfa.get(), info, sherman_limit);
 
     return nfa;
 }
 
+template<typename T>
 static
 void fill_in_succ_table_8(NFA *nfa, const dfa_info &info,
                           dstate_id_t sheng_end) {
-    u8 *succ_table = (u8 *)nfa + sizeof(NFA) + sizeof(mcsheng);
+    u8 *succ_table = (u8 *)nfa + sizeof(NFA) + sizeof(T);
 
     u8 alphaShift = info.getAlphaShift();
     assert(alphaShift <= 8);
@@ -975,6 +1015,7 @@ void allocateImplId8(dfa_info &info, dstate_id_t sheng_end,
     }
 }
 
+template<typename T>
 static
 bytecode_ptr<NFA> mcshengCompile8(dfa_info &info, dstate_id_t sheng_end,
                        const map<dstate_id_t, AccelScheme> &accel_escape_info) {
@@ -991,7 +1032,7 @@ bytecode_ptr<NFA> mcshengCompile8(dfa_info &info, dstate_id_t sheng_end,
 
     size_t tran_size = sizeof(u8) * (1 << info.getAlphaShift()) * normal_count;
     size_t aux_size = sizeof(mstate_aux) * info.size();
-    size_t aux_offset = ROUNDUP_16(sizeof(NFA) + sizeof(mcsheng) + tran_size);
+    size_t aux_offset = ROUNDUP_16(sizeof(NFA) + sizeof(T) + tran_size);
     size_t accel_size = info.strat.accelSize() * accel_escape_info.size();
     size_t accel_offset = ROUNDUP_N(aux_offset + aux_size
                                      + ri->getReportListSize(), 32);
@@ -1008,32 +1049,31 @@ bytecode_ptr<NFA> mcshengCompile8(dfa_info &info, dstate_id_t sheng_end,
     assert(ISALIGNED_N(accel_offset, alignof(union AccelAux)));
 
     auto nfa = make_zeroed_bytecode_ptr<NFA>(total_size);
-    mcsheng *m = (mcsheng *)getMutableImplNfa(nfa.get());
+    T *m = (T *)getMutableImplNfa(nfa.get());
 
     allocateImplId8(info, sheng_end, accel_escape_info, &m->accel_limit_8,
                     &m->accept_limit_8);
 
-    populateBasicInfo(sizeof(u8), info, total_size, aux_offset, accel_offset,
-                      accel_escape_info.size(), arb, single, nfa.get());
+    populateBasicInfo<T>(sizeof(u8), info, total_size, aux_offset,
+                         accel_offset, accel_escape_info.size(), arb, single,
+                         nfa.get());
     createShuffleMasks(m, info, sheng_end, accel_escape_info);
 
-    fill_in_aux_info(nfa.get(), info, accel_escape_info, accel_offset,
-                     total_size - sizeof(NFA), reports, reports_eod,
-                     aux_offset + aux_size, *ri);
+    fill_in_aux_info<T>(nfa.get(), info, accel_escape_info, accel_offset,
+                        total_size - sizeof(NFA), reports, reports_eod,
+                        aux_offset + aux_size, *ri);
 
-    fill_in_succ_table_8(nfa.get(), info, sheng_end);
+    fill_in_succ_table_8<T>(nfa.get(), info, sheng_end);
 
     DEBUG_PRINTF("rl size %zu\n", ri->size());
 
     return nfa;
 }
 
-bytecode_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc,
-                                 const ReportManager &rm) {
-    if (!cc.grey.allowMcSheng) {
-        return nullptr;
-    }
-
+template<typename T>
+static
+bytecode_ptr<NFA> mcshengCompile_int(raw_dfa &raw, const CompileContext &cc,
+                                     const ReportManager &rm) {
     mcclellan_build_strat mbs(raw, rm, false);
     dfa_info info(mbs);
     bool using8bit = cc.grey.allowMcClellan8 && info.size() <= 256;
@@ -1048,16 +1088,21 @@ bytecode_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc,
     map<dstate_id_t, AccelScheme> accel_escape_info
         = info.strat.getAccelInfo(cc.grey);
 
-    dstate_id_t sheng_end = find_sheng_states(info, accel_escape_info);
+    u32 min_sheng_states = McShengTraits<T>::min_sheng_states;
+    u32 max_sheng_states = McShengTraits<T>::max_sheng_states;
+    dstate_id_t sheng_end = find_sheng_states(info, accel_escape_info,
+                                              min_sheng_states,
+                                              max_sheng_states);
     if (sheng_end <= DEAD_STATE + 1) {
         return nullptr;
     }
 
     bytecode_ptr<NFA> nfa;
     if (!using8bit) {
-        nfa = mcshengCompile16(info, sheng_end, accel_escape_info, cc.grey);
+        nfa = mcshengCompile16<T>(info, sheng_end, accel_escape_info,
+                                  cc.grey);
     } else {
-        nfa = mcshengCompile8(info, sheng_end, accel_escape_info);
+        nfa = mcshengCompile8<T>(info, sheng_end, accel_escape_info);
     }
 
     if (!nfa) {
@@ -1072,6 +1117,29 @@ bytecode_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc,
     return nfa;
 }
 
+bytecode_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc,
+                                 const ReportManager &rm) {
+    if (!cc.grey.allowMcSheng) {
+        return nullptr;
+    }
+
+    return mcshengCompile_int<mcsheng>(raw, cc, rm);
+}
+
+bytecode_ptr<NFA> mcshengCompile64(raw_dfa &raw, const CompileContext &cc,
+                                   const ReportManager &rm) {
+    if (!cc.grey.allowMcSheng || !cc.grey.allowMcSheng64) {
+        return nullptr;
+    }
+
+    if (!cc.target_info.has_avx512vbmi()) {
+        DEBUG_PRINTF("McSheng64 requires AVX512VBMI\n");
+        return nullptr;
+    }
+
+    return mcshengCompile_int<mcsheng64>(raw, cc, rm);
+}
+
 bool has_accel_mcsheng(const NFA *) {
     return true; /* consider the sheng region as accelerated */
 }
@@ -43,6 +43,16 @@ struct raw_dfa;
 bytecode_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc,
                                  const ReportManager &rm);
 
+/**
+ * \brief Builds a McSheng with a sheng region of up to 64 states, for
+ * targets with AVX-512 VBMI.
+ *
+ * Returns nullptr if the sheng region found would fit the head of a normal
+ * McSheng, which is cheaper to run.
+ */
+bytecode_ptr<NFA> mcshengCompile64(raw_dfa &raw, const CompileContext &cc,
+                                   const ReportManager &rm);
+
 bool has_accel_mcsheng(const NFA *nfa);
 
 } // namespace ue2
@@ -56,9 +56,28 @@ using namespace std;
 
 namespace ue2 {
 
+namespace {
+
+template<typename T> struct McShengDumpTraits;
+
+template<> struct McShengDumpTraits<mcsheng> {
+    static constexpr NFAEngineType type_8 = MCSHENG_NFA_8;
+    static constexpr NFAEngineType type_16 = MCSHENG_NFA_16;
+    static constexpr const char *name = "mcsheng";
+};
+
+template<> struct McShengDumpTraits<mcsheng64> {
+    static constexpr NFAEngineType type_8 = MCSHENG_64_NFA_8;
+    static constexpr NFAEngineType type_16 = MCSHENG_64_NFA_16;
+    static constexpr const char *name = "mcsheng 64";
+};
+
+} // namespace
+
+template<typename T>
 static
 const mstate_aux *getAux(const NFA *n, dstate_id_t i) {
-    auto *m = (const mcsheng *)getImplNfa(n);
+    auto *m = (const T *)getImplNfa(n);
     auto *aux_base = (const mstate_aux *)((const char *)n + m->aux_offset);
 
     const mstate_aux *aux = aux_base + i;
@@ -67,10 +86,11 @@ const mstate_aux *getAux(const NFA *n, dstate_id_t i) {
     return aux;
 }
 
+template<typename T>
 static
 void next_states(const NFA *n, u16 s, u16 *t) {
-    const mcsheng *m = (const mcsheng *)getImplNfa(n);
-    const mstate_aux *aux = getAux(n, s);
+    const T *m = (const T *)getImplNfa(n);
+    const mstate_aux *aux = getAux<T>(n, s);
     const u32 as = m->alphaShift;
     assert(s != DEAD_STATE);
 
@@ -78,7 +98,7 @@ void next_states(const NFA *n, u16 s, u16 *t) {
         for (u16 c = 0; c < N_CHARS; c++) {
             u8 sheng_s = s - 1;
             auto trans_for_c = (const char *)&m->sheng_masks[c];
-            assert(sheng_s < sizeof(m128));
+            assert(sheng_s < sizeof(m->sheng_masks[c]));
             u8 raw_succ = trans_for_c[sheng_s];
             if (raw_succ == m->sheng_end - 1) {
                 t[c] = DEAD_STATE;
@@ -88,8 +108,8 @@ void next_states(const NFA *n, u16 s, u16 *t) {
                 t[c] = raw_succ;
             }
         }
-    } else  if (n->type == MCSHENG_NFA_8) {
-        const u8 *succ_table = (const u8 *)((const char *)m + sizeof(mcsheng));
+    } else  if (n->type == McShengDumpTraits<T>::type_8) {
+        const u8 *succ_table = (const u8 *)((const char *)m + sizeof(T));
         for (u16 c = 0; c < N_CHARS; c++) {
             u32 normal_id = s - m->sheng_end;
             t[c] = succ_table[(normal_id << as) + m->remap[c]];
@@ -105,8 +125,7 @@ void next_states(const NFA *n, u16 s, u16 *t) {
             assert(base_s >= m->sheng_end);
         }
 
-        const u16 *succ_table = (const u16 *)((const char *)m
-                                              + sizeof(mcsheng));
+        const u16 *succ_table = (const u16 *)((const char *)m + sizeof(T));
         for (u16 c = 0; c < N_CHARS; c++) {
             u32 normal_id = base_s - m->sheng_end;
             t[c] = succ_table[(normal_id << as) + m->remap[c]];
@@ -138,8 +157,9 @@ void next_states(const NFA *n, u16 s, u16 *t) {
     t[TOP] = aux->top & STATE_MASK;
 }
 
+template<typename T>
 static
-void describeEdge(FILE *f, const mcsheng *m, const u16 *t, u16 i) {
+void describeEdge(FILE *f, const T *m, const u16 *t, u16 i) {
     for (u16 s = 0; s < N_CHARS; s++) {
         if (!t[s]) {
             continue;
@@ -196,9 +216,10 @@ void dumpAccelDot(FILE *f, u16 i, const union AccelAux *accel) {
     }
 }
 
+template<typename T>
 static
-void describeNode(const NFA *n, const mcsheng *m, u16 i, FILE *f) {
-    const mstate_aux *aux = getAux(n, i);
+void describeNode(const NFA *n, const T *m, u16 i, FILE *f) {
+    const mstate_aux *aux = getAux<T>(n, i);
 
     bool isSherman = m->sherman_limit && i >= m->sherman_limit;
 
@@ -267,9 +288,10 @@ void dumpDotPreambleDfa(FILE *f) {
     fprintf(f, "subgraph cluster_sheng { style = dashed }\n");
 }
 
+template<typename T>
 static
 void dump_dot_16(const NFA *nfa, FILE *f) {
-    auto  *m = (const mcsheng *)getImplNfa(nfa);
+    auto  *m = (const T *)getImplNfa(nfa);
 
     dumpDotPreambleDfa(f);
 
@@ -278,7 +300,7 @@ void dump_dot_16(const NFA *nfa, FILE *f) {
 
         u16 t[ALPHABET_SIZE];
 
-        next_states(nfa, i, t);
+        next_states<T>(nfa, i, t);
 
         describeEdge(f, m, t, i);
     }
@@ -286,9 +308,10 @@ void dump_dot_16(const NFA *nfa, FILE *f) {
     fprintf(f, "}\n");
 }
 
+template<typename T>
 static
 void dump_dot_8(const NFA *nfa, FILE *f) {
-    auto m = (const mcsheng *)getImplNfa(nfa);
+    auto m = (const T *)getImplNfa(nfa);
 
     dumpDotPreambleDfa(f);
 
@@ -297,7 +320,7 @@ void dump_dot_8(const NFA *nfa, FILE *f) {
 
         u16 t[ALPHABET_SIZE];
 
-        next_states(nfa, i, t);
+        next_states<T>(nfa, i, t);
 
         describeEdge(f, m, t, i);
     }
@@ -305,8 +328,9 @@ void dump_dot_8(const NFA *nfa, FILE *f) {
     fprintf(f, "}\n");
 }
 
+template<typename T>
 static
-void dumpAccelMasks(FILE *f, const mcsheng *m, const mstate_aux *aux) {
+void dumpAccelMasks(FILE *f, const T *m, const mstate_aux *aux) {
     fprintf(f, "\n");
     fprintf(f, "Acceleration\n");
     fprintf(f, "------------\n");
@@ -322,8 +346,9 @@ void dumpAccelMasks(FILE *f, const mcsheng *m, const mstate_aux *aux) {
     }
 }
 
+template<typename T>
 static
-void describeAlphabet(FILE *f, const mcsheng *m) {
+void describeAlphabet(FILE *f, const T *m) {
     map<u8, CharReach> rev;
 
     for (u16 i = 0; i < N_CHARS; i++) {
@@ -344,8 +369,9 @@ void describeAlphabet(FILE *f, const mcsheng *m) {
     fprintf(f, "\n");
 }
 
+template<typename T>
 static
-void dumpCommonHeader(FILE *f, const mcsheng *m) {
+void dumpCommonHeader(FILE *f, const T *m) {
     fprintf(f, "report: %u, states: %u, length: %u\n", m->arb_report,
             m->state_count, m->length);
     fprintf(f, "astart: %hu, fstart: %hu\n", m->start_anchored,
@@ -356,12 +382,13 @@ void dumpCommonHeader(FILE *f, const mcsheng *m) {
     fprintf(f, "sheng_accel_limit: %hu\n", m->sheng_accel_limit);
 }
 
+template<typename T>
 static
 void dump_text_16(const NFA *nfa, FILE *f) {
-    auto *m = (const mcsheng *)getImplNfa(nfa);
+    auto *m = (const T *)getImplNfa(nfa);
     auto *aux = (const mstate_aux *)((const char *)nfa + m->aux_offset);
 
-    fprintf(f, "mcsheng 16\n");
+    fprintf(f, "%s 16\n", McShengDumpTraits<T>::name);
     dumpCommonHeader(f, m);
     fprintf(f, "sherman_limit: %d, sherman_end: %d\n", (int)m->sherman_limit,
             (int)m->sherman_end);
@@ -374,12 +401,13 @@ void dump_text_16(const NFA *nfa, FILE *f) {
     dumpTextReverse(nfa, f);
 }
 
+template<typename T>
 static
 void dump_text_8(const NFA *nfa, FILE *f) {
-    auto m = (const mcsheng *)getImplNfa(nfa);
+    auto m = (const T *)getImplNfa(nfa);
     auto aux = (const mstate_aux *)((const char *)nfa + m->aux_offset);
 
-    fprintf(f, "mcsheng 8\n");
+    fprintf(f, "%s 8\n", McShengDumpTraits<T>::name);
     dumpCommonHeader(f, m);
     fprintf(f, "accel_limit: %hu, accept_limit %hu\n", m->accel_limit_8,
             m->accept_limit_8);
@@ -394,14 +422,26 @@ void dump_text_8(const NFA *nfa, FILE *f) {
 
 void nfaExecMcSheng16_dump(const NFA *nfa, const string &base) {
     assert(nfa->type == MCSHENG_NFA_16);
-    dump_text_16(nfa, StdioFile(base + ".txt", "w"));
-    dump_dot_16(nfa, StdioFile(base + ".dot", "w"));
+    dump_text_16<mcsheng>(nfa, StdioFile(base + ".txt", "w"));
+    dump_dot_16<mcsheng>(nfa, StdioFile(base + ".dot", "w"));
 }
 
 void nfaExecMcSheng8_dump(const NFA *nfa, const string &base) {
     assert(nfa->type == MCSHENG_NFA_8);
-    dump_text_8(nfa, StdioFile(base + ".txt", "w"));
-    dump_dot_8(nfa, StdioFile(base + ".dot", "w"));
+    dump_text_8<mcsheng>(nfa, StdioFile(base + ".txt", "w"));
+    dump_dot_8<mcsheng>(nfa, StdioFile(base + ".dot", "w"));
+}
+
+void nfaExecMcSheng64_16_dump(const NFA *nfa, const string &base) {
+    assert(nfa->type == MCSHENG_64_NFA_16);
+    dump_text_16<mcsheng64>(nfa, StdioFile(base + ".txt", "w"));
+    dump_dot_16<mcsheng64>(nfa, StdioFile(base + ".dot", "w"));
+}
+
+void nfaExecMcSheng64_8_dump(const NFA *nfa, const string &base) {
+    assert(nfa->type == MCSHENG_64_NFA_8);
+    dump_text_8<mcsheng64>(nfa, StdioFile(base + ".txt", "w"));
+    dump_dot_8<mcsheng64>(nfa, StdioFile(base + ".dot", "w"));
 }
 
 } // namespace ue2
@@ -33,17 +33,27 @@
  *  - DEAD_FUNC     (name of the function checking for dead states)
  *  - ACCEPT_FUNC   (name of the function checking for accept state)
  *  - STOP_AT_MATCH (can be 1 or 0, enable or disable stop at match)
+ *
+ * as well as the width-specific definitions:
+ *
+ *  - SHENG_TYPE    (sheng, sheng32 or sheng64)
+ *  - STATE_VEC     (vector type holding the state and the shuffle masks)
+ *  - SET_STATE     (broadcast a state into a STATE_VEC)
+ *  - SHUFFLE_FUNC  (shuffle mask lookup giving the successor state)
+ *  - MOVD_FUNC     (extract the state from a STATE_VEC)
+ *  - STATE_MASK    (mask of the state id bits)
+ *  - FIRE_REPORTS  (report firing function for SHENG_TYPE)
  */
 
 /* byte-by-byte version. we don't do byte-by-byte death checking as it's
  * pretty pointless to do it over a buffer that's at most 3 bytes long */
 static really_inline
-char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
+char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct SHENG_TYPE *s,
                 u8 *const cached_accept_state, ReportID *const cached_accept_id,
                 u8 single, u64a base_offset, const u8 *buf, const u8 *start,
                 const u8 *end, const u8 **scan_end) {
     DEBUG_PRINTF("Starting DFA execution in state %u\n",
-                 *state & SHENG_STATE_MASK);
+                 *state & STATE_MASK);
     const u8 *cur_buf = start;
     if (DEAD_FUNC(*state)) {
         DEBUG_PRINTF("Dead on arrival\n");
@@ -52,21 +62,21 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
     }
     DEBUG_PRINTF("Scanning %lli bytes\n", (s64a)(end - start));
 
-    m128 cur_state = set16x8(*state);
-    const m128 *masks = s->shuffle_masks;
+    STATE_VEC cur_state = SET_STATE(*state);
+    const STATE_VEC *masks = s->shuffle_masks;
 
     while (likely(cur_buf != end)) {
         const u8 c = *cur_buf;
-        const m128 shuffle_mask = masks[c];
-        cur_state = pshufb_m128(shuffle_mask, cur_state);
-        const u8 tmp = movd(cur_state);
+        const STATE_VEC shuffle_mask = masks[c];
+        cur_state = SHUFFLE_FUNC(shuffle_mask, cur_state);
+        const u8 tmp = MOVD_FUNC(cur_state);
 
         DEBUG_PRINTF("c: %02hhx '%c'\n", c, ourisprint(c) ? c : '?');
         DEBUG_PRINTF("s: %u (hi: %u lo: %u)\n", tmp, (tmp & 0xF0) >> 4,
                      tmp & 0xF);
 
         if (unlikely(ACCEPT_FUNC(tmp))) {
-            DEBUG_PRINTF("Accept state %u reached\n", tmp & SHENG_STATE_MASK);
+            DEBUG_PRINTF("Accept state %u reached\n", tmp & STATE_MASK);
             u64a match_offset = base_offset + (cur_buf - buf) + 1;
             DEBUG_PRINTF("Match @ %llu\n", match_offset);
             if (STOP_AT_MATCH) {
@@ -82,7 +92,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
                     return MO_HALT_MATCHING;
                 }
             } else {
-                if (fireReports(s, cb, ctxt, tmp, match_offset,
+                if (FIRE_REPORTS(s, cb, ctxt, tmp, match_offset,
                                 cached_accept_state, cached_accept_id,
                                 0) == MO_HALT_MATCHING) {
                     return MO_HALT_MATCHING;
@@ -91,7 +101,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
         }
         cur_buf++;
     }
-    *state = movd(cur_state);
+    *state = MOVD_FUNC(cur_state);
     *scan_end = cur_buf;
     return MO_CONTINUE_MATCHING;
 }
@@ -38,6 +38,17 @@
  *  - OUTER_ACCEL_FUNC  (name of the outer function checking for accel states)
  *  - ACCEPT_FUNC       (name of the function checking for accept state)
  *  - STOP_AT_MATCH     (can be 1 or 0, enable or disable stop at match)
+ *
+ * as well as the width-specific definitions:
+ *
+ *  - SHENG_TYPE    (sheng, sheng32 or sheng64)
+ *  - STATE_VEC     (vector type holding the state and the shuffle masks)
+ *  - SET_STATE     (broadcast a state into a STATE_VEC)
+ *  - SHUFFLE_FUNC  (shuffle mask lookup giving the successor state)
+ *  - MOVD_FUNC     (extract the state from a STATE_VEC)
+ *  - STATE_MASK    (mask of the state id bits)
+ *  - FIRE_REPORTS  (report firing function for SHENG_TYPE)
+ *  - GET_ACCEL     (accel aux lookup function for SHENG_TYPE)
  */
 
 /* unrolled 4-byte-at-a-time version.
@@ -54,12 +65,12 @@
  * problem.
  */
 static really_inline
-char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
+char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct SHENG_TYPE *s,
                 u8 *const cached_accept_state, ReportID *const cached_accept_id,
                 u8 single, u64a base_offset, const u8 *buf, const u8 *start,
                 const u8 *end, const u8 **scan_end) {
     DEBUG_PRINTF("Starting DFAx4 execution in state %u\n",
-                 *state & SHENG_STATE_MASK);
+                 *state & STATE_MASK);
     const u8 *cur_buf = start;
     const u8 *min_accel_dist = start;
     base_offset++;
@@ -67,7 +78,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
 
     if (INNER_ACCEL_FUNC(*state) || OUTER_ACCEL_FUNC(*state)) {
         DEBUG_PRINTF("Accel state reached @ 0\n");
-        const union AccelAux *aaux = get_accel(s, *state & SHENG_STATE_MASK);
+        const union AccelAux *aaux = GET_ACCEL(s, *state & STATE_MASK);
         const u8 *new_offset = run_accel(aaux, cur_buf, end);
         if (new_offset < cur_buf + BAD_ACCEL_DIST) {
             min_accel_dist = new_offset + BIG_ACCEL_PENALTY;
@@ -86,8 +97,8 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
         return MO_CONTINUE_MATCHING;
     }
 
-    m128 cur_state = set16x8(*state);
-    const m128 *masks = s->shuffle_masks;
+    STATE_VEC cur_state = SET_STATE(*state);
+    const STATE_VEC *masks = s->shuffle_masks;
 
     while (likely(end - cur_buf >= 4)) {
         const u8 *b1 = cur_buf;
@@ -99,21 +110,21 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
         const u8 c3 = *b3;
         const u8 c4 = *b4;
 
-        const m128 shuffle_mask1 = masks[c1];
-        cur_state = pshufb_m128(shuffle_mask1, cur_state);
-        const u8 a1 = movd(cur_state);
+        const STATE_VEC shuffle_mask1 = masks[c1];
+        cur_state = SHUFFLE_FUNC(shuffle_mask1, cur_state);
+        const u8 a1 = MOVD_FUNC(cur_state);
 
-        const m128 shuffle_mask2 = masks[c2];
-        cur_state = pshufb_m128(shuffle_mask2, cur_state);
-        const u8 a2 = movd(cur_state);
+        const STATE_VEC shuffle_mask2 = masks[c2];
+        cur_state = SHUFFLE_FUNC(shuffle_mask2, cur_state);
+        const u8 a2 = MOVD_FUNC(cur_state);
 
-        const m128 shuffle_mask3 = masks[c3];
-        cur_state = pshufb_m128(shuffle_mask3, cur_state);
-        const u8 a3 = movd(cur_state);
+        const STATE_VEC shuffle_mask3 = masks[c3];
+        cur_state = SHUFFLE_FUNC(shuffle_mask3, cur_state);
+        const u8 a3 = MOVD_FUNC(cur_state);
 
-        const m128 shuffle_mask4 = masks[c4];
-        cur_state = pshufb_m128(shuffle_mask4, cur_state);
-        const u8 a4 = movd(cur_state);
+        const STATE_VEC shuffle_mask4 = masks[c4];
+        cur_state = SHUFFLE_FUNC(shuffle_mask4, cur_state);
+        const u8 a4 = MOVD_FUNC(cur_state);
 
         DEBUG_PRINTF("c: %02hhx '%c'\n", c1, ourisprint(c1) ? c1 : '?');
         DEBUG_PRINTF("s: %u (hi: %u lo: %u)\n", a1, (a1 & 0xF0) >> 4, a1 & 0xF);
@@ -131,7 +142,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
             if (ACCEPT_FUNC(a1)) {
                 u64a match_offset = base_offset + b1 - buf;
                 DEBUG_PRINTF("Accept state %u reached\n",
-                             a1 & SHENG_STATE_MASK);
+                             a1 & STATE_MASK);
                 DEBUG_PRINTF("Match @ %llu\n", match_offset);
                 if (STOP_AT_MATCH) {
                     DEBUG_PRINTF("Stopping at match @ %lli\n",
@@ -146,7 +157,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
                         return MO_HALT_MATCHING;
                     }
                 } else {
-                    if (fireReports(s, cb, ctxt, a1, match_offset,
+                    if (FIRE_REPORTS(s, cb, ctxt, a1, match_offset,
                                     cached_accept_state, cached_accept_id,
                                     0) == MO_HALT_MATCHING) {
                         return MO_HALT_MATCHING;
@@ -156,7 +167,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
             if (ACCEPT_FUNC(a2)) {
                 u64a match_offset = base_offset + b2 - buf;
                 DEBUG_PRINTF("Accept state %u reached\n",
-                             a2 & SHENG_STATE_MASK);
+                             a2 & STATE_MASK);
                 DEBUG_PRINTF("Match @ %llu\n", match_offset);
                 if (STOP_AT_MATCH) {
                     DEBUG_PRINTF("Stopping at match @ %lli\n",
@@ -171,7 +182,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
                         return MO_HALT_MATCHING;
                     }
                 } else {
-                    if (fireReports(s, cb, ctxt, a2, match_offset,
+                    if (FIRE_REPORTS(s, cb, ctxt, a2, match_offset,
                                     cached_accept_state, cached_accept_id,
                                     0) == MO_HALT_MATCHING) {
                         return MO_HALT_MATCHING;
@@ -181,7 +192,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
             if (ACCEPT_FUNC(a3)) {
                 u64a match_offset = base_offset + b3 - buf;
                 DEBUG_PRINTF("Accept state %u reached\n",
-                             a3 & SHENG_STATE_MASK);
+                             a3 & STATE_MASK);
                 DEBUG_PRINTF("Match @ %llu\n", match_offset);
                 if (STOP_AT_MATCH) {
                     DEBUG_PRINTF("Stopping at match @ %lli\n",
@@ -196,7 +207,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
                         return MO_HALT_MATCHING;
                     }
                 } else {
-                    if (fireReports(s, cb, ctxt, a3, match_offset,
+                    if (FIRE_REPORTS(s, cb, ctxt, a3, match_offset,
                                     cached_accept_state, cached_accept_id,
                                     0) == MO_HALT_MATCHING) {
                         return MO_HALT_MATCHING;
@@ -206,7 +217,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
             if (ACCEPT_FUNC(a4)) {
                 u64a match_offset = base_offset + b4 - buf;
                 DEBUG_PRINTF("Accept state %u reached\n",
-                             a4 & SHENG_STATE_MASK);
+                             a4 & STATE_MASK);
                 DEBUG_PRINTF("Match @ %llu\n", match_offset);
                 if (STOP_AT_MATCH) {
                     DEBUG_PRINTF("Stopping at match @ %lli\n",
@@ -221,7 +232,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
                         return MO_HALT_MATCHING;
                     }
                 } else {
-                    if (fireReports(s, cb, ctxt, a4, match_offset,
+                    if (FIRE_REPORTS(s, cb, ctxt, a4, match_offset,
                                     cached_accept_state, cached_accept_id,
                                     0) == MO_HALT_MATCHING) {
                         return MO_HALT_MATCHING;
@@ -237,7 +248,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
             if (cur_buf > min_accel_dist && INNER_ACCEL_FUNC(a4)) {
                 DEBUG_PRINTF("Accel state reached @ %lli\n", (s64a)(b4 - buf));
                 const union AccelAux *aaux =
-                    get_accel(s, a4 & SHENG_STATE_MASK);
+                    GET_ACCEL(s, a4 & STATE_MASK);
                 const u8 *new_offset = run_accel(aaux, cur_buf + 4, end);
                 if (new_offset < cur_buf + 4 + BAD_ACCEL_DIST) {
                     min_accel_dist = new_offset + BIG_ACCEL_PENALTY;
@@ -261,7 +272,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
         };
         if (cur_buf > min_accel_dist && OUTER_ACCEL_FUNC(a4)) {
             DEBUG_PRINTF("Accel state reached @ %lli\n", (s64a)(b4 - buf));
-            const union AccelAux *aaux = get_accel(s, a4 & SHENG_STATE_MASK);
+            const union AccelAux *aaux = GET_ACCEL(s, a4 & STATE_MASK);
             const u8 *new_offset = run_accel(aaux, cur_buf + 4, end);
             if (new_offset < cur_buf + 4 + BAD_ACCEL_DIST) {
                 min_accel_dist = new_offset + BIG_ACCEL_PENALTY;
@@ -278,7 +289,7 @@ char SHENG_IMPL(u8 *state, NfaCallback cb, void *ctxt, const struct sheng *s,
         };
         cur_buf += 4;
     }
-    *state = movd(cur_state);
+    *state = MOVD_FUNC(cur_state);
     *scan_end = cur_buf;
     return MO_CONTINUE_MATCHING;
 }
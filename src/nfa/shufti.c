@@ -33,6 +33,7 @@
  */
 
 #include "shufti.h"
+#include "accel.h"
 #include "ue2common.h"
 #include "util/arch.h"
 #include "util/bitutils.h"
@@ -1095,3 +1096,114 @@ const u8 *shuftiDoubleExec(m128 mask1_lo, m128 mask1_hi,
     return buf_end;
 }
 #endif
+
+/* Multi-byte shufti only needs 128-bit vectors: the work is in combining the
+ * classes within a block, and blocks overlap by the sequence length. */
+
+#if defined(DEBUG) && defined(HAVE_AVX2)
+DUMP_MSK(128)
+#endif
+
+static really_inline
+m128 mshuftiMiss(m128 t1, m128 t2, m128 b1, m128 b2, const m128 zeroes) {
+    return eq128(or128(and128(t1, b1), and128(t2, b2)), zeroes);
+}
+
+/* Returns a mask with a bit clear at each position in chars where a match may
+ * start. */
+static really_inline
+u32 mshuftiBlock(m128 mask1_lo, m128 mask1_hi, m128 mask2_lo, m128 mask2_hi,
+                 const m128 *b1, const m128 *b2, m128 chars,
+                 const m128 low4bits, const m128 zeroes, const u32 len) {
+    m128 chars_lo = and128(chars, low4bits);
+    m128 chars_hi = rshift64_m128(andnot128(low4bits, chars), 4);
+    m128 t1 = and128(pshufb_m128(mask1_lo, chars_lo),
+                     pshufb_m128(mask1_hi, chars_hi));
+    m128 t2 = and128(pshufb_m128(mask2_lo, chars_lo),
+                     pshufb_m128(mask2_hi, chars_hi));
+
+    /* a miss on any class rules out the sequence; bytes shifted in from
+     * beyond the block count as hits */
+    m128 miss = mshuftiMiss(t1, t2, b1[1], b2[1], zeroes);
+    miss = or128(miss, rshiftbyte_m128(mshuftiMiss(t1, t2, b1[2], b2[2],
+                                                   zeroes), 1));
+    miss = or128(miss, rshiftbyte_m128(mshuftiMiss(t1, t2, b1[3], b2[3],
+                                                   zeroes), 2));
+    if (len == 4) {
+        miss = or128(miss, rshiftbyte_m128(mshuftiMiss(t1, t2, b1[4], b2[4],
+                                                       zeroes), 3));
+    }
+    miss = and128(miss, mshuftiMiss(t1, t2, b1[0], b2[0], zeroes));
+
+#ifdef DEBUG
+    DEBUG_PRINTF(" chars: "); dumpMsk128AsChars(chars); printf("\n");
+    DEBUG_PRINTF("    t1: "); dumpMsk128(t1);           printf("\n");
+    DEBUG_PRINTF("    t2: "); dumpMsk128(t2);           printf("\n");
+    DEBUG_PRINTF("  miss: "); dumpMsk128(miss);         printf("\n");
+#endif
+
+    return movemask128(miss);
+}
+
+static really_inline
+const u8 *mshuftiFwd(m128 mask1_lo, m128 mask1_hi, m128 mask2_lo,
+                     m128 mask2_hi, const m128 *b1, const m128 *b2,
+                     const u8 *buf, const u8 *buf_end, const u32 len) {
+    const m128 zeroes = zeroes128();
+    const m128 low4bits = set16x8(0xf);
+
+    /* only the first (17 - len) positions in a block see all of their
+     * sequence, so blocks overlap and the rest are masked off */
+    const u32 step = 17 - len;
+    const u32 tail = 0xffff & ~((1U << step) - 1);
+
+    const u8 *last_block = buf_end - 16;
+    while (buf < last_block) {
+        u32 z = tail | mshuftiBlock(mask1_lo, mask1_hi, mask2_lo, mask2_hi,
+                                    b1, b2, loadu128(buf), low4bits, zeroes,
+                                    len);
+        if (unlikely(z != 0xffff)) {
+            return buf + ctz32(~z);
+        }
+        buf += step;
+    }
+
+    // The last block ends at buf_end: skip the positions already scanned.
+    assert(buf - last_block < 16);
+    u32 z = mshuftiBlock(mask1_lo, mask1_hi, mask2_lo, mask2_hi, b1, b2,
+                         loadu128(last_block), low4bits, zeroes, len);
+    z |= (1U << (buf - last_block)) - 1;
+    if (z != 0xffff) {
+        return last_block + ctz32(~z);
+    }
+
+    return buf_end;
+}
+
+const u8 *shuftiMultiExec(m128 mask1_lo, m128 mask1_hi,
+                          m128 mask2_lo, m128 mask2_hi, u16 onechar,
+                          const u16 *buckets, u32 len,
+                          const u8 *buf, const u8 *buf_end) {
+    assert(buf && buf_end);
+    assert(buf_end - buf >= 16);
+    assert(len == 3 || len == 4);
+    DEBUG_PRINTF("buf %p len %zu, %u classes\n", buf, buf_end - buf, len);
+
+    /* index 0 holds the single-byte stops, then each class in turn */
+    m128 b1[MSHUFTI_MAX_LEN + 1];
+    m128 b2[MSHUFTI_MAX_LEN + 1];
+    b1[0] = set16x8(onechar & 0xff);
+    b2[0] = set16x8(onechar >> 8);
+    for (u32 i = 0; i < MSHUFTI_MAX_LEN; i++) {
+        u16 b = i < len ? buckets[i] : 0;
+        b1[i + 1] = set16x8(b & 0xff);
+        b2[i + 1] = set16x8(b >> 8);
+    }
+
+    if (len == 3) {
+        return mshuftiFwd(mask1_lo, mask1_hi, mask2_lo, mask2_hi, b1, b2, buf,
+                          buf_end, 3);
+    }
+    return mshuftiFwd(mask1_lo, mask1_hi, mask2_lo, mask2_hi, b1, b2, buf,
+                      buf_end, 4);
+}
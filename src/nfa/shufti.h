@@ -54,6 +54,21 @@ const u8 *shuftiDoubleExec(m128 mask1_lo, m128 mask1_hi,
                            m128 mask2_lo, m128 mask2_hi,
                            const u8 *buf, const u8 *buf_end);
 
+/**
+ * \brief Multi-byte shufti.
+ *
+ * The two pairs of masks hold 16 buckets between them. Returns the first
+ * position at which either a byte lies in one of the \a onechar buckets, or
+ * each of the next \a len bytes lies in one of the corresponding \a buckets
+ * in turn. Sequences running off the end of the buffer are treated as
+ * matching. Returns buf_end if there is no such position; the buffer must be
+ * at least 16 bytes long.
+ */
+const u8 *shuftiMultiExec(m128 mask1_lo, m128 mask1_hi,
+                          m128 mask2_lo, m128 mask2_hi, u16 onechar,
+                          const u16 *buckets, u32 len,
+                          const u8 *buf, const u8 *buf_end);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,13 +32,18 @@
 #include "shufticompile.h"
 #include "ue2common.h"
 #include "util/charreach.h"
+#include "util/bitutils.h"
 #include "util/container.h"
 #include "util/flat_containers.h"
+#include "util/verify_types.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstring>
 #include <map>
+#include <set>
+#include <vector>
 
 using namespace std;
 
@@ -208,6 +213,163 @@ bool shuftiBuildDoubleMasks(const CharReach &onechar,
     return true;
 }
 
+#define MAX_MULTI_BUCKETS 16
+
+namespace {
+/** \brief A bucket of a multi-byte shufti: a set of lo nibbles and a set of
+ * hi nibbles, matching every byte made of one of each. */
+struct MultiBucket {
+    u16 lo = 0;
+    u16 hi = 0;
+
+    size_t width() const {
+        return popcount32(lo) * popcount32(hi);
+    }
+
+    bool operator<(const MultiBucket &b) const {
+        return lo != b.lo ? lo < b.lo : hi < b.hi;
+    }
+};
+}
+
+static
+vector<MultiBucket> bucketsForClass(const CharReach &cr) {
+    /* as for the single-byte variant: group hi nibbles which share a set of
+     * lo nibbles */
+    map<u8, u16> by_hi;
+    for (size_t i = cr.find_first(); i != CharReach::npos;
+         i = cr.find_next(i)) {
+        by_hi[i >> 4] |= 1U << (i & 0xf);
+    }
+
+    map<u16, u16> by_lo_set;
+    for (const auto &e : by_hi) {
+        by_lo_set[e.second] |= 1U << e.first;
+    }
+
+    vector<MultiBucket> rv;
+    for (const auto &e : by_lo_set) {
+        MultiBucket b;
+        b.lo = e.first;
+        b.hi = e.second;
+        rv.push_back(b);
+    }
+    return rv;
+}
+
+static
+size_t countBuckets(const vector<vector<MultiBucket>> &classes) {
+    set<MultiBucket> all;
+    for (const auto &c : classes) {
+        insert(&all, c);
+    }
+    return all.size();
+}
+
+/** \brief Merges the two buckets of the class which add the fewest extra
+ * bytes. */
+static
+void widenClass(vector<MultiBucket> &c) {
+    assert(c.size() > 1);
+    s64a best_cost = 0;
+    size_t best_i = 0;
+    size_t best_j = 1;
+    for (size_t i = 0; i < c.size(); i++) {
+        for (size_t j = i + 1; j < c.size(); j++) {
+            MultiBucket m;
+            m.lo = c[i].lo | c[j].lo;
+            m.hi = c[i].hi | c[j].hi;
+            /* buckets may overlap once widened, so this can be negative */
+            s64a cost = (s64a)m.width() - c[i].width() - c[j].width();
+            if ((i == 0 && j == 1) || cost < best_cost) {
+                best_cost = cost;
+                best_i = i;
+                best_j = j;
+            }
+        }
+    }
+
+    c[best_i].lo |= c[best_j].lo;
+    c[best_i].hi |= c[best_j].hi;
+    c.erase(c.begin() + best_j);
+}
+
+void shuftiBuildMultiMasks(const CharReach &onechar,
+                           const vector<CharReach> &classes,
+                           u8 *lo1, u8 *hi1, u8 *lo2, u8 *hi2,
+                           u16 *onechar_buckets, u16 *class_buckets) {
+    assert(!classes.empty());
+    DEBUG_PRINTF("unibytes %zu, %zu classes\n", onechar.count(),
+                 classes.size());
+
+    /* entry 0 holds the single-byte stops, which may be empty */
+    vector<vector<MultiBucket>> wanted;
+    wanted.push_back(bucketsForClass(onechar));
+    for (const auto &cr : classes) {
+        assert(cr.any());
+        wanted.push_back(bucketsForClass(cr));
+    }
+
+    while (countBuckets(wanted) > MAX_MULTI_BUCKETS) {
+        auto it = max_element(wanted.begin(), wanted.end(),
+                              [](const vector<MultiBucket> &a,
+                                 const vector<MultiBucket> &b) {
+                                  return a.size() < b.size();
+                              });
+        DEBUG_PRINTF("too many buckets, widening class %zu\n",
+                     distance(wanted.begin(), it));
+        widenClass(*it);
+    }
+
+    map<MultiBucket, u32> bucket_ids;
+    for (const auto &c : wanted) {
+        for (const auto &b : c) {
+            if (!contains(bucket_ids, b)) {
+                u32 id = verify_u32(bucket_ids.size());
+                bucket_ids.emplace(b, id);
+            }
+        }
+    }
+    assert(bucket_ids.size() <= MAX_MULTI_BUCKETS);
+
+    array<u8, 16> lo1_a; lo1_a.fill(0);
+    array<u8, 16> hi1_a; hi1_a.fill(0);
+    array<u8, 16> lo2_a; lo2_a.fill(0);
+    array<u8, 16> hi2_a; hi2_a.fill(0);
+    for (const auto &e : bucket_ids) {
+        const MultiBucket &b = e.first;
+        u32 id = e.second;
+        array<u8, 16> &lo_a = id < 8 ? lo1_a : lo2_a;
+        array<u8, 16> &hi_a = id < 8 ? hi1_a : hi2_a;
+        u8 bit = 1U << (id % 8);
+        for (u32 n = 0; n < 16; n++) {
+            if (b.lo & (1U << n)) {
+                lo_a[n] |= bit;
+            }
+            if (b.hi & (1U << n)) {
+                hi_a[n] |= bit;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < wanted.size(); i++) {
+        u16 mask = 0;
+        for (const auto &b : wanted[i]) {
+            mask |= 1U << bucket_ids.at(b);
+        }
+        if (i == 0) {
+            *onechar_buckets = mask;
+        } else {
+            class_buckets[i - 1] = mask;
+        }
+    }
+
+    memcpy(lo1, lo1_a.data(), sizeof(m128));
+    memcpy(hi1, hi1_a.data(), sizeof(m128));
+    memcpy(lo2, lo2_a.data(), sizeof(m128));
+    memcpy(hi2, hi2_a.data(), sizeof(m128));
+}
+
 #ifdef DUMP_SUPPORT
 
 CharReach shufti2cr(const u8 *lo, const u8 *hi) {
@@ -220,6 +382,19 @@ CharReach shufti2cr(const u8 *lo, const u8 *hi) {
     return cr;
 }
 
+CharReach mshufti2cr(const u8 *lo1, const u8 *hi1, const u8 *lo2,
+                     const u8 *hi2, u16 buckets) {
+    CharReach cr;
+    for (u32 i = 0; i < 256; i++) {
+        u32 t1 = lo1[(u8)i & 0xf] & hi1[(u8)i >> 4];
+        u32 t2 = lo2[(u8)i & 0xf] & hi2[(u8)i >> 4];
+        if ((t1 | t2 << 8) & buckets) {
+            cr.set(i);
+        }
+    }
+    return cr;
+}
+
 #endif // DUMP_SUPPORT
 
 } // namespace ue2
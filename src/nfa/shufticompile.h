@@ -38,6 +38,7 @@
 #include "util/flat_containers.h"
 
 #include <utility>
+#include <vector>
 
 namespace ue2 {
 
@@ -58,6 +59,18 @@ bool shuftiBuildDoubleMasks(const CharReach &onechar,
                             const flat_set<std::pair<u8, u8>> &twochar,
                             u8 *lo1, u8 *hi1, u8 *lo2, u8 *hi2);
 
+/** \brief Multi-byte variant.
+ *
+ * Packs the single-byte stops and each class of the sequence into the 16
+ * buckets of two mask pairs, writing the buckets used by each into
+ * onechar_buckets and class_buckets. Classes which need too many buckets are
+ * widened until everything fits, so this always succeeds.
+ */
+void shuftiBuildMultiMasks(const CharReach &onechar,
+                           const std::vector<CharReach> &classes,
+                           u8 *lo1, u8 *hi1, u8 *lo2, u8 *hi2,
+                           u16 *onechar_buckets, u16 *class_buckets);
+
 #ifdef DUMP_SUPPORT
 
 /**
@@ -66,6 +79,13 @@ bool shuftiBuildDoubleMasks(const CharReach &onechar,
  */
 CharReach shufti2cr(const u8 *lo, const u8 *hi);
 
+/**
+ * \brief Dump code: returns the reach of the given buckets of a multi-byte
+ * shufti.
+ */
+CharReach mshufti2cr(const u8 *lo1, const u8 *hi1, const u8 *lo2,
+                     const u8 *hi2, u16 buckets);
+
 #endif // DUMP_SUPPORT
 
 } // namespace ue2
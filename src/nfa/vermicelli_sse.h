@@ -29,6 +29,11 @@
 /** \file
  * \brief Vermicelli: Intel SSE implementation.
  *
+ * On AVX2 and AVX-512 targets the aligned search loops start with a wide loop
+ * which checks 32 or 64 bytes per iteration, leaving the SSE loops to deal with
+ * the tail. The unaligned head and tail checks stay 16 bytes wide, so callers
+ * still only need to supply VERM_BOUNDARY bytes.
+ *
  * (users should include vermicelli.h)
  */
 
@@ -36,10 +41,64 @@
 #define VERM_TYPE m128
 #define VERM_SET_FN set16x8
 
+#if defined(HAVE_AVX512)
+#define VERM_WIDE 64
+#define VERM_WIDE_ALL (~0ULL)
+#elif defined(HAVE_AVX2)
+#define VERM_WIDE 32
+#define VERM_WIDE_ALL 0xffffffffULL
+#endif
+
+#if defined(VERM_WIDE)
+/* Returns a bit for each of the VERM_WIDE bytes at buf which, masked with
+ * mask, is equal to the byte in chars. */
+static really_inline
+u64a vermWideMasked(m128 chars, m128 mask, const u8 *buf) {
+#if defined(HAVE_AVX512)
+    m512 data = loadu512(buf);
+    return eq512mask(set4x128(chars), and512(data, set4x128(mask)));
+#else
+    m256 data = loadu256(buf);
+    return movemask256(eq256(set2x128(chars), and256(data, set2x128(mask))));
+#endif
+}
+
+static really_inline
+u64a vermWide(m128 chars, const u8 *buf) {
+#if defined(HAVE_AVX512)
+    return eq512mask(set4x128(chars), loadu512(buf));
+#else
+    return movemask256(eq256(set2x128(chars), loadu256(buf)));
+#endif
+}
+
+static really_inline
+u64a vermWideNocase(m128 chars, const u8 *buf) {
+    return vermWideMasked(chars, set16x8(CASE_CLEAR), buf);
+}
+
+static really_inline
+const u8 *lastMatchOffsetWide(const u8 *buf_end, u64a z) {
+    assert(z);
+    return buf_end - VERM_WIDE + 63 - clz64(z);
+}
+#endif
+
 static really_inline
 const u8 *vermSearchAligned(m128 chars, const u8 *buf, const u8 *buf_end,
                             char negate) {
     assert((size_t)buf % 16 == 0);
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE - 1 < buf_end; buf += VERM_WIDE) {
+        u64a z = vermWide(chars, buf);
+        if (negate) {
+            z = ~z & VERM_WIDE_ALL;
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
     for (; buf + 31 < buf_end; buf += 32) {
         m128 data = load128(buf);
         u32 z1 = movemask128(eq128(chars, data));
@@ -74,6 +133,18 @@ const u8 *vermSearchAlignedNocase(m128 chars, const u8 *buf,
     assert((size_t)buf % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE - 1 < buf_end; buf += VERM_WIDE) {
+        u64a z = vermWideNocase(chars, buf);
+        if (negate) {
+            z = ~z & VERM_WIDE_ALL;
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
+
     for (; buf + 31 < buf_end; buf += 32) {
         m128 data = load128(buf);
         u32 z1 = movemask128(eq128(chars, and128(casemask, data)));
@@ -135,6 +206,18 @@ const u8 *vermUnalignNocase(m128 chars, const u8 *buf, char negate) {
 static really_inline
 const u8 *dvermSearchAligned(m128 chars1, m128 chars2, u8 c1, u8 c2,
                              const u8 *buf, const u8 *buf_end) {
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE < buf_end; buf += VERM_WIDE) {
+        u64a z = vermWide(chars1, buf) & (vermWide(chars2, buf) >> 1);
+        if (buf[VERM_WIDE - 1] == c1 && buf[VERM_WIDE] == c2) {
+            z |= 1ULL << (VERM_WIDE - 1);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
         u32 z = movemask128(and128(eq128(chars1, data),
@@ -157,6 +240,20 @@ const u8 *dvermSearchAlignedNocase(m128 chars1, m128 chars2, u8 c1, u8 c2,
     assert((size_t)buf % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE < buf_end; buf += VERM_WIDE) {
+        u64a z = vermWideNocase(chars1, buf) &
+                 (vermWideNocase(chars2, buf) >> 1);
+        if ((buf[VERM_WIDE - 1] & CASE_CLEAR) == c1 &&
+            (buf[VERM_WIDE] & CASE_CLEAR) == c2) {
+            z |= 1ULL << (VERM_WIDE - 1);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
         m128 v = and128(casemask, data);
@@ -180,6 +277,19 @@ const u8 *dvermSearchAlignedMasked(m128 chars1, m128 chars2,
                                    u8 m2, const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf % 16 == 0);
 
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE < buf_end; buf += VERM_WIDE) {
+        u64a z = vermWideMasked(chars1, mask1, buf) &
+                 (vermWideMasked(chars2, mask2, buf) >> 1);
+        if ((buf[VERM_WIDE - 1] & m1) == c1 && (buf[VERM_WIDE] & m2) == c2) {
+            z |= 1ULL << (VERM_WIDE - 1);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
         m128 v1 = eq128(chars1, and128(data, mask1));
@@ -258,6 +368,17 @@ static really_inline
 const u8 *rvermSearchAligned(m128 chars, const u8 *buf, const u8 *buf_end,
                              char negate) {
     assert((size_t)buf_end % 16 == 0);
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE - 1 < buf_end; buf_end -= VERM_WIDE) {
+        u64a z = vermWide(chars, buf_end - VERM_WIDE);
+        if (negate) {
+            z = ~z & VERM_WIDE_ALL;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z);
+        }
+    }
+#endif
     for (; buf + 15 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(eq128(chars, data));
@@ -277,6 +398,18 @@ const u8 *rvermSearchAlignedNocase(m128 chars, const u8 *buf,
     assert((size_t)buf_end % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE - 1 < buf_end; buf_end -= VERM_WIDE) {
+        u64a z = vermWideNocase(chars, buf_end - VERM_WIDE);
+        if (negate) {
+            z = ~z & VERM_WIDE_ALL;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z);
+        }
+    }
+#endif
+
     for (; buf + 15 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(eq128(chars, and128(casemask, data)));
@@ -324,6 +457,20 @@ const u8 *rdvermSearchAligned(m128 chars1, m128 chars2, u8 c1, u8 c2,
                               const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf_end % 16 == 0);
 
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE < buf_end; buf_end -= VERM_WIDE) {
+        const u8 *d = buf_end - VERM_WIDE;
+        u64a z = vermWide(chars2, d) &
+                 ((vermWide(chars1, d) << 1) & VERM_WIDE_ALL);
+        if (d[-1] == c1 && d[0] == c2) {
+            z |= 1;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(and128(eq128(chars2, data),
@@ -344,6 +491,20 @@ const u8 *rdvermSearchAlignedNocase(m128 chars1, m128 chars2, u8 c1, u8 c2,
     assert((size_t)buf_end % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
 
+#if defined(VERM_WIDE)
+    for (; buf + VERM_WIDE < buf_end; buf_end -= VERM_WIDE) {
+        const u8 *d = buf_end - VERM_WIDE;
+        u64a z = vermWideNocase(chars2, d) &
+                 ((vermWideNocase(chars1, d) << 1) & VERM_WIDE_ALL);
+        if ((d[-1] & CASE_CLEAR) == c1 && (d[0] & CASE_CLEAR) == c2) {
+            z |= 1;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z);
+        }
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         m128 v = and128(casemask, data);
@@ -37,6 +37,7 @@
 #include "ue2common.h"
 
 #include "nfa/accel.h"
+#include "nfa/accelcompile.h"
 
 #include "util/bitutils.h" // for CASE_CLEAR
 #include "util/charreach.h"
@@ -559,11 +560,69 @@ DAccelScheme findBestDoubleAccelScheme(vector<vector<CharReach> > paths,
     return best;
 }
 
+/** \brief Expected number of stops per 256 bytes of random input. */
+static
+double multiAccelRate(const CharReach &singles,
+                      const vector<CharReach> &classes) {
+    double rate = 256.0;
+    for (const auto &cr : classes) {
+        rate *= cr.count() / 256.0;
+    }
+    return singles.count() + rate;
+}
+
+static
+void findBestMultiAccelScheme(const vector<vector<CharReach>> &paths,
+                              const CharReach &terminating, AccelScheme *as) {
+    double best_rate = as->cr.count();
+    if (!as->double_byte.empty()) {
+        best_rate = min(best_rate, as->double_cr.count()
+                                   + as->double_byte.size() / 256.0);
+    }
+    best_rate /= MULTI_ACCEL_GAIN;
+    DEBUG_PRINTF("looking for multi accel, must beat %f\n", best_rate);
+
+    for (u32 len = MSHUFTI_MIN_LEN; len <= MSHUFTI_MAX_LEN; len++) {
+        for (u32 offset = 0; offset + len <= MAX_ACCEL_DEPTH; offset++) {
+            vector<CharReach> classes(len);
+            for (const auto &path : paths) {
+                /* an empty class means the path never needs to stop; past
+                 * the end of the path anything goes */
+                u32 end = min(offset + len, (u32)path.size());
+                if (any_of(path.begin(), path.begin() + end,
+                           [](const CharReach &cr) { return cr.none(); })) {
+                    continue;
+                }
+                for (u32 i = 0; i < len; i++) {
+                    classes[i] |= offset + i < path.size() ? path[offset + i]
+                                                            : CharReach::dot();
+                }
+            }
+
+            if (any_of(classes.begin(), classes.end(),
+                       [](const CharReach &cr) { return cr.none(); })) {
+                continue;
+            }
+
+            double rate = multiAccelRate(terminating, classes);
+            DEBUG_PRINTF("%u classes at offset %u: rate %f\n", len, offset,
+                         rate);
+            if (rate < best_rate) {
+                best_rate = rate;
+                as->multi_classes = move(classes);
+                as->multi_cr = terminating;
+                as->multi_offset = offset;
+            }
+        }
+    }
+}
+
 #define MAX_EXPLORE_PATHS 40
 
 AccelScheme findBestAccelScheme(vector<vector<CharReach>> paths,
                                 const CharReach &terminating,
-                                bool look_for_double_byte) {
+                                bool look_for_double_byte,
+                                bool look_for_multi_byte) {
     AccelScheme rv;
     if (look_for_double_byte) {
         DAccelScheme da = findBestDoubleAccelScheme(paths, terminating);
@@ -574,6 +633,13 @@ AccelScheme findBestAccelScheme(vector<vector<CharReach>> paths,
         }
     }
 
+    /* improvePaths() blows out classes which would not help a single-byte
+     * scheme, so keep the originals for the multi-byte scheme */
+    vector<vector<CharReach>> orig_paths;
+    if (look_for_multi_byte) {
+        orig_paths = paths;
+    }
+
     improvePaths(paths);
 
     DEBUG_PRINTF("we have %zu paths\n", paths.size());
@@ -608,13 +674,18 @@ AccelScheme findBestAccelScheme(vector<vector<CharReach>> paths,
         rv.double_byte.clear();
     }
 
+    if (look_for_multi_byte) {
+        findBestMultiAccelScheme(orig_paths, terminating, &rv);
+    }
+
     return rv;
 }
 
 AccelScheme nfaFindAccel(const NGHolder &g, const vector<NFAVertex> &verts,
                          const vector<CharReach> &refined_cr,
                          const map<NFAVertex, BoundedRepeatSummary> &br_cyclic,
-                         bool allow_wide, bool look_for_double_byte) {
+                         bool allow_wide, bool look_for_double_byte,
+                         bool look_for_multi_byte) {
     CharReach terminating;
     for (auto v : verts) {
         if (!hasSelfLoop(v, g)) {
@@ -659,7 +730,7 @@ AccelScheme nfaFindAccel(const NGHolder &g, const vector<NFAVertex> &verts,
     }
 
     return findBestAccelScheme(std::move(paths), terminating,
-                               look_for_double_byte);
+                               look_for_double_byte, look_for_multi_byte);
 }
 
 NFAVertex get_sds_or_proxy(const NGHolder &g) {
@@ -66,11 +66,13 @@ NFAVertex get_sds_or_proxy(const NGHolder &g);
 AccelScheme nfaFindAccel(const NGHolder &g, const std::vector<NFAVertex> &verts,
                     const std::vector<CharReach> &refined_cr,
                     const std::map<NFAVertex, BoundedRepeatSummary> &br_cyclic,
-                    bool allow_wide, bool look_for_double_byte = false);
+                    bool allow_wide, bool look_for_double_byte = false,
+                    bool look_for_multi_byte = false);
 
 AccelScheme findBestAccelScheme(std::vector<std::vector<CharReach> > paths,
                                 const CharReach &terminating,
-                                bool look_for_double_byte = false);
+                                bool look_for_double_byte = false,
+                                bool look_for_multi_byte = false);
 
 /** \brief Check if vertex \a v is an accelerable state (for a limex NFA). If a
  *  single byte accel scheme is found it is placed into *as
@@ -35,6 +35,7 @@
 
 #include "hs_internal.h"
 #include "hs_runtime.h"
+#include "match_buffer.h"
 #include "scratch.h"
 #include "ue2common.h"
 #include "nfa/callback.h"
@@ -292,7 +293,7 @@ void clearCvec(const struct RoseEngine *rose, char *cvec) {
 }
 
 /**
- * \brief Deliver the given report to the user callback.
+ * \brief Deliver the given report to the user callback or match buffer.
  *
  * Assumes all preconditions (bounds, exhaustion etc) have been checked and
  * that dedupe catchup has been done.
@@ -323,8 +324,8 @@ int roseDeliverReport(u64a offset, ReportID onmatch, s32 offset_adjust,
     DEBUG_PRINTF(">> reporting match @[%llu,%llu] for sig %u ctxt %p <<\n",
                  from_offset, to_offset, onmatch, ci->userContext);
 
-    int halt = ci->userCallback(onmatch, from_offset, to_offset, flags,
-                                ci->userContext);
+    int halt = deliverUserMatch(scratch, onmatch, from_offset, to_offset,
+                                flags);
     if (halt) {
         DEBUG_PRINTF("callback requested to terminate matches\n");
         ci->status |= STATUS_TERMINATED;
@@ -340,7 +341,7 @@ int roseDeliverReport(u64a offset, ReportID onmatch, s32 offset_adjust,
 }
 
 /**
- * \brief Deliver the given SOM report to the user callback.
+ * \brief Deliver the given SOM report to the user callback or match buffer.
  *
  * Assumes all preconditions (bounds, exhaustion etc) have been checked and
  * that dedupe catchup has been done.
@@ -372,8 +373,8 @@ int roseDeliverSomReport(u64a from_offset, u64a to_offset, ReportID onmatch,
     DEBUG_PRINTF(">> reporting match @[%llu,%llu] for sig %u ctxt %p <<\n",
                  from_offset, to_offset, onmatch, ci->userContext);
 
-    int halt = ci->userCallback(onmatch, from_offset, to_offset, flags,
-                                ci->userContext);
+    int halt = deliverUserMatch(scratch, onmatch, from_offset, to_offset,
+                                flags);
 
     if (halt) {
         DEBUG_PRINTF("callback requested to terminate matches\n");
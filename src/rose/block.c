@@ -47,6 +47,8 @@ void runAnchoredTableBlock(const struct RoseEngine *t, const void *atable,
     const struct anchored_matcher_info *curr = atable;
 
     DEBUG_PRINTF("BEGIN ANCHORED (over %zu/%zu)\n", alen, length);
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_ANCHORED, alen);
+    PROFILE_START(scratch);
 
     do {
         const struct NFA *nfa
@@ -76,6 +78,8 @@ void runAnchoredTableBlock(const struct RoseEngine *t, const void *atable,
 
         curr = (const void *)((const char *)curr + curr->next_offset);
     } while (1);
+
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_ANCHORED);
 }
 
 static really_inline
@@ -256,8 +260,12 @@ int roseBlockFloating(const struct RoseEngine *t, struct hs_scratch *scratch) {
 
     DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu)\n", flen, length);
     DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_FLOATING,
+                   flen - t->floatingMinDistance);
+    PROFILE_START(scratch);
     hwlmExec(ftable, buffer, flen, t->floatingMinDistance, roseFloatingCallback,
              scratch, tctxt->groups & t->floating_group_mask);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_FLOATING);
 
     return can_stop_matching(scratch);
 }
@@ -387,8 +395,11 @@ void roseBlockExec(const struct RoseEngine *t, struct hs_scratch *scratch) {
 
         DEBUG_PRINTF("BEGIN SMALL BLOCK (over %zu/%zu)\n", sblen, length);
         DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
+        PROFILE_ENGINE(scratch, HS_STATS_ENGINE_SMALL_BLOCK, sblen);
+        PROFILE_START(scratch);
         hwlmExec(sbtable, scratch->core_info.buf, sblen, 0, roseCallback,
                  scratch, tctxt->groups);
+        PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_SMALL_BLOCK);
     } else {
         runEagerPrefixesBlock(t, scratch);
 
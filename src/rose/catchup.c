@@ -36,6 +36,7 @@
 #include "program_runtime.h"
 #include "rose.h"
 #include "nfa/nfa_rev_api.h"
+#include "nfa/mcclellan.h"
 #include "nfa/mpv.h"
 #include "som/som_runtime.h"
 #include "util/fatbit.h"
@@ -56,7 +57,9 @@ int roseNfaRunProgram(const struct RoseEngine *rose, struct hs_scratch *scratch,
         flags |= ROSE_PROG_FLAG_FROM_MPV;
     }
 
+    PROFILE_START(scratch);
     roseRunProgram(rose, scratch, program, som, offset, flags);
+    PROFILE_END_PROGRAM(scratch, program);
 
     return can_stop_matching(scratch) ? MO_HALT_MATCHING : MO_CONTINUE_MATCHING;
 }
@@ -182,7 +185,10 @@ hwlmcb_rv_t runExistingNfaToNextMatch(const struct RoseEngine *t, u32 qi,
 
     assert(q_cur_loc(q) <= loc);
 
+    PROFILE_QUEUE_RUN(scratch, qi, q_cur_loc(q), loc);
+    PROFILE_START(scratch);
     char alive = nfaQueueExecToMatch(q->nfa, q, loc);
+    PROFILE_END_QUEUE(scratch, qi);
 
     /* exit via gift shop */
     if (alive == MO_MATCHES_PENDING) {
@@ -234,7 +240,10 @@ hwlmcb_rv_t runNewNfaToNextMatch(const struct RoseEngine *t, u32 qi,
     char alive = 1;
 
 restart:
+    PROFILE_QUEUE_RUN(scratch, qi, q_cur_loc(q), loc);
+    PROFILE_START(scratch);
     alive = nfaQueueExecToMatch(q->nfa, q, loc);
+    PROFILE_END_QUEUE(scratch, qi);
 
     if (alive == MO_MATCHES_PENDING) {
         DEBUG_PRINTF("we have pending matches at %lld\n", q_cur_loc(q));
@@ -400,7 +409,10 @@ hwlmcb_rv_t roseCatchUpMPV_i(const struct RoseEngine *t, s64a loc,
     scratch->tctxt.mpv_inactive = 0;
 
     /* we know it is going to be an mpv, skip the indirection */
+    PROFILE_QUEUE_RUN(scratch, qi, q_cur_loc(q), loc);
+    PROFILE_START(scratch);
     next_pos_match_loc = nfaExecMpv_QueueExecRaw(q->nfa, q, loc);
+    PROFILE_END_QUEUE(scratch, qi);
     assert(!q->report_current);
 
     if (!next_pos_match_loc) { /* 0 means dead */
@@ -492,7 +504,10 @@ char blast_queue(struct hs_scratch *scratch, struct mq *q, u32 qi, s64a to_loc,
     q->report_current = report_current;
     DEBUG_PRINTF("queue %u blasting, %u/%u [%lld/%lld]\n", qi, q->cur, q->end,
                  q_cur_loc(q), to_loc);
+    PROFILE_QUEUE_RUN(scratch, qi, q_cur_loc(q), to_loc);
+    PROFILE_START(scratch);
     char alive = nfaQueueExec(q->nfa, q, to_loc);
+    PROFILE_END_QUEUE(scratch, qi);
     q->cb = roseNfaAdaptor;
     assert(!q->report_current);
 
@@ -587,7 +602,10 @@ void streamInitSufPQ(const struct RoseEngine *t, char *state,
         ensureQueueActive(t, qi, qCount, q, scratch);
         ensureEnd(q, qi, length);
 
+        PROFILE_QUEUE_RUN(scratch, qi, q_cur_loc(q), length);
+        PROFILE_START(scratch);
         char alive = nfaQueueExecToMatch(q->nfa, q, length);
+        PROFILE_END_QUEUE(scratch, qi);
 
         if (alive == MO_MATCHES_PENDING) {
             DEBUG_PRINTF("we have pending matches at %lld\n", q_cur_loc(q));
@@ -609,6 +627,61 @@ void streamInitSufPQ(const struct RoseEngine *t, char *state,
     }
 }
 
+static really_inline
+void blockRunOutfixToMatch(const struct RoseEngine *t, u8 *aa, u32 qi,
+                           size_t length, struct hs_scratch *scratch) {
+    struct mq *q = scratch->queues + qi;
+
+    DEBUG_PRINTF("adding qi=%u to pq\n", qi);
+
+    PROFILE_QUEUE_RUN(scratch, qi, q_cur_loc(q), length);
+    PROFILE_START(scratch);
+    char alive = nfaQueueExecToMatch(q->nfa, q, length);
+    PROFILE_END_QUEUE(scratch, qi);
+
+    if (alive == MO_MATCHES_PENDING) {
+        DEBUG_PRINTF("we have pending matches at %lld\n", q_cur_loc(q));
+        s64a qcl = q_cur_loc(q);
+
+        pq_insert_with(&scratch->catchup_pq, scratch, qi, qcl);
+    } else if (!alive) {
+        deactivateQueue(t, aa, qi, scratch);
+    } else {
+        assert(q->cur == q->end);
+        /* TODO: can this be simplified? the nfa will never produce any
+         * matches for this block. */
+        DEBUG_PRINTF("queue %u finished, nfa lives\n", qi);
+        q->cur = q->end = 0;
+        pushQueueAt(q, 0, MQE_START, length);
+    }
+}
+
+/**
+ * \brief Runs a group of McClellan outfixes marked for lockstep execution
+ * together over their common prefix of the block, then finishes each one to
+ * its first match as usual.
+ */
+static really_inline
+void blockRunLockstepOutfixes(const struct RoseEngine *t, u8 *aa,
+                              const u32 *qis, u32 count, size_t length,
+                              struct hs_scratch *scratch) {
+    if (count > 1) {
+        struct mq *qs[MCCLELLAN_LOCKSTEP_MAX];
+        for (u32 i = 0; i < count; i++) {
+            qs[i] = scratch->queues + qis[i];
+        }
+
+        /* the shared scan is charged to the first queue of the group */
+        PROFILE_START(scratch);
+        nfaExecMcClellan8_QLockstep(qs, count);
+        PROFILE_END_QUEUE(scratch, qis[0]);
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        blockRunOutfixToMatch(t, aa, qis[i], length, scratch);
+    }
+}
+
 void blockInitSufPQ(const struct RoseEngine *t, char *state,
                     struct hs_scratch *scratch, char is_small_block) {
     DEBUG_PRINTF("initSufPQ: outfixes [%u,%u)\n", t->outfixBeginQueue,
@@ -623,8 +696,18 @@ void blockInitSufPQ(const struct RoseEngine *t, char *state,
     u32 aaCount = t->activeArrayCount;
     u32 qCount = t->queueCount;
     size_t length = scratch->core_info.len;
+    const u32 *minWidths = getByOffset(t, t->outfixMinWidthOffset);
+    u32 lockstep[MCCLELLAN_LOCKSTEP_MAX];
+    u32 lockstepCount = 0;
 
     for (u32 qi = t->outfixBeginQueue; qi < t->outfixEndQueue; qi++) {
+        /* cheap check against the dense width array first, so that short
+         * blocks do not pull in every outfix's engine header */
+        if (minWidths[qi - t->outfixBeginQueue] > length) {
+            DEBUG_PRINTF("skip outfix %u as block is too short\n", qi);
+            continue;
+        }
+
         const struct NfaInfo *info = getNfaInfoByQueue(t, qi);
 
         if (is_small_block && info->in_sbmatcher) {
@@ -649,26 +732,21 @@ void blockInitSufPQ(const struct RoseEngine *t, char *state,
         pushQueueAt(q, 1, MQE_TOP, 0);
         pushQueueAt(q, 2, MQE_END, length);
 
-        DEBUG_PRINTF("adding qi=%u to pq\n", qi);
-
-        char alive = nfaQueueExecToMatch(q->nfa, q, length);
-
-        if (alive == MO_MATCHES_PENDING) {
-            DEBUG_PRINTF("we have pending matches at %lld\n", q_cur_loc(q));
-            s64a qcl = q_cur_loc(q);
-
-            pq_insert_with(&scratch->catchup_pq, scratch, qi, qcl);
-        } else if (!alive) {
-            deactivateQueue(t, aa, qi, scratch);
-        } else {
-            assert(q->cur == q->end);
-            /* TODO: can this be simplified? the nfa will never produce any
-             * matches for this block. */
-            DEBUG_PRINTF("queue %u finished, nfa lives\n", qi);
-            q->cur = q->end = 0;
-            pushQueueAt(q, 0, MQE_START, length);
+        if (info->lockstep) {
+            DEBUG_PRINTF("deferring qi=%u for lockstep run\n", qi);
+            lockstep[lockstepCount++] = qi;
+            if (lockstepCount == MCCLELLAN_LOCKSTEP_MAX) {
+                blockRunLockstepOutfixes(t, aa, lockstep, lockstepCount,
+                                         length, scratch);
+                lockstepCount = 0;
+            }
+            continue;
         }
+
+        blockRunOutfixToMatch(t, aa, qi, length, scratch);
     }
+
+    blockRunLockstepOutfixes(t, aa, lockstep, lockstepCount, length, scratch);
 }
 
 /**
@@ -850,7 +928,8 @@ exit:;
     return HWLM_CONTINUE_MATCHING;
 }
 
-hwlmcb_rv_t roseCatchUpAll(s64a loc, struct hs_scratch *scratch) {
+static really_inline
+hwlmcb_rv_t roseCatchUpAll_i(s64a loc, struct hs_scratch *scratch) {
     /* just need suf/outfixes and mpv */
     DEBUG_PRINTF("loc %lld mnmmo %llu mmo %llu\n", loc,
                  scratch->tctxt.minNonMpvMatchOffset,
@@ -878,6 +957,14 @@ hwlmcb_rv_t roseCatchUpAll(s64a loc, struct hs_scratch *scratch) {
     return rv;
 }
 
+hwlmcb_rv_t roseCatchUpAll(s64a loc, struct hs_scratch *scratch) {
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_CATCHUP, 0);
+    PROFILE_START(scratch);
+    hwlmcb_rv_t rv = roseCatchUpAll_i(loc, scratch);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_CATCHUP);
+    return rv;
+}
+
 hwlmcb_rv_t roseCatchUpSuf(s64a loc, struct hs_scratch *scratch) {
     /* just need suf/outfixes. mpv will be caught up only to last reported
      * external match */
@@ -192,6 +192,7 @@ int roseAnchoredCallback(u64a start, u64a end, u32 id, void *ctx) {
 
     DEBUG_PRINTF("MATCH id=%u offsets=[???,%llu]\n", id, real_end);
     DEBUG_PRINTF("STATE groups=0x%016llx\n", tctxt->groups);
+    PROFILE_LITERAL(scratch, id);
 
     if (can_stop_matching(scratch)) {
         DEBUG_PRINTF("received a match when we're already dead!\n");
@@ -212,8 +213,10 @@ int roseAnchoredCallback(u64a start, u64a end, u32 id, void *ctx) {
 
     // Note that the "id" we have been handed is the program offset.
     const u8 flags = ROSE_PROG_FLAG_IN_ANCHORED;
-    if (roseRunProgram(t, scratch, id, start, real_end, flags)
-                       == HWLM_TERMINATE_MATCHING) {
+    PROFILE_START(scratch);
+    hwlmcb_rv_t rv = roseRunProgram(t, scratch, id, start, real_end, flags);
+    PROFILE_END_LITERAL(scratch, id);
+    if (rv == HWLM_TERMINATE_MATCHING) {
         assert(can_stop_matching(scratch));
         DEBUG_PRINTF("caller requested termination\n");
         return MO_HALT_MATCHING;
@@ -491,6 +494,7 @@ hwlmcb_rv_t roseCallback_i(size_t end, u32 id, struct hs_scratch *scratch) {
     DEBUG_PRINTF("last end %llu\n", tctx->lastEndOffset);
 
     DEBUG_PRINTF("STATE groups=0x%016llx\n", tctx->groups);
+    PROFILE_LITERAL(scratch, id);
 
     if (can_stop_matching(scratch)) {
         DEBUG_PRINTF("received a match when we're already dead!\n");
@@ -509,7 +513,9 @@ hwlmcb_rv_t roseCallback_i(size_t end, u32 id, struct hs_scratch *scratch) {
         return HWLM_TERMINATE_MATCHING;
     }
 
+    PROFILE_START(scratch);
     rv = roseProcessMatchInline(t, scratch, real_end, id);
+    PROFILE_END_LITERAL(scratch, id);
 
     DEBUG_PRINTF("DONE groups=0x%016llx\n", tctx->groups);
 
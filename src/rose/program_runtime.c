@@ -1687,8 +1687,11 @@ hwlmcb_rv_t roseMatcherEod(const struct RoseEngine *rose,
     size_t adj = eod_len - MIN(eod_len, rose->ematcherRegionSize);
 
     const struct HWLM *etable = getByOffset(rose, rose->ematcherOffset);
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_EOD, eod_len - adj);
+    PROFILE_START(scratch);
     hwlmExec(etable, eod_data, eod_len, adj, roseCallback, scratch,
              scratch->tctxt.groups);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_EOD);
 
     // We may need to fire delayed matches.
     if (cleanUpDelayed(rose, scratch, 0, offset) == HWLM_TERMINATE_MATCHING) {
@@ -1979,6 +1982,8 @@ hwlmcb_rv_t roseRunProgram(const struct RoseEngine *t,
     assert(programOffset >= sizeof(struct RoseEngine));
     assert(programOffset < t->size);
 
+    PROFILE_PROGRAM(scratch, programOffset);
+
     const char in_anchored = prog_flags & ROSE_PROG_FLAG_IN_ANCHORED;
     const char in_catchup = prog_flags & ROSE_PROG_FLAG_IN_CATCHUP;
     const char from_mpv = prog_flags & ROSE_PROG_FLAG_FROM_MPV;
@@ -2884,6 +2889,8 @@ hwlmcb_rv_t roseRunProgram_l(const struct RoseEngine *t,
     assert(programOffset >= sizeof(struct RoseEngine));
     assert(programOffset < t->size);
 
+    PROFILE_PROGRAM(scratch, programOffset);
+
     const char in_catchup = prog_flags & ROSE_PROG_FLAG_IN_CATCHUP;
     const char from_mpv = prog_flags & ROSE_PROG_FLAG_FROM_MPV;
 
@@ -145,6 +145,9 @@ struct build_context : noncopyable {
     /** \brief engine info by queue. */
     map<u32, engine_info> engine_info_by_queue;
 
+    /** \brief queues of outfixes that can be run in lockstep in block mode. */
+    set<u32> lockstep_outfixes;
+
     /** \brief Simple cache of programs written to engine blob, used for
      * deduplication. */
     unordered_map<RoseProgram, u32, RoseProgramHash,
@@ -383,7 +386,7 @@ void fillStateOffsets(const RoseBuildImpl &build, u32 rolesWithStateCount,
                       u32 anchorStateSize, u32 activeArrayCount,
                       u32 activeLeftCount, u32 laggedRoseCount,
                       u32 longLitStreamStateRequired, u32 historyRequired,
-                      RoseStateOffsets *so) {
+                      bool adaptiveHistory, RoseStateOffsets *so) {
     u32 curr_offset = 0;
 
     // First, runtime status (stores per-stream state, like whether we need a
@@ -417,6 +420,14 @@ void fillStateOffsets(const RoseBuildImpl &build, u32 rolesWithStateCount,
     assert(so->groups_size <= sizeof(u64a));
     curr_offset += so->groups_size;
 
+    // One byte holding the length of valid history, if streams keep only what
+    // their state needs.
+    if (adaptiveHistory) {
+        assert(historyRequired <= 0xff);
+        so->historyLength = curr_offset;
+        curr_offset += sizeof(u8);
+    }
+
     // The history consists of the bytes in the history only. YAY
     so->history = curr_offset;
     curr_offset += historyRequired;
@@ -626,10 +637,22 @@ bytecode_ptr<NFA> getDfa(raw_dfa &rdfa, bool is_transient,
                          const CompileContext &cc, const ReportManager &rm) {
     // Unleash the Sheng!!
     auto dfa = shengCompile(rdfa, cc, rm, false);
+    if (!dfa) {
+        // On AVX512VBMI targets, wider Shengs cover up to 64 states.
+        dfa = sheng32Compile(rdfa, cc, rm, false);
+    }
+    if (!dfa) {
+        dfa = sheng64Compile(rdfa, cc, rm, false);
+    }
     if (!dfa && !is_transient) {
         // Sheng wasn't successful, so unleash McClellan!
         /* We don't try the hybrid for transient prefixes due to the extra
          * bytecode and that they are usually run on small blocks */
+        /* The 64 state sheng head is only used if the sheng region would not
+         * fit in the 16 state head of the normal hybrid. */
+        dfa = mcshengCompile64(rdfa, cc, rm);
+    }
+    if (!dfa && !is_transient) {
         dfa = mcshengCompile(rdfa, cc, rm);
     }
     if (!dfa) {
@@ -1768,6 +1791,11 @@ bool prepOutfixes(RoseBuildImpl &tbi, build_context &bc,
         bc.engine_info_by_queue.emplace(n->queueIndex,
                                         engine_info(n.get(), false));
 
+        if (tbi.cc.grey.lockstepOutfixes && !tbi.cc.streaming
+            && !n->maxOffset && can_lockstep_mcclellan(n.get())) {
+            bc.lockstep_outfixes.insert(n->queueIndex);
+        }
+
         if (!*historyRequired && requires_decompress_key(*n)) {
             *historyRequired = 1;
         }
@@ -2105,7 +2133,7 @@ void updateNfaState(const build_context &bc, vector<NfaInfo> &nfa_infos,
 }
 
 /* does not include history requirements for outfixes or literal matchers */
-u32 RoseBuildImpl::calcHistoryRequired() const {
+u32 RoseBuildImpl::calcHistoryRequired(bool floor_only) const {
     u32 m = cc.grey.minHistoryAvailable;
 
     for (auto v : vertices_range(g)) {
@@ -2131,7 +2159,9 @@ u32 RoseBuildImpl::calcHistoryRequired() const {
             } else {
                 /* rose will be caught up from (lag - 1), also need an extra
                  * byte behind that to find the decompression key */
-                m = MAX(m, lag + 1);
+                if (!floor_only) {
+                    m = MAX(m, lag + 1);
+                }
                 m = MAX(m, 2); // so that history req is at least 1, for state
                                // compression.
             }
@@ -2141,7 +2171,8 @@ u32 RoseBuildImpl::calcHistoryRequired() const {
     // Delayed literals contribute to history requirement as well.
     for (u32 id = 0; id < literals.size(); id++) {
         const auto &lit = literals.at(id);
-        if (lit.delay) {
+        /* floating delays are covered by the rebuild length at runtime */
+        if (lit.delay && !(floor_only && lit.table == ROSE_FLOATING)) {
             // If the literal is delayed _and_ has a mask that is longer than
             // the literal, we need enough history to match the whole mask as
             // well when rebuilding delayed matches.
@@ -2167,6 +2198,52 @@ u32 RoseBuildImpl::calcHistoryRequired() const {
     return m ? m - 1 : 0;
 }
 
+/**
+ * \brief Writes the reach of bytes that can end a floating literal, so that
+ * tiny stream writes containing none of them can skip the Rose pass.
+ *
+ * Returns zero if tiny writes must always be scanned.
+ */
+static
+u32 writeTinyWriteReach(const RoseBuildImpl &build, const RoseEngine &proto,
+                        const LitProto *fproto, build_context &bc) {
+    const CompileContext &cc = build.cc;
+    if (!cc.streaming || !cc.grey.tinyWriteLargestBuffer) {
+        return 0;
+    }
+
+    /* these all do work on every write that the fast path would skip */
+    if (build.hasSom || proto.longLitTableOffset || proto.eagerIterOffset ||
+        build.rm.numCkeys() || findMaxBAWidth(build) != ROSE_BOUND_INF) {
+        DEBUG_PRINTF("engine not suitable for tiny write skipping\n");
+        return 0;
+    }
+
+    CharReach cr;
+    if (fproto) {
+        for (const auto &lit : fproto->hwlmProto->lits) {
+            assert(!lit.s.empty());
+            char c = lit.s.back();
+            if (lit.nocase && ourisalpha(c)) {
+                cr.set(mytolower(c));
+                cr.set(mytoupper(c));
+            } else {
+                cr.set(c);
+            }
+        }
+    }
+
+    if (cr.all()) {
+        DEBUG_PRINTF("every byte ends a floating literal\n");
+        return 0;
+    }
+
+    DEBUG_PRINTF("%zu bytes end floating literals\n", cr.count());
+    vector<u8> reach(REACH_BITVECTOR_LEN);
+    fill_bitvector(cr, reach.data());
+    return bc.engine_blob.add_range(reach);
+}
+
 static
 u32 buildLastByteIter(const RoseGraph &g, build_context &bc) {
     vector<u32> lb_roles;
@@ -2520,6 +2597,14 @@ void writeNfaInfo(const RoseBuildImpl &build, build_context &bc,
         infos.at(qi).in_sbmatcher = out.in_sbmatcher;
     }
 
+    // Mark outfix DFAs to be run in lockstep, if there is more than one.
+    if (bc.lockstep_outfixes.size() > 1) {
+        for (u32 qi : bc.lockstep_outfixes) {
+            assert(qi < infos.size());
+            infos.at(qi).lockstep = 1;
+        }
+    }
+
     // Mark suffixes triggered by EOD table literals.
     const RoseGraph &g = build.g;
     for (auto v : vertices_range(g)) {
@@ -2541,6 +2626,25 @@ void writeNfaInfo(const RoseBuildImpl &build, build_context &bc,
     proto.nfaInfoOffset = bc.engine_blob.add_range(infos);
 }
 
+/**
+ * \brief Writes out the minimum width of each outfix engine in one dense
+ * array, so that block mode scans can skip outfixes that are too wide for the
+ * block without touching their NfaInfo or engine header.
+ */
+static
+void writeOutfixMinWidths(build_context &bc, RoseEngine &proto) {
+    if (proto.outfixBeginQueue == proto.outfixEndQueue) {
+        return;
+    }
+
+    vector<u32> min_widths;
+    for (u32 qi = proto.outfixBeginQueue; qi < proto.outfixEndQueue; qi++) {
+        min_widths.push_back(bc.engine_info_by_queue.at(qi).min_width);
+    }
+
+    proto.outfixMinWidthOffset = bc.engine_blob.add_range(min_widths);
+}
+
 static
 bool hasBoundaryReports(const BoundaryReports &boundary) {
     if (!boundary.report_at_0.empty()) {
@@ -3612,6 +3716,7 @@ bytecode_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     DerivedBoundaryReports dboundary(boundary);
 
     size_t historyRequired = calcHistoryRequired(); // Updated by HWLM.
+    size_t historyFloor = calcHistoryRequired(true); // Static requirements.
     size_t longLitLengthThreshold = calcLongLitThreshold(*this,
                                                          historyRequired);
     DEBUG_PRINTF("longLitLengthThreshold=%zu\n", longLitLengthThreshold);
@@ -3633,9 +3738,9 @@ bytecode_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
 
     // Build NFAs
     bool mpv_as_outfix;
-    prepMpv(*this, bc, &historyRequired, &mpv_as_outfix);
+    prepMpv(*this, bc, &historyFloor, &mpv_as_outfix);
     proto.outfixBeginQueue = qif.allocated_count();
-    if (!prepOutfixes(*this, bc, &historyRequired)) {
+    if (!prepOutfixes(*this, bc, &historyFloor)) {
         return nullptr;
     }
     proto.outfixEndQueue = qif.allocated_count();
@@ -3687,7 +3792,7 @@ bytecode_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     rose_group fgroups = 0;
     auto fproto = buildFloatingMatcherProto(*this, fragments,
                                             longLitLengthThreshold,
-                                            &fgroups, &historyRequired);
+                                            &fgroups, &historyFloor);
 
     // Build delay rebuild HWLM matcher prototype.
     auto drproto = buildDelayRebuildMatcherProto(*this, fragments,
@@ -3708,13 +3813,19 @@ bytecode_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     size_t longLitStreamStateRequired = 0;
     proto.longLitTableOffset
         = buildLongLiteralTable(*this, bc.engine_blob, bc.longLiterals,
-                                longLitLengthThreshold, &historyRequired,
+                                longLitLengthThreshold, &historyFloor,
                                 &longLitStreamStateRequired);
 
     proto.lastByteHistoryIterOffset = buildLastByteIter(g, bc);
     proto.eagerIterOffset = writeEagerQueueIter(
         eager_queues, proto.leftfixBeginQueue, queue_count, bc.engine_blob);
 
+    proto.tinyWriteReachOffset = writeTinyWriteReach(*this, proto,
+                                                     fproto.get(), bc);
+    if (proto.tinyWriteReachOffset) {
+        proto.tinyWriteLargestBuffer = cc.grey.tinyWriteLargestBuffer;
+    }
+
     addSomRevNfas(bc, proto, ssm);
 
     writeDkeyInfo(rm, bc.engine_blob, proto);
@@ -3763,23 +3874,34 @@ bytecode_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
 
     proto.anchorStateSize = atable ? anchoredStateSize(*atable) : 0;
 
+    // Everything needed whatever the stream state is part of the floor; only
+    // leftfix lag (and the miracle bonus) and delayed literal rebuild vary.
+    historyRequired = max(historyRequired, historyFloor);
+
     DEBUG_PRINTF("rose history required %zu\n", historyRequired);
     assert(!cc.streaming || historyRequired <= cc.grey.maxHistoryAvailable);
 
     // Some SOM schemes (reverse NFAs, for example) may require more history.
-    historyRequired = max(historyRequired, (size_t)ssm.somHistoryRequired());
+    historyFloor = max(historyFloor, (size_t)ssm.somHistoryRequired());
+    historyRequired = max(historyRequired, historyFloor);
 
     assert(!cc.streaming || historyRequired <=
            max(cc.grey.maxHistoryAvailable, cc.grey.somMaxRevNfaLength));
 
+    DEBUG_PRINTF("history floor %zu\n", historyFloor);
+    bool adaptiveHistory = cc.streaming && cc.grey.adaptiveHistory
+                           && historyFloor < historyRequired
+                           && historyRequired <= 0xff;
+
     fillStateOffsets(*this, bc.roleStateIndices.size(), proto.anchorStateSize,
                      proto.activeArrayCount, proto.activeLeftCount,
                      laggedRoseCount, longLitStreamStateRequired,
-                     historyRequired, &proto.stateOffsets);
+                     historyRequired, adaptiveHistory, &proto.stateOffsets);
 
     // Write in NfaInfo structures. This will also update state size
     // information in proto.
     writeNfaInfo(*this, bc, proto, no_retrigger_queues);
+    writeOutfixMinWidths(bc, proto);
 
     scatter_plan_raw state_scatter = buildStateScatterPlan(
         sizeof(u8), bc.roleStateIndices.size(), proto.activeLeftCount,
@@ -3801,6 +3923,8 @@ bytecode_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     currOffset += aux_size(state_scatter);
 
     proto.historyRequired = verify_u32(historyRequired);
+    proto.historyFloor = verify_u32(historyFloor);
+    proto.miracleHistoryBonus = cc.grey.miracleHistoryBonus;
     proto.ekeyCount = rm.numEkeys();
 
     proto.somHorizon = ssm.somPrecision();
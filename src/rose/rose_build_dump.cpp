@@ -55,6 +55,7 @@
 #include "util/ue2string.h"
 
 #include <iomanip>
+#include <map>
 #include <numeric>
 #include <ostream>
 #include <set>
@@ -1505,20 +1506,26 @@ void dumpRoseLitPrograms(const vector<LitFragment> &fragments,
                          const RoseEngine *t, const string &filename) {
     ofstream os(filename);
 
-    // Collect all programs referenced by a literal fragment.
-    vector<u32> programs;
+    // Collect all programs referenced by a literal fragment, along with the
+    // fragments that use them.
+    map<u32, vector<const LitFragment *>> programs;
     for (const auto &frag : fragments) {
         if (frag.lit_program_offset) {
-            programs.push_back(frag.lit_program_offset);
+            programs[frag.lit_program_offset].push_back(&frag);
         }
         if (frag.delay_program_offset) {
-            programs.push_back(frag.delay_program_offset);
+            programs[frag.delay_program_offset].push_back(&frag);
         }
     }
-    sort_and_unique(programs);
 
-    for (u32 prog_offset : programs) {
+    for (const auto &m : programs) {
+        u32 prog_offset = m.first;
         os << "Program @ " << prog_offset << ":" << endl;
+        for (const LitFragment *frag : m.second) {
+            os << "  fragment " << frag->fragment_id << " \""
+               << escapeString(frag->s.get_string()) << "\""
+               << (frag->s.any_nocase() ? " (nocase)" : "") << endl;
+        }
         const char *prog = (const char *)loadFromByteCodeOffset(t, prog_offset);
         dumpProgram(os, t, prog);
         os << endl;
@@ -2151,6 +2158,8 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U8(t, somHorizon);
     DUMP_U32(t, mode);
     DUMP_U32(t, historyRequired);
+    DUMP_U32(t, historyFloor);
+    DUMP_U32(t, miracleHistoryBonus);
     DUMP_U32(t, ekeyCount);
     DUMP_U32(t, lkeyCount);
     DUMP_U32(t, lopCount);
@@ -2167,6 +2176,8 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, anchorStateSize);
     DUMP_U32(t, tStateSize);
     DUMP_U32(t, smallWriteOffset);
+    DUMP_U32(t, tinyWriteLargestBuffer);
+    DUMP_U32(t, tinyWriteReachOffset);
     DUMP_U32(t, amatcherOffset);
     DUMP_U32(t, ematcherOffset);
     DUMP_U32(t, fmatcherOffset);
@@ -2214,6 +2225,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, maxFloatingDelayedMatch);
     DUMP_U32(t, delayRebuildLength);
     DUMP_U32(t, stateOffsets.history);
+    DUMP_U32(t, stateOffsets.historyLength);
     DUMP_U32(t, stateOffsets.exhausted);
     DUMP_U32(t, stateOffsets.exhausted_size);
     DUMP_U32(t, stateOffsets.logicalVec);
@@ -2243,6 +2255,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, asize);
     DUMP_U32(t, outfixBeginQueue);
     DUMP_U32(t, outfixEndQueue);
+    DUMP_U32(t, outfixMinWidthOffset);
     DUMP_U32(t, leftfixBeginQueue);
     DUMP_U32(t, initMpvNfa);
     DUMP_U32(t, rosePrefixCount);
@@ -553,7 +553,10 @@ public:
     // Is the Rose anchored?
     bool hasNoFloatingRoots() const;
 
-    u32 calcHistoryRequired() const;
+    /** \brief History required by Rose itself. With \a floor_only, leaves
+     * out what is only needed while a lagged leftfix is active or delayed
+     * literal matches are pending. */
+    u32 calcHistoryRequired(bool floor_only = false) const;
 
     rose_group getInitialGroups() const;
     rose_group getSuccGroups(RoseVertex start) const;
@@ -34,6 +34,7 @@
 #include "hwlm/hwlm_internal.h"
 #include "hwlm/hwlm_literal.h"
 #include "nfa/accel.h"
+#include "nfa/accelcompile.h"
 #include "nfa/shufticompile.h"
 #include "nfa/trufflecompile.h"
 #include "util/compare.h"
@@ -369,6 +370,76 @@ bool litGuardedByCharReach(const CharReach &cr, const AccelString &lit,
     return false;
 }
 
+/** \brief Reach of position i of the literal, counting from the first byte
+ * constrained by its mask. */
+static
+CharReach litPosReach(const AccelString &lit, u32 i) {
+    u32 overhang = mask_overhang(lit);
+    CharReach cr;
+    if (i < overhang) {
+        u8 msk = lit.msk[lit.msk.size() - lit.s.length() - overhang + i];
+        u8 cmp = lit.cmp[lit.cmp.size() - lit.s.length() - overhang + i];
+        for (u32 j = 0; j < N_CHARS; j++) {
+            if ((j & msk) == cmp) {
+                cr.set(j);
+            }
+        }
+        return cr;
+    }
+
+    u32 i_effective = i - overhang;
+    if (i_effective >= lit.s.length()) {
+        return CharReach::dot();
+    }
+
+    unsigned char c = lit.s[i_effective];
+    if (lit.nocase) {
+        cr.set(mytoupper(c));
+        cr.set(mytolower(c));
+    } else {
+        cr.set(c);
+    }
+    return cr;
+}
+
+/** \brief Looks for a sequence of classes which every literal starts with at
+ * the same offset and which is much rarer than the best single class. */
+static
+bool findMultiShufti(const vector<const AccelString *> &lits,
+                     u32 single_count, AccelAux *aux) {
+    double best_rate = (double)single_count / MULTI_ACCEL_GAIN;
+    AccelInfo best;
+
+    for (u32 len = MSHUFTI_MIN_LEN; len <= MSHUFTI_MAX_LEN; len++) {
+        for (u32 offset = 0; offset + len <= MAX_ACCEL_OFFSET; offset++) {
+            vector<CharReach> classes(len);
+            for (const auto &lit_ptr : lits) {
+                for (u32 i = 0; i < len; i++) {
+                    classes[i] |= litPosReach(*lit_ptr, offset + i);
+                }
+            }
+
+            double rate = 256.0;
+            for (const auto &cr : classes) {
+                rate *= cr.count() / 256.0;
+            }
+            if (rate < best_rate) {
+                best_rate = rate;
+                best.multi_stops = move(classes);
+                best.multi_offset = offset;
+            }
+        }
+    }
+
+    if (best.multi_stops.empty()) {
+        return false;
+    }
+
+    DEBUG_PRINTF("built multi-shufti for %zu classes (rate %f, offset %u)\n",
+                 best.multi_stops.size(), best_rate, best.multi_offset);
+    return buildAccelAux(best, aux);
+}
+
 static
 void findForwardAccelScheme(const vector<AccelString> &lits,
                             hwlm_group_t expected_groups, AccelAux *aux) {
@@ -434,6 +505,10 @@ void findForwardAccelScheme(const vector<AccelString> &lits,
         }
     }
 
+    if (findMultiShufti(filtered_lits, min_count, aux)) {
+        return;
+    }
+
     if (min_count > MAX_SHUFTI_WIDTH) {
         DEBUG_PRINTF("FAIL: min shufti with %u chars is too wide\n", min_count);
         return;
@@ -59,7 +59,7 @@ engine_info::engine_info(const NFA *nfa, bool trans)
     : type((NFAEngineType)nfa->type), accepts_eod(nfaAcceptsEod(nfa)),
       stream_size(nfa->streamStateSize),
       scratch_size(nfa->scratchStateSize),
-      scratch_align(state_alignment(*nfa)),
+      scratch_align(state_alignment(*nfa)), min_width(nfa->minWidth),
       transient(trans) {
     assert(scratch_align);
 }
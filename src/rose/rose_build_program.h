@@ -228,6 +228,7 @@ struct engine_info {
     u32 stream_size;
     u32 scratch_size;
     u32 scratch_align;
+    u32 min_width;
     bool transient;
 };
 
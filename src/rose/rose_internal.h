@@ -161,6 +161,8 @@ struct NfaInfo {
                        * HWLM table. */
     u8 eod; /* suffix is triggered by the etable --> can only produce eod
              * matches */
+    u8 lockstep; /**< this outfix is an 8-bit McClellan DFA that is run in
+                  * lockstep with its neighbours at the start of a block. */
 };
 
 #define MAX_STORED_LEFTFIX_LAG 127 /* max leftfix lag that we can store in one
@@ -193,6 +195,11 @@ struct RoseStateOffsets {
      * Max size of history is RoseEngine::historyRequired. */
     u32 history;
 
+    /** Number of valid bytes at the end of the history buffer (one byte), for
+     * streams that keep only the history their state needs; zero if every
+     * stream keeps RoseEngine::historyRequired bytes. */
+    u32 historyLength;
+
     /** Exhausted multibit.
      *
      * entry per exhaustible key (used by Highlander mode). If a bit is set,
@@ -343,6 +350,11 @@ struct RoseEngine {
                         SOM precision) */
     u32 mode; /**< scanning mode, one of HS_MODE_{BLOCK,STREAM,VECTORED} */
     u32 historyRequired; /**< max amount of history required for streaming */
+    u32 historyFloor; /**< history required whatever the stream state; active
+                       * lagged leftfixes and pending delayed literals may
+                       * need more, up to historyRequired */
+    u32 miracleHistoryBonus; /**< extra history kept behind an active leftfix
+                              * with a miracle stop table */
     u32 ekeyCount; /**< number of exhaustion keys */
     u32 lkeyCount; /**< number of logical keys */
     u32 lopCount; /**< number of logical ops */
@@ -363,6 +375,10 @@ struct RoseEngine {
     u32 scratchStateSize; /**< uncompressed state req'd for NFAs in scratch;
                            * used for sizing scratch only. */
     u32 smallWriteOffset; /**< offset of small-write matcher */
+    u32 tinyWriteLargestBuffer; /**< largest stream write that may skip the
+                                 * Rose pass; zero if none may */
+    u32 tinyWriteReachOffset; /**< offset of the 256-bit reach of bytes that
+                               * end a floating literal */
     u32 amatcherOffset; // offset of the anchored literal matcher (bytes)
     u32 ematcherOffset; // offset of the eod-anchored literal matcher (bytes)
     u32 fmatcherOffset; // offset of the floating literal matcher (bytes)
@@ -470,6 +486,8 @@ struct RoseEngine {
     u32 asize; /* size of the atable */
     u32 outfixBeginQueue; /* first outfix queue */
     u32 outfixEndQueue; /* one past the last outfix queue */
+    u32 outfixMinWidthOffset; /**< offset to array of u32 min widths, one per
+                               * outfix queue, 0 if there are no outfixes */
     u32 leftfixBeginQueue; /* first prefix/infix queue */
     u32 initMpvNfa; /* (allegedly chained) mpv to force on at init */
     u32 rosePrefixCount; /* number of rose prefixes */
@@ -643,6 +661,25 @@ const struct LeftNfaInfo *getLeftInfoByQueue(const struct RoseEngine *t,
     return &infos[queueToLeftIndex(t, qi)];
 }
 
+/** \brief Number of valid history bytes in a stream's state at \a offset. */
+static really_inline
+u32 getHistoryLength(const struct RoseEngine *t, const char *state,
+                     u64a offset) {
+    u32 len = (u32)MIN(t->historyRequired, offset);
+    if (t->stateOffsets.historyLength) {
+        len = MIN(len, *(const u8 *)(state + t->stateOffsets.historyLength));
+    }
+    return len;
+}
+
+static really_inline
+void setHistoryLength(const struct RoseEngine *t, char *state, u32 len) {
+    assert(len <= t->historyRequired);
+    if (t->stateOffsets.historyLength) {
+        *(u8 *)(state + t->stateOffsets.historyLength) = (u8)len;
+    }
+}
+
 struct SmallWriteEngine;
 
 static really_inline
@@ -47,6 +47,7 @@
  * - leftfix lag table
  * - anchored matcher state
  * - literal groups
+ * - history length (if streams keep only the history they need)
  * - history buffer
  * - exhausted bitvector
  * - som slots, som multibit arrays
@@ -420,11 +420,14 @@ void do_rebuild(const struct RoseEngine *t, struct hs_scratch *scratch) {
     size_t len = MIN(scratch->core_info.hlen, t->delayRebuildLength);
     const u8 *buf = scratch->core_info.hbuf + scratch->core_info.hlen - len;
     DEBUG_PRINTF("BEGIN FLOATING REBUILD over %zu bytes\n", len);
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_DELAY_REBUILD, len);
 
     scratch->core_info.status &= ~STATUS_DELAY_DIRTY;
 
+    PROFILE_START(scratch);
     hwlmExec(hwlm, buf, len, 0, roseDelayRebuildCallback, scratch,
              scratch->tctxt.groups);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_DELAY_REBUILD);
     assert(!can_stop_matching(scratch));
 }
 
@@ -602,7 +605,10 @@ void roseStreamExec(const struct RoseEngine *t, struct hs_scratch *scratch) {
     const struct anchored_matcher_info *atable = getALiteralMatcher(t);
     if (atable && alen) {
         DEBUG_PRINTF("BEGIN ANCHORED %zu/%u\n", scratch->core_info.hlen, alen);
+        PROFILE_ENGINE(scratch, HS_STATS_ENGINE_ANCHORED, alen);
+        PROFILE_START(scratch);
         runAnchoredTableStream(t, atable, alen, offset, scratch);
+        PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_ANCHORED);
 
         if (can_stop_matching(scratch)) {
             goto exit;
@@ -660,8 +666,11 @@ void roseStreamExec(const struct RoseEngine *t, struct hs_scratch *scratch) {
         DEBUG_PRINTF("start=%zu\n", start);
 
         DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu)\n", flen, length);
+        PROFILE_ENGINE(scratch, HS_STATS_ENGINE_FLOATING, flen - start);
+        PROFILE_START(scratch);
         hwlmExecStreaming(ftable, flen, start, roseFloatingCallback, scratch,
                           tctxt->groups & t->floating_group_mask);
+        PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_FLOATING);
     }
 
 flush_delay_and_exit:
@@ -54,6 +54,7 @@
 #include "som/som_stream.h"
 #include "state.h"
 #include "stream_compress.h"
+#include "stream_pool.h"
 #include "ue2common.h"
 #include "util/exhaust.h"
 #include "util/multibit.h"
@@ -74,14 +75,15 @@ int HS_CDECL null_onEvent(UNUSED unsigned id, UNUSED unsigned long long from,
 }
 
 static really_inline
-u32 getHistoryAmount(const struct RoseEngine *t, u64a offset) {
-    return MIN(t->historyRequired, offset);
+u32 getHistoryAmount(const struct RoseEngine *t, const char *state,
+                     u64a offset) {
+    return getHistoryLength(t, state, offset);
 }
 
 static really_inline
 u8 *getHistory(char *state, const struct RoseEngine *t, u64a offset) {
     return (u8 *)state + t->stateOffsets.history + t->historyRequired
-        - MIN(t->historyRequired, offset);
+        - getHistoryLength(t, state, offset);
 }
 
 /** \brief Sanity checks for scratch space.
@@ -149,6 +151,17 @@ void populateCoreInfo(struct hs_scratch *s, const struct RoseEngine *rose,
     s->tctxt.minNonMpvMatchOffset = offset;
 }
 
+/** \brief Returns non-zero if the calls that only raise end of stream matches
+ * (close, reset and so on) should do so: either we have a callback or there is
+ * a match buffer attached to the scratch. */
+static really_inline
+char wantEodMatches(const struct hs_scratch *s, match_event_handler onEvent) {
+    if (onEvent) {
+        return 1;
+    }
+    return s && ISALIGNED_CL(s) && s->magic == SCRATCH_MAGIC && s->mbuf.buf;
+}
+
 #define STATUS_VALID_BITS                                                      \
     (STATUS_TERMINATED | STATUS_EXHAUSTED | STATUS_DELAY_DIRTY | STATUS_ERROR)
 
@@ -215,8 +228,11 @@ void pureLiteralBlockExec(const struct RoseEngine *rose,
     pureLiteralInitScratch(scratch, 0);
     scratch->tctxt.groups = rose->initialGroups;
 
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_FLOATING, length);
+    PROFILE_START(scratch);
     hwlmExec(ftable, buffer, length, 0, roseCallback, scratch,
              rose->initialGroups & rose->floating_group_mask);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_FLOATING);
 }
 
 static really_inline
@@ -270,7 +286,15 @@ void soleOutfixBlockExec(const struct RoseEngine *t,
     pushQueueAt(q, 1, MQE_TOP, 0);
     pushQueueAt(q, 2, MQE_END, scratch->core_info.len);
 
+    if (scratch->outfix_lane) {
+        /* skip what a batch lockstep pass has already scanned */
+        nfaExecMcClellan8_QResume(q, scratch->outfix_lane);
+    }
+
+    PROFILE_QUEUE_RUN(scratch, 0, 0, scratch->core_info.len);
+    PROFILE_START(scratch);
     char rv = nfaQueueExec(q->nfa, q, scratch->core_info.len);
+    PROFILE_END_QUEUE(scratch, 0);
 
     if (rv && nfaAcceptsEod(nfa) && len == scratch->core_info.len) {
         nfaCheckFinalState(nfa, q->state, q->streamState, q->length, q->cb,
@@ -298,6 +322,8 @@ void runSmallWriteEngine(const struct SmallWriteEngine *smwr,
 
     size_t local_alen = length - smwr->start_offset;
     const u8 *local_buffer = buffer + smwr->start_offset;
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_SMALL_WRITE, local_alen);
+    PROFILE_START(scratch);
 
     assert(isDfaType(nfa->type));
     if (nfa->type == MCCLELLAN_NFA_8) {
@@ -306,51 +332,33 @@ void runSmallWriteEngine(const struct SmallWriteEngine *smwr,
     } else if (nfa->type == MCCLELLAN_NFA_16) {
         nfaExecMcClellan16_B(nfa, smwr->start_offset, local_buffer,
                              local_alen, roseReportAdaptor, scratch);
+    } else if (nfa->type == SHENG_NFA_32) {
+        nfaExecSheng32_B(nfa, smwr->start_offset, local_buffer,
+                         local_alen, roseReportAdaptor, scratch);
+    } else if (nfa->type == SHENG_NFA_64) {
+        nfaExecSheng64_B(nfa, smwr->start_offset, local_buffer,
+                         local_alen, roseReportAdaptor, scratch);
     } else {
         nfaExecSheng_B(nfa, smwr->start_offset, local_buffer,
                        local_alen, roseReportAdaptor, scratch);
     }
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_SMALL_WRITE);
 }
 
-HS_PUBLIC_API
-hs_error_t HS_CDECL hs_scan(const hs_database_t *db, const char *data,
-                            unsigned length, unsigned flags,
-                            hs_scratch_t *scratch, match_event_handler onEvent,
-                            void *userCtx) {
-    if (unlikely(!scratch || !data)) {
-        return HS_INVALID;
-    }
-
-    hs_error_t err = validDatabase(db);
-    if (unlikely(err != HS_SUCCESS)) {
-        return err;
-    }
-
-    const struct RoseEngine *rose = hs_get_bytecode(db);
-    if (unlikely(!ISALIGNED_16(rose))) {
-        return HS_INVALID;
-    }
-
-    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
-        return HS_DB_MODE_ERROR;
-    }
-
-    if (unlikely(!validScratch(rose, scratch))) {
-        return HS_INVALID;
-    }
-
-    if (unlikely(markScratchInUse(scratch))) {
-        return HS_SCRATCH_IN_USE;
-    }
-
+/** \brief Block mode scan of a single buffer.
+ *
+ * The database and scratch must already have been validated, and the scratch
+ * marked as in use, by the caller. */
+static really_inline
+hs_error_t scanBlock(const struct RoseEngine *rose, const char *data,
+                     unsigned length, unsigned flags,
+                     struct hs_scratch *scratch, match_event_handler onEvent,
+                     void *userCtx) {
     if (rose->minWidth > length) {
         DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
-        unmarkScratchInUse(scratch);
         return HS_SUCCESS;
     }
 
-    prefetch_data(data, length);
-
     /* populate core info in scratch */
     populateCoreInfo(scratch, rose, scratch->bstate, onEvent, userCtx, data,
                      length, NULL, 0, 0, 0, flags);
@@ -428,17 +436,14 @@ hs_error_t HS_CDECL hs_scan(const hs_database_t *db, const char *data,
 
 done_scan:
     if (unlikely(internal_matching_error(scratch))) {
-        unmarkScratchInUse(scratch);
         return HS_UNKNOWN_ERROR;
     } else if (told_to_stop_matching(scratch)) {
-        unmarkScratchInUse(scratch);
         return HS_SCAN_TERMINATED;
     }
 
     if (rose->hasSom) {
         int halt = flushStoredSomMatches(scratch, ~0ULL);
         if (halt) {
-            unmarkScratchInUse(scratch);
             return HS_SCAN_TERMINATED;
         }
     }
@@ -450,7 +455,6 @@ done_scan:
 
 set_retval:
     if (unlikely(internal_matching_error(scratch))) {
-        unmarkScratchInUse(scratch);
         return HS_UNKNOWN_ERROR;
     }
 
@@ -458,25 +462,247 @@ set_retval:
         if (roseRunLastFlushCombProgram(rose, scratch, length)
             == MO_HALT_MATCHING) {
             if (unlikely(internal_matching_error(scratch))) {
-                unmarkScratchInUse(scratch);
                 return HS_UNKNOWN_ERROR;
             }
-            unmarkScratchInUse(scratch);
             return HS_SCAN_TERMINATED;
         }
     }
 
     DEBUG_PRINTF("done. told_to_stop_matching=%d\n",
                  told_to_stop_matching(scratch));
-    hs_error_t rv = told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED
-                                                   : HS_SUCCESS;
+    return told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED : HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_scan(const hs_database_t *db, const char *data,
+                            unsigned length, unsigned flags,
+                            hs_scratch_t *scratch, match_event_handler onEvent,
+                            void *userCtx) {
+    if (unlikely(!scratch || !data)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    if (rose->minWidth <= length) {
+        prefetch_data(data, length);
+    }
+
+    hs_error_t rv = scanBlock(rose, data, length, flags, scratch, onEvent,
+                              userCtx);
     unmarkScratchInUse(scratch);
     return rv;
 }
 
+/** \brief True if the database is a sole 8-bit McClellan outfix, which batch
+ * scans can run over several buffers in lockstep. */
+static really_inline
+char soleOutfixCanLockstep(const struct RoseEngine *rose) {
+    if (rose->runtimeImpl != ROSE_RUNTIME_SINGLE_OUTFIX) {
+        return 0;
+    }
+
+    const struct NFA *nfa = getNfaByQueue(rose, 0);
+    return nfa->type == MCCLELLAN_NFA_8 && !nfa->maxOffset;
+}
+
+/** \brief True if scanBlock() will hand a block of this length to the sole
+ * outfix, rather than skipping it or using the small write engine. */
+static really_inline
+char soleOutfixRunsBlock(const struct RoseEngine *rose, unsigned length) {
+    if (rose->minWidthExcludingBoundaries > length) {
+        return 0;
+    }
+
+    if (rose->maxBiAnchoredWidth != ROSE_BOUND_INF
+        && length > rose->maxBiAnchoredWidth) {
+        return 0;
+    }
+
+    if (rose->smallWriteOffset
+        && length < getSmallWrite(rose)->largestBuffer) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/** \brief Runs the sole outfix DFA over a group of blocks in lockstep, leaving
+ * a lane in \a lanes for each block to resume from. */
+static never_inline
+void soleOutfixBlockLockstep(const struct RoseEngine *rose,
+                             const char *const *data,
+                             const unsigned int *length, u32 count,
+                             struct mcclellan_lane *lanes) {
+    assert(count <= MCCLELLAN_LOCKSTEP_MAX);
+    const struct NFA *nfa = getNfaByQueue(rose, 0);
+
+    for (u32 i = 0; i < count; i++) {
+        const u8 *buf = (const u8 *)data[i];
+        size_t len = 0;
+        if (soleOutfixRunsBlock(rose, length[i])) {
+            /* stop where soleOutfixBlockExec() will stop */
+            len = nfaRevAccelCheck(nfa, buf, length[i]);
+        }
+        nfaExecMcClellan8_initLane(&lanes[i], nfa, buf, len, NULL, 0);
+    }
+
+    nfaExecMcClellan8_Lockstep(lanes, count);
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_scan_batch(const hs_database_t *db,
+                                  const char *const *data,
+                                  const unsigned int *length,
+                                  void *const *context, unsigned int count,
+                                  unsigned int flags, hs_scratch_t *scratch,
+                                  match_event_handler onEvent) {
+    if (unlikely(!scratch || (count && (!data || !length)))) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        if (unlikely(!data[i])) {
+            return HS_INVALID;
+        }
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    if (count && rose->minWidth <= length[0]) {
+        prefetch_data(data[0], length[0]);
+    }
+
+    /* A database that is a single DFA is latency bound on its transition
+     * loads, so we run it over a group of blocks at a time in lockstep before
+     * scanning each block as usual from where its lane stopped. */
+    const char lockstep = count > 1 && soleOutfixCanLockstep(rose);
+    struct mcclellan_lane lanes[MCCLELLAN_LOCKSTEP_MAX];
+
+    hs_error_t rv = HS_SUCCESS;
+    for (u32 i = 0; i < count; i++) {
+        DEBUG_PRINTF("batch block %u/%u len=%u\n", i, count, length[i]);
+
+        // Pull in the next block while we scan this one.
+        if (i + 1 < count && rose->minWidth <= length[i + 1]) {
+            prefetch_data(data[i + 1], length[i + 1]);
+        }
+
+        if (lockstep) {
+            u32 lane = i % MCCLELLAN_LOCKSTEP_MAX;
+            if (!lane) {
+                soleOutfixBlockLockstep(rose, data + i, length + i,
+                                        MIN(count - i, MCCLELLAN_LOCKSTEP_MAX),
+                                        lanes);
+            }
+            scratch->outfix_lane = &lanes[lane];
+        }
+
+        hs_error_t ret = scanBlock(rose, data[i], length[i], flags, scratch,
+                                   onEvent, context ? context[i] : NULL);
+        scratch->outfix_lane = NULL;
+        if (unlikely(ret == HS_UNKNOWN_ERROR)) {
+            unmarkScratchInUse(scratch);
+            return ret;
+        } else if (ret == HS_SCAN_TERMINATED) {
+            DEBUG_PRINTF("block %u terminated by user\n", i);
+            rv = HS_SCAN_TERMINATED;
+        }
+    }
+
+    unmarkScratchInUse(scratch);
+    return rv;
+}
+
+/** \brief History this stream must keep for its next write: the engine's
+ * floor, plus enough to catch up its active lagged leftfixes (and to seek
+ * miracles behind them) and to rebuild pending delayed literal matches. */
+static really_inline
+u32 historyNeeded(const struct RoseEngine *rose, const char *state) {
+    u32 need = rose->historyFloor;
+
+    if (getStreamStatus(state) & STATUS_DELAY_DIRTY) {
+        need = MAX(need, rose->delayRebuildLength);
+    }
+
+    if (rose->activeLeftIterOffset) {
+        const u8 *ara = (const u8 *)(state +
+                                     rose->stateOffsets.activeLeftArray);
+        const u32 arCount = rose->activeLeftCount;
+        const u8 *lagTable = getLeftfixLagTableConst(rose, state);
+        const struct LeftNfaInfo *left_table = getLeftTable(rose);
+        const struct mmbit_sparse_iter *it = getActiveLeftIter(rose);
+        struct mmbit_sparse_state si_state[MAX_SPARSE_ITER_STATES];
+        u32 dummy;
+        u32 ri = mmbit_sparse_iter_begin(ara, arCount, &dummy, it, si_state);
+        for (; ri != MMB_INVALID && need < rose->historyRequired;
+             ri = mmbit_sparse_iter_next(ara, arCount, ri, &dummy, it,
+                                         si_state)) {
+            u32 lagIndex = left_table[ri].lagIndex;
+            if (lagIndex == ROSE_OFFSET_INVALID) {
+                continue;
+            }
+            u8 lag = lagTable[lagIndex];
+            if (lag == OWB_ZOMBIE_ALWAYS_YES) {
+                continue;
+            }
+            /* the leftfix is resumed at the lag, and its decompression key is
+             * the byte before that */
+            u32 left_need = (u32)lag + 1;
+            if (left_table[ri].stopTable) {
+                /* the compiler reserved extra history for miracle seeking */
+                left_need += rose->miracleHistoryBonus;
+            }
+            need = MAX(need, left_need);
+        }
+    }
+
+    return MIN(need, rose->historyRequired);
+}
+
 static really_inline
 void maintainHistoryBuffer(const struct RoseEngine *rose, char *state,
-                           const char *buffer, size_t length) {
+                           const char *buffer, size_t length, u64a offset) {
     if (!rose->historyRequired) {
         return;
     }
@@ -489,12 +715,22 @@ void maintainHistoryBuffer(const struct RoseEngine *rose, char *state,
 
     char *his_state = state + rose->stateOffsets.history;
 
-    if (length < rose->historyRequired) {
-        size_t shortfall = rose->historyRequired - length;
-        memmove(his_state, his_state + rose->historyRequired - shortfall,
-                shortfall);
+    /* Streams that keep adaptive history only move the bytes their state
+     * still needs; the rest of the buffer is left stale. */
+    u32 keep = rose->historyRequired;
+    if (rose->stateOffsets.historyLength) {
+        u32 valid = getHistoryLength(rose, state, offset);
+        keep = MIN(historyNeeded(rose, state), length + valid);
+        setHistoryLength(rose, state, keep);
+        DEBUG_PRINTF("keeping %u bytes of history (had %u)\n", keep, valid);
     }
-    size_t amount = MIN(rose->historyRequired, length);
+
+    if (length < keep) {
+        size_t shortfall = keep - length;
+        memmove(his_state + rose->historyRequired - keep,
+                his_state + rose->historyRequired - shortfall, shortfall);
+    }
+    size_t amount = MIN(keep, length);
 
     memcpy(his_state + rose->historyRequired - amount, buffer + length - amount,
            amount);
@@ -527,6 +763,7 @@ void init_stream(struct hs_stream *s, const struct RoseEngine *rose,
 
     setStreamStatus(state, 0);
     roseInitState(rose, state);
+    setHistoryLength(rose, state, 0);
 
     clearEvec(rose, state + rose->stateOffsets.exhausted);
     if (rose->ckeyCount) {
@@ -632,7 +869,7 @@ static really_inline
 void report_eod_matches(hs_stream_t *id, hs_scratch_t *scratch,
                         match_event_handler onEvent, void *context) {
     DEBUG_PRINTF("--- report eod matches at offset %llu\n", id->offset);
-    assert(onEvent);
+    assert(onEvent || scratch->mbuf.buf);
 
     const struct RoseEngine *rose = id->rose;
     char *state = getMultiState(id);
@@ -645,7 +882,8 @@ void report_eod_matches(hs_stream_t *id, hs_scratch_t *scratch,
 
     populateCoreInfo(scratch, rose, state, onEvent, context, NULL, 0,
                      getHistory(state, rose, id->offset),
-                     getHistoryAmount(rose, id->offset), id->offset, status, 0);
+                     getHistoryAmount(rose, state, id->offset), id->offset,
+                     status, 0);
 
     if (rose->ckeyCount) {
         scratch->core_info.logicalVector = state +
@@ -755,7 +993,7 @@ hs_error_t HS_CDECL hs_reset_and_copy_stream(hs_stream_t *to_id,
         return HS_INVALID;
     }
 
-    if (onEvent) {
+    if (wantEodMatches(scratch, onEvent)) {
         if (!scratch || !validScratch(to_id->rose, scratch)) {
             return HS_INVALID;
         }
@@ -820,8 +1058,11 @@ void pureLiteralStreamExec(struct hs_stream *stream_state,
     // start the match region at zero.
     const size_t start = 0;
 
+    PROFILE_ENGINE(scratch, HS_STATS_ENGINE_FLOATING, len2);
+    PROFILE_START(scratch);
     hwlmExecStreaming(ftable, len2, start, roseCallback, scratch,
                       rose->initialGroups & rose->floating_group_mask);
+    PROFILE_END_ENGINE(scratch, HS_STATS_ENGINE_FLOATING);
 
     if (!told_to_stop_matching(scratch) &&
         isAllExhausted(rose, scratch->core_info.exhaustionVector)) {
@@ -859,18 +1100,66 @@ void soleOutfixStreamExec(struct hs_stream *stream_state,
         pushQueueAt(q, 1, MQE_END, scratch->core_info.len);
     }
 
-    if (nfaQueueExec(q->nfa, q, scratch->core_info.len)) {
+    if (scratch->outfix_lane) {
+        /* skip what a batch lockstep pass has already scanned */
+        nfaExecMcClellan8_QResume(q, scratch->outfix_lane);
+    }
+
+    PROFILE_QUEUE_RUN(scratch, 0, 0, scratch->core_info.len);
+    PROFILE_START(scratch);
+    char alive = nfaQueueExec(q->nfa, q, scratch->core_info.len);
+    PROFILE_END_QUEUE(scratch, 0);
+    if (alive) {
         nfaQueueCompressState(nfa, q, scratch->core_info.len);
     } else if (!told_to_stop_matching(scratch)) {
         scratch->core_info.status |= STATUS_EXHAUSTED;
     }
 }
 
+/** \brief True if this write is tiny, the stream has nothing in flight and
+ * no byte of the write ends a floating literal: Rose would then find nothing
+ * to do beyond maintaining history. */
+static really_inline
+char tinyWriteIsQuiet(const struct RoseEngine *rose, const char *state,
+                      u64a offset, const u8 *data, size_t length) {
+    assert(length && length <= rose->tinyWriteLargestBuffer);
+    assert(rose->tinyWriteReachOffset);
+
+    if (!offset || offset < rose->anchoredDistance) {
+        return 0;
+    }
+
+    if (getStreamStatus(state) & STATUS_DELAY_DIRTY) {
+        return 0;
+    }
+
+    if (mmbit_any((const u8 *)state + ROSE_STATE_OFFSET_ROLE_MMBIT,
+                  rose->rolesWithStateCount) ||
+        mmbit_any((const u8 *)state + rose->stateOffsets.activeLeafArray,
+                  rose->activeArrayCount) ||
+        mmbit_any((const u8 *)state + rose->stateOffsets.activeLeftArray,
+                  rose->activeLeftCount)) {
+        return 0;
+    }
+
+    const u8 *reach = (const u8 *)rose + rose->tinyWriteReachOffset;
+    for (size_t i = 0; i < length; i++) {
+        u8 c = data[i];
+        if (reach[c / 8U] & (1U << (c % 8U))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/** \brief Stream write, scanning against the history at \a hbuf, which
+ * need not be in the stream state when the write replaces all of it. */
 static inline
-hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
-                                   unsigned length, UNUSED unsigned flags,
-                                   hs_scratch_t *scratch,
-                                   match_event_handler onEvent, void *context) {
+hs_error_t scanStreamWithHistory(hs_stream_t *id, const u8 *hbuf,
+                                 const char *data, unsigned length,
+                                 UNUSED unsigned flags, hs_scratch_t *scratch,
+                                 match_event_handler onEvent, void *context) {
     assert(id);
     assert(scratch);
 
@@ -901,10 +1190,17 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
         return HS_SUCCESS;
     }
 
-    u32 historyAmount = getHistoryAmount(rose, id->offset);
+    if (length <= rose->tinyWriteLargestBuffer &&
+        tinyWriteIsQuiet(rose, state, id->offset, (const u8 *)data, length)) {
+        DEBUG_PRINTF("quiet tiny write of %u bytes, skipping rose\n", length);
+        maintainHistoryBuffer(rose, state, data, length, id->offset);
+        id->offset += length;
+        return HS_SUCCESS;
+    }
+
+    u32 historyAmount = getHistoryAmount(rose, state, id->offset);
     populateCoreInfo(scratch, rose, state, onEvent, context, data, length,
-                     getHistory(state, rose, id->offset), historyAmount,
-                     id->offset, status, flags);
+                     hbuf, historyAmount, id->offset, status, flags);
     if (rose->ckeyCount) {
         scratch->core_info.logicalVector = state +
                                            rose->stateOffsets.logicalVec;
@@ -963,7 +1259,7 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
     if (unlikely(internal_matching_error(scratch))) {
         return HS_UNKNOWN_ERROR;
     } else if (likely(!can_stop_matching(scratch))) {
-        maintainHistoryBuffer(rose, state, data, length);
+        maintainHistoryBuffer(rose, state, data, length, id->offset);
         id->offset += length; /* maintain offset */
 
         if (rose->somLocationCount) {
@@ -976,6 +1272,16 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
     return HS_SUCCESS;
 }
 
+static really_inline
+hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
+                                   unsigned length, unsigned flags,
+                                   hs_scratch_t *scratch,
+                                   match_event_handler onEvent, void *context) {
+    const u8 *hbuf = getHistory(getMultiState(id), id->rose, id->offset);
+    return scanStreamWithHistory(id, hbuf, data, length, flags, scratch,
+                                 onEvent, context);
+}
+
 HS_PUBLIC_API
 hs_error_t HS_CDECL hs_scan_stream(hs_stream_t *id, const char *data,
                                    unsigned length, unsigned flags,
@@ -995,6 +1301,245 @@ hs_error_t HS_CDECL hs_scan_stream(hs_stream_t *id, const char *data,
     return rv;
 }
 
+/** \brief Stream write into a match buffer with the resume overflow policy.
+ *
+ * Matches are raised in order of end offset, so if the buffer overflows we can
+ * restore the stream to its state before the write and redo the write up to
+ * (but not including) the end offset of the first match that did not fit. All
+ * the matches raised by that shorter write were stored first time round, so
+ * this one will not overflow. On return, \a len holds the number of bytes
+ * written, which may be zero if nothing at all could be scanned. */
+static never_inline
+hs_error_t scanStreamResumable(hs_stream_t *id, const char *data,
+                               unsigned int *len, unsigned int flags,
+                               struct hs_scratch *scratch) {
+    const struct RoseEngine *rose = id->rose;
+    struct match_buffer *mb = &scratch->mbuf;
+    size_t stateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
+
+    if (unlikely(stateSize > scratch->bStateSize)) {
+        DEBUG_PRINTF("no room for snapshot\n");
+        return HS_INVALID;
+    }
+
+    const u32 count = mb->count;
+    const u64a dropped = mb->dropped;
+
+    for (;;) {
+        memcpy(scratch->bstate, id, stateSize);
+        mb->overflow_offset = ~0ULL;
+
+        hs_error_t rv = hs_scan_stream_internal(id, data, *len, flags, scratch,
+                                                NULL, NULL);
+        if (mb->overflow_offset == ~0ULL) {
+            return rv;
+        }
+
+        /* Rewind the stream and the match buffer. */
+        u64a stop = mb->overflow_offset;
+        memcpy(id, scratch->bstate, stateSize);
+        mb->count = count;
+        mb->dropped = dropped;
+        mb->overflow_offset = ~0ULL;
+
+        DEBUG_PRINTF("overflow at %llu, stream offset %llu\n", stop,
+                     id->offset);
+        if (stop <= id->offset + 1) {
+            *len = 0;
+            /* If the buffer was empty, draining it won't help. */
+            return count ? HS_SUCCESS : HS_INSUFFICIENT_SPACE;
+        }
+
+        assert(stop - 1 - id->offset < *len);
+        *len = stop - 1 - id->offset;
+    }
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_scan_stream_partial(hs_stream_t *id, const char *data,
+                                           unsigned int length,
+                                           unsigned int budget,
+                                           unsigned int flags,
+                                           hs_scratch_t *scratch,
+                                           match_event_handler onEvent,
+                                           void *context,
+                                           unsigned int *consumed) {
+    if (unlikely(!consumed)) {
+        return HS_INVALID;
+    }
+
+    *consumed = 0;
+
+    if (unlikely(!id || !scratch || !data || !budget ||
+                 !validScratch(id->rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    /* Streaming mode produces the same matches however the data is split
+     * into writes, so we can pause at any byte boundary simply by ending the
+     * write there; the stream state carries everything needed to resume. */
+    unsigned int len = MIN(length, budget);
+    DEBUG_PRINTF("partial scan of %u/%u bytes\n", len, length);
+
+    hs_error_t rv;
+    struct match_buffer *mb = &scratch->mbuf;
+    if (mb->buf && mb->policy == HS_MATCH_BUFFER_RESUME) {
+        rv = scanStreamResumable(id, data, &len, flags, scratch);
+    } else {
+        rv = hs_scan_stream_internal(id, data, len, flags, scratch, onEvent,
+                                     context);
+    }
+
+    if (rv == HS_SUCCESS || rv == HS_SCAN_TERMINATED) {
+        *consumed = len;
+    }
+
+    unmarkScratchInUse(scratch);
+    return rv;
+}
+
+/** \brief Prefetch the stream state touched at the start of a stream write.
+ *
+ * This covers the status flags and active engine arrays at the start of the
+ * state and the history buffer used to seed the literal matchers. The stream
+ * header must already be cached, as we need its RoseEngine pointer. */
+static really_inline
+void prefetch_stream_state(const struct hs_stream *id) {
+    const struct RoseEngine *rose = id->rose;
+    const char *state = getMultiStateConst(id);
+
+    __builtin_prefetch(state);
+    __builtin_prefetch(state + rose->stateOffsets.activeLeafArray);
+    __builtin_prefetch(state + rose->stateOffsets.groups);
+
+    if (rose->historyRequired && id->offset) {
+        const char *hist_end =
+            state + rose->stateOffsets.history + rose->historyRequired;
+        __builtin_prefetch(hist_end - getHistoryLength(rose, state,
+                                                       id->offset));
+        __builtin_prefetch(hist_end - 1);
+    }
+}
+
+/** \brief Runs the sole outfix DFAs of a group of streams over their writes
+ * in lockstep. Streams that cannot take part are given a lane with no DFA. */
+static never_inline
+void soleOutfixStreamLockstep(hs_stream_t *const *ids, const char *const *data,
+                              const unsigned int *length, u32 count,
+                              struct mcclellan_lane *lanes) {
+    assert(count <= MCCLELLAN_LOCKSTEP_MAX);
+
+    for (u32 i = 0; i < count; i++) {
+        const struct hs_stream *id = ids[i];
+        const struct RoseEngine *rose = id->rose;
+        const char *state = getMultiStateConst(id);
+        struct mcclellan_lane *lane = &lanes[i];
+
+        if (!soleOutfixCanLockstep(rose) ||
+            getStreamStatus(state) &
+                (STATUS_TERMINATED | STATUS_EXHAUSTED | STATUS_ERROR)) {
+            memset(lane, 0, sizeof(*lane));
+            continue;
+        }
+
+        const struct NfaInfo *info = getNfaInfoByQueue(rose, 0);
+        nfaExecMcClellan8_initLane(lane, getNfaByInfo(rose, info),
+                                   (const u8 *)data[i], length[i],
+                                   state + info->stateOffset, id->offset);
+    }
+
+    nfaExecMcClellan8_Lockstep(lanes, count);
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_scan_stream_batch(hs_stream_t *const *ids,
+                                         const char *const *data,
+                                         const unsigned int *length,
+                                         void *const *context,
+                                         unsigned int count, unsigned int flags,
+                                         hs_scratch_t *scratch,
+                                         match_event_handler onEvent) {
+    if (unlikely(!scratch || (count && (!ids || !data || !length)))) {
+        return HS_INVALID;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        if (unlikely(!ids[i] || !data[i])) {
+            return HS_INVALID;
+        }
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    /* Stream state is fetched in two stages: the hs_stream header two streams
+     * ahead, and then the state and history it points at one stream ahead,
+     * so that neither dependent load stalls the current scan. */
+    if (count) {
+        __builtin_prefetch(ids[0]);
+        if (count > 1) {
+            __builtin_prefetch(ids[1]);
+        }
+        prefetch_stream_state(ids[0]);
+        prefetch_data(data[0], length[0]);
+    }
+
+    /* As in hs_scan_batch(), streams whose database is a single DFA are run
+     * over their writes in lockstep a group at a time. */
+    const char lockstep = count > 1 && soleOutfixCanLockstep(ids[0]->rose);
+    struct mcclellan_lane lanes[MCCLELLAN_LOCKSTEP_MAX];
+
+    hs_error_t rv = HS_SUCCESS;
+    for (u32 i = 0; i < count; i++) {
+        hs_stream_t *id = ids[i];
+        DEBUG_PRINTF("batch stream %u/%u offset=%llu len=%u\n", i, count,
+                     id->offset, length[i]);
+
+        if (i + 2 < count) {
+            __builtin_prefetch(ids[i + 2]);
+        }
+        if (i + 1 < count) {
+            prefetch_stream_state(ids[i + 1]);
+            prefetch_data(data[i + 1], length[i + 1]);
+        }
+
+        if (unlikely(!validScratch(id->rose, scratch))) {
+            unmarkScratchInUse(scratch);
+            return HS_INVALID;
+        }
+
+        if (lockstep) {
+            u32 lane = i % MCCLELLAN_LOCKSTEP_MAX;
+            if (!lane) {
+                soleOutfixStreamLockstep(ids + i, data + i, length + i,
+                                         MIN(count - i, MCCLELLAN_LOCKSTEP_MAX),
+                                         lanes);
+            }
+            scratch->outfix_lane = lanes[lane].nfa ? &lanes[lane] : NULL;
+        }
+
+        hs_error_t ret = hs_scan_stream_internal(id, data[i], length[i], flags,
+                                                 scratch, onEvent,
+                                                 context ? context[i] : NULL);
+        scratch->outfix_lane = NULL;
+        if (unlikely(ret == HS_UNKNOWN_ERROR)) {
+            unmarkScratchInUse(scratch);
+            return ret;
+        } else if (ret == HS_SCAN_TERMINATED) {
+            DEBUG_PRINTF("stream %u terminated\n", i);
+            rv = HS_SCAN_TERMINATED;
+        }
+    }
+
+    unmarkScratchInUse(scratch);
+    return rv;
+}
+
 HS_PUBLIC_API
 hs_error_t HS_CDECL hs_close_stream(hs_stream_t *id, hs_scratch_t *scratch,
                                     match_event_handler onEvent,
@@ -1003,7 +1548,7 @@ hs_error_t HS_CDECL hs_close_stream(hs_stream_t *id, hs_scratch_t *scratch,
         return HS_INVALID;
     }
 
-    if (onEvent) {
+    if (wantEodMatches(scratch, onEvent)) {
         if (!scratch || !validScratch(id->rose, scratch)) {
             return HS_INVALID;
         }
@@ -1032,7 +1577,7 @@ hs_error_t HS_CDECL hs_reset_stream(hs_stream_t *id, UNUSED unsigned int flags,
         return HS_INVALID;
     }
 
-    if (onEvent) {
+    if (wantEodMatches(scratch, onEvent)) {
         if (!scratch || !validScratch(id->rose, scratch)) {
             return HS_INVALID;
         }
@@ -1053,6 +1598,67 @@ hs_error_t HS_CDECL hs_reset_stream(hs_stream_t *id, UNUSED unsigned int flags,
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_pool_open_stream(hs_stream_pool_t *pool,
+                                        UNUSED unsigned int flags,
+                                        hs_stream_t **stream) {
+    if (unlikely(!stream)) {
+        return HS_INVALID;
+    }
+
+    *stream = NULL;
+
+    if (unlikely(!validStreamPool(pool))) {
+        return HS_INVALID;
+    }
+
+    struct hs_stream *s = poolTakeSlot(pool);
+    if (unlikely(!s)) {
+        DEBUG_PRINTF("pool full (%u streams)\n", pool->live);
+        return HS_NOMEM;
+    }
+
+    init_stream(s, pool->rose, 1);
+
+    *stream = s;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_pool_close_stream(hs_stream_pool_t *pool,
+                                         hs_stream_t *id, hs_scratch_t *scratch,
+                                         match_event_handler onEvent,
+                                         void *context) {
+    if (!id || !validStreamPool(pool)) {
+        return HS_INVALID;
+    }
+
+    u32 idx = poolSlotIndex(pool, id);
+    if (idx == pool->capacity) {
+        DEBUG_PRINTF("stream is not open in this pool\n");
+        return HS_INVALID;
+    }
+
+    if (wantEodMatches(scratch, onEvent)) {
+        if (!scratch || !validScratch(id->rose, scratch)) {
+            return HS_INVALID;
+        }
+        if (unlikely(markScratchInUse(scratch))) {
+            return HS_SCRATCH_IN_USE;
+        }
+        report_eod_matches(id, scratch, onEvent, context);
+        if (unlikely(internal_matching_error(scratch))) {
+            unmarkScratchInUse(scratch);
+            return HS_UNKNOWN_ERROR;
+        }
+        unmarkScratchInUse(scratch);
+    }
+
+    poolReleaseSlot(pool, idx);
+
+    return HS_SUCCESS;
+}
+
 HS_PUBLIC_API
 hs_error_t HS_CDECL hs_stream_size(const hs_database_t *db,
                                    size_t *stream_size) {
@@ -1155,7 +1761,7 @@ hs_error_t HS_CDECL hs_scan_vector(const hs_database_t *db,
     }
 
     /* close stream */
-    if (onEvent) {
+    if (wantEodMatches(scratch, onEvent)) {
         report_eod_matches(id, scratch, onEvent, context);
 
         if (unlikely(internal_matching_error(scratch))) {
@@ -1199,6 +1805,151 @@ hs_error_t HS_CDECL hs_compress_stream(const hs_stream_t *stream, char *buf,
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_compress_stream_dense(const hs_stream_t *stream,
+                                             char *buf, size_t buf_space,
+                                             size_t *used_space) {
+    if (unlikely(!stream || !used_space)) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(buf_space && !buf)) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = stream->rose;
+
+    size_t stream_size = size_compress_stream_dense(rose, stream);
+
+    DEBUG_PRINTF("require %zu [orig %zu]\n", stream_size,
+                 rose->stateOffsets.end + sizeof(struct hs_stream));
+    *used_space = stream_size;
+
+    if (buf_space < stream_size) {
+        return HS_INSUFFICIENT_SPACE;
+    }
+    compress_stream_dense(buf, stream_size, rose, stream);
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_hibernate_stream(const hs_stream_t *stream, char *buf,
+                                        size_t buf_space, size_t *used_space) {
+    if (unlikely(!stream || !used_space)) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(buf_space && !buf)) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = stream->rose;
+
+    size_t stream_size = size_compress_stream_hibernate(rose, stream);
+
+    DEBUG_PRINTF("require %zu [orig %zu]\n", stream_size,
+                 rose->stateOffsets.end + sizeof(struct hs_stream));
+    *used_space = stream_size;
+
+    if (buf_space < stream_size) {
+        return HS_INSUFFICIENT_SPACE;
+    }
+    compress_stream_hibernate(buf, stream_size, rose, stream);
+
+    return HS_SUCCESS;
+}
+
+static really_inline
+void restoreHistory(struct hs_stream *s, const char *hist, size_t hlen) {
+    const struct RoseEngine *rose = s->rose;
+    char *hist_end = getMultiState(s) + rose->stateOffsets.history
+                   + rose->historyRequired;
+    memcpy(hist_end - hlen, hist, hlen);
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_wake_stream(const hs_database_t *db, const char *buf,
+                                   size_t buf_size, const char *data,
+                                   unsigned int length, unsigned int flags,
+                                   hs_scratch_t *scratch,
+                                   match_event_handler onEvent, void *context,
+                                   hs_stream_t **stream) {
+    if (unlikely(!stream)) {
+        return HS_INVALID;
+    }
+
+    *stream = NULL;
+
+    if (unlikely(!buf || !data || !scratch)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_STREAM)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    size_t stream_size = rose->stateOffsets.end + sizeof(struct hs_stream);
+
+    struct hs_stream *s = hs_stream_alloc(stream_size);
+    if (unlikely(!s)) {
+        return HS_NOMEM;
+    }
+
+    const char *hist;
+    size_t hlen;
+    if (!wake_stream(s, rose, buf, buf_size, &hist, &hlen)) {
+        hs_stream_free(s);
+        return HS_INVALID;
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        hs_stream_free(s);
+        return HS_SCRATCH_IN_USE;
+    }
+
+    hs_error_t rv;
+    u64a offset = s->offset;
+    if (hist && length >= rose->historyRequired && hlen >= 16) {
+        /* This write replaces the whole history buffer, so we can scan
+         * against the history where it lies in buf and never restore it. The
+         * literal matchers may read up to 16 bytes back from the end of the
+         * history, which must therefore lie in buf as well. */
+        DEBUG_PRINTF("scanning %u bytes against %zu bytes of history in buf\n",
+                     length, hlen);
+        rv = scanStreamWithHistory(s, (const u8 *)hist, data, length, flags,
+                                   scratch, onEvent, context);
+        if (s->offset == offset) {
+            /* the write did not complete; keep the stream whole */
+            restoreHistory(s, hist, hlen);
+        }
+    } else {
+        if (hist) {
+            restoreHistory(s, hist, hlen);
+        }
+        rv = hs_scan_stream_internal(s, data, length, flags, scratch, onEvent,
+                                     context);
+    }
+
+    unmarkScratchInUse(scratch);
+    *stream = s;
+    return rv;
+}
+
 HS_PUBLIC_API
 hs_error_t HS_CDECL hs_expand_stream(const hs_database_t *db,
                                      hs_stream_t **stream,
@@ -1251,7 +2002,7 @@ hs_error_t HS_CDECL hs_reset_and_expand_stream(hs_stream_t *to_stream,
 
     const struct RoseEngine *rose = to_stream->rose;
 
-    if (onEvent) {
+    if (wantEodMatches(scratch, onEvent)) {
         if (!scratch || !validScratch(to_stream->rose, scratch)) {
             return HS_INVALID;
         }
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Runtime profiling counters, kept in scratch when the library is built
+ * with RUNTIME_PROFILING.
+ *
+ * The PROFILE_* macros compile to nothing otherwise.
+ *
+ * Time is measured with the time stamp counter. Every PROFILE_START must be
+ * matched by exactly one PROFILE_END_* on all paths. Timed regions nest, and
+ * each region is only charged for the cycles not spent in regions nested
+ * inside it. The cycles of a queue run or program are also charged to the
+ * first expression it reports, so that costly patterns can be found without
+ * having to map programs back to expressions.
+ */
+
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include "hs_runtime.h"
+#include "ue2common.h"
+
+#ifdef RUNTIME_PROFILING
+
+#include "util/intrinsics.h"
+
+#define PROFILE_ENGINE_MAX (HS_STATS_ENGINE_CALLBACK + 1)
+
+/** \brief Deepest nesting of timed regions that is tracked; time spent in
+ * regions nested deeper than this is charged to their enclosing region. */
+#define PROFILE_TIMER_DEPTH 16
+
+/** \brief Report value used by a timed region that has not reported yet. */
+#define PROFILE_NO_REPORT 0xffffffffU
+
+/** \brief A single counter. */
+struct profile_slot {
+    u32 key;
+    u64a count;
+    u64a bytes;
+    u64a cycles;
+};
+
+/** \brief Open-addressed table of counters keyed by program offset or
+ * expression ID. A slot with a zero count is empty. */
+struct profile_table {
+    struct profile_slot *slots;
+    u32 size; /**< number of slots, a power of two */
+    u64a lost; /**< events that found the table full */
+};
+
+/** \brief A timed region in progress. */
+struct profile_timer {
+    u64a start;
+    u64a nested; /**< cycles spent in regions nested inside this one */
+    u32 report; /**< first expression reported, or PROFILE_NO_REPORT */
+};
+
+/** \brief All the counters kept in a scratch. */
+struct runtime_stats {
+    struct profile_slot engines[PROFILE_ENGINE_MAX];
+    struct profile_slot *queues; /**< indexed by qi */
+    u32 queueCount;
+    struct profile_table literals;
+    struct profile_table programs;
+    struct profile_table reports;
+    struct profile_timer timers[PROFILE_TIMER_DEPTH];
+    u32 timerDepth;
+};
+
+static really_inline
+void profileCount(struct profile_slot *slot, u64a bytes) {
+    slot->count++;
+    slot->bytes += bytes;
+}
+
+static really_inline
+void profileTableCount(struct profile_table *pt, u32 key) {
+    const u32 mask = pt->size - 1;
+    u32 i = (key * 0x9e3779b1U) & mask;
+    for (u32 n = 0; n < pt->size; n++, i = (i + 1) & mask) {
+        struct profile_slot *slot = &pt->slots[i];
+        if (!slot->count) {
+            slot->key = key;
+        } else if (slot->key != key) {
+            continue;
+        }
+        slot->count++;
+        return;
+    }
+    pt->lost++;
+}
+
+/** \brief Charge cycles to a key that has already been counted; cycles for
+ * keys that were lost are dropped. */
+static really_inline
+void profileTableCycles(struct profile_table *pt, u32 key, u64a cycles) {
+    const u32 mask = pt->size - 1;
+    u32 i = (key * 0x9e3779b1U) & mask;
+    for (u32 n = 0; n < pt->size; n++, i = (i + 1) & mask) {
+        struct profile_slot *slot = &pt->slots[i];
+        if (!slot->count) {
+            return;
+        }
+        if (slot->key == key) {
+            slot->cycles += cycles;
+            return;
+        }
+    }
+}
+
+static really_inline
+void profileQueueRun(struct runtime_stats *rs, u32 qi, s64a from, s64a to) {
+    assert(qi < rs->queueCount);
+    profileCount(&rs->queues[qi], to > from ? (u64a)(to - from) : 0);
+}
+
+/** \brief Returns the innermost timed region, or NULL if it is too deeply
+ * nested to be tracked. */
+static really_inline
+struct profile_timer *profileCurrentTimer(struct runtime_stats *rs) {
+    if (!rs->timerDepth || rs->timerDepth > PROFILE_TIMER_DEPTH) {
+        return NULL;
+    }
+    return &rs->timers[rs->timerDepth - 1];
+}
+
+static really_inline
+void profileReport(struct runtime_stats *rs, u32 id) {
+    profileTableCount(&rs->reports, id);
+    struct profile_timer *timer = profileCurrentTimer(rs);
+    if (timer && timer->report == PROFILE_NO_REPORT) {
+        timer->report = id;
+    }
+}
+
+static really_inline
+void profileTimerStart(struct runtime_stats *rs) {
+    if (rs->timerDepth < PROFILE_TIMER_DEPTH) {
+        struct profile_timer *timer = &rs->timers[rs->timerDepth];
+        timer->nested = 0;
+        timer->report = PROFILE_NO_REPORT;
+        timer->start = __rdtsc();
+    }
+    rs->timerDepth++;
+}
+
+/** \brief Ends the innermost timed region, returning the cycles spent in it
+ * outside any nested regions and the first expression it reported. */
+static really_inline
+u64a profileTimerStop(struct runtime_stats *rs, u32 *report) {
+    u64a now = __rdtsc();
+    const struct profile_timer *timer = profileCurrentTimer(rs);
+    assert(rs->timerDepth);
+    rs->timerDepth--;
+    if (!timer) {
+        *report = PROFILE_NO_REPORT;
+        return 0;
+    }
+    u64a total = now - timer->start;
+    struct profile_timer *parent = profileCurrentTimer(rs);
+    if (parent) {
+        parent->nested += total;
+    }
+    *report = timer->report;
+    return total > timer->nested ? total - timer->nested : 0;
+}
+
+static really_inline
+void profileEndEngine(struct runtime_stats *rs, u32 engine) {
+    u32 report;
+    rs->engines[engine].cycles += profileTimerStop(rs, &report);
+}
+
+static really_inline
+void profileEndQueue(struct runtime_stats *rs, u32 qi) {
+    u32 report;
+    u64a cycles = profileTimerStop(rs, &report);
+    rs->queues[qi].cycles += cycles;
+    if (report != PROFILE_NO_REPORT) {
+        profileTableCycles(&rs->reports, report, cycles);
+    }
+}
+
+static really_inline
+void profileEndLiteral(struct runtime_stats *rs, u32 program) {
+    u32 report;
+    u64a cycles = profileTimerStop(rs, &report);
+    profileTableCycles(&rs->literals, program, cycles);
+    if (report != PROFILE_NO_REPORT) {
+        profileTableCycles(&rs->reports, report, cycles);
+    }
+}
+
+/** \brief Ends a program run during catch up. A report made by the program is
+ * also credited to the queue run that raised it. */
+static really_inline
+void profileEndProgram(struct runtime_stats *rs, u32 program) {
+    u32 report;
+    u64a cycles = profileTimerStop(rs, &report);
+    profileTableCycles(&rs->programs, program, cycles);
+    if (report != PROFILE_NO_REPORT) {
+        profileTableCycles(&rs->reports, report, cycles);
+        struct profile_timer *parent = profileCurrentTimer(rs);
+        if (parent && parent->report == PROFILE_NO_REPORT) {
+            parent->report = report;
+        }
+    }
+}
+
+#define PROFILE_ENGINE(scratch, engine, len)                                  \
+    profileCount(&(scratch)->stats.engines[engine], len)
+#define PROFILE_QUEUE_RUN(scratch, qi, from, to)                              \
+    profileQueueRun(&(scratch)->stats, qi, from, to)
+#define PROFILE_LITERAL(scratch, program)                                     \
+    profileTableCount(&(scratch)->stats.literals, program)
+#define PROFILE_PROGRAM(scratch, program)                                     \
+    profileTableCount(&(scratch)->stats.programs, program)
+#define PROFILE_REPORT(scratch, id) profileReport(&(scratch)->stats, id)
+
+#define PROFILE_START(scratch) profileTimerStart(&(scratch)->stats)
+#define PROFILE_END_ENGINE(scratch, engine)                                   \
+    profileEndEngine(&(scratch)->stats, engine)
+#define PROFILE_END_QUEUE(scratch, qi) profileEndQueue(&(scratch)->stats, qi)
+#define PROFILE_END_LITERAL(scratch, program)                                 \
+    profileEndLiteral(&(scratch)->stats, program)
+#define PROFILE_END_PROGRAM(scratch, program)                                 \
+    profileEndProgram(&(scratch)->stats, program)
+
+#else // RUNTIME_PROFILING
+
+#define PROFILE_ENGINE(scratch, engine, len) do {} while (0)
+#define PROFILE_QUEUE_RUN(scratch, qi, from, to) do {} while (0)
+#define PROFILE_LITERAL(scratch, program) do {} while (0)
+#define PROFILE_PROGRAM(scratch, program) do {} while (0)
+#define PROFILE_REPORT(scratch, id) do {} while (0)
+#define PROFILE_START(scratch) do {} while (0)
+#define PROFILE_END_ENGINE(scratch, engine) do {} while (0)
+#define PROFILE_END_QUEUE(scratch, qi) do {} while (0)
+#define PROFILE_END_LITERAL(scratch, program) do {} while (0)
+#define PROFILE_END_PROGRAM(scratch, program) do {} while (0)
+
+#endif // RUNTIME_PROFILING
+
+#endif // RUNTIME_STATS_H
@@ -42,6 +42,7 @@
 #include "database.h"
 #include "nfa/nfa_api_queue.h"
 #include "rose/rose_internal.h"
+#include "util/bitutils.h"
 #include "util/fatbit.h"
 
 /**
@@ -68,6 +69,67 @@ size_t fatbit_array_size(u32 num_entries, u32 fatbit_len) {
     return ROUNDUP_N(len, 8); // Round up for potential padding.
 }
 
+#ifdef RUNTIME_PROFILING
+/** Number of slots to use in a profiling table that must hold up to n keys. */
+static
+u32 stats_table_size(u32 n) {
+    return 1U << (lg2(MAX(n, 1)) + 2);
+}
+
+/** Size the profiling tables in the prototype for the given database.
+ * Returns non-zero if they had to grow. */
+static
+int size_stats_tables(const struct RoseEngine *rose, struct runtime_stats *rs) {
+    /* literal matches are keyed by the program run for them, which may be a
+     * literal program or an anchored literal program */
+    u32 lit_count = rose->totalNumLiterals + rose->anchored_count;
+    u32 prog_count = lit_count + rose->delay_count + rose->reportProgramCount
+                     + 8; /* boundary, EOD and flush programs */
+    u32 report_count = rose->reportProgramCount + rose->ckeyCount;
+
+    struct profile_table *tables[] = { &rs->literals, &rs->programs,
+                                       &rs->reports };
+    u32 sizes[] = { stats_table_size(lit_count), stats_table_size(prog_count),
+                    stats_table_size(report_count) };
+
+    int resize = 0;
+    for (u32 i = 0; i < ARRAY_LENGTH(tables); i++) {
+        if (sizes[i] > tables[i]->size) {
+            resize = 1;
+            tables[i]->size = sizes[i];
+        }
+    }
+    return resize;
+}
+
+static
+size_t stats_slot_count(const struct hs_scratch *proto) {
+    const struct runtime_stats *rs = &proto->stats;
+    return (size_t)proto->queueCount + rs->literals.size + rs->programs.size +
+           rs->reports.size;
+}
+
+/** Point the profiling counters at their (zeroed) slots in the scratch
+ * region. */
+static
+char *init_stats(struct runtime_stats *rs, char *current, u32 queueCount) {
+    memset(rs->engines, 0, sizeof(rs->engines));
+    rs->timerDepth = 0;
+    rs->queues = (struct profile_slot *)current;
+    rs->queueCount = queueCount;
+    current += queueCount * sizeof(struct profile_slot);
+
+    struct profile_table *tables[] = { &rs->literals, &rs->programs,
+                                       &rs->reports };
+    for (u32 i = 0; i < ARRAY_LENGTH(tables); i++) {
+        tables[i]->slots = (struct profile_slot *)current;
+        tables[i]->lost = 0;
+        current += tables[i]->size * sizeof(struct profile_slot);
+    }
+    return current;
+}
+#endif
+
 /** Used by hs_alloc_scratch and hs_clone_scratch to allocate a complete
  * scratch region from a prototype structure. */
 static
@@ -98,6 +160,12 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
         anchored_literal_region_len, proto->anchored_literal_fatbit_size);
     size_t delay_region_size =
         fatbit_array_size(DELAY_SLOT_COUNT, proto->delay_fatbit_size);
+#ifdef RUNTIME_PROFILING
+    size_t stats_size = stats_slot_count(proto) * sizeof(struct profile_slot)
+                        + 8; /* alignment */
+#else
+    size_t stats_size = 0;
+#endif
 
     // the size is all the allocated stuff, not including the struct itself
     size_t size = queue_size + 63
@@ -113,7 +181,8 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
                   + som_store_size
                   + som_now_size
                   + som_attempted_size
-                  + som_attempted_store_size + 15;
+                  + som_attempted_store_size
+                  + stats_size + 15;
 
     /* the struct plus the allocated stuff plus padding for cacheline
      * alignment */
@@ -137,6 +206,7 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     s->scratchSize = alloc_size;
     s->scratch_alloc = (char *)s_tmp;
     s->fdr_conf = NULL;
+    s->outfix_lane = NULL;
 
     // each of these is at an offset from the previous
     char *current = (char *)s + sizeof(*s);
@@ -227,6 +297,11 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     s->fullStateSize = fullStateSize;
     current += fullStateSize;
 
+#ifdef RUNTIME_PROFILING
+    current = ROUNDUP_PTR(current, 8);
+    current = init_stats(&s->stats, current, queueCount);
+#endif
+
     *scratch = s;
 
     // Don't get too big for your boots
@@ -346,8 +421,10 @@ hs_error_t HS_CDECL hs_alloc_scratch(const hs_database_t *db,
     u32 bStateSize = 0;
     if (rose->mode == HS_MODE_BLOCK) {
         bStateSize = rose->stateOffsets.end;
-    } else if (rose->mode == HS_MODE_VECTORED) {
-        /* vectoring database require a full stream state (inc header) */
+    } else {
+        /* vectoring database require a full stream state (inc header);
+         * streaming databases use the same space to snapshot a stream when
+         * resuming after match buffer overflow */
         bStateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
     }
 
@@ -368,6 +445,12 @@ hs_error_t HS_CDECL hs_alloc_scratch(const hs_database_t *db,
         proto->deduper.log_size = rose->dkeyLogSize;
     }
 
+#ifdef RUNTIME_PROFILING
+    if (size_stats_tables(rose, &proto->stats)) {
+        resize = 1;
+    }
+#endif
+
     if (resize) {
         if (*scratch) {
             hs_scratch_free((*scratch)->scratch_alloc);
@@ -402,6 +485,9 @@ hs_error_t HS_CDECL hs_clone_scratch(const hs_scratch_t *src,
         return ret;
     }
 
+    /* the match buffer belongs to the source scratch's owner */
+    memset(&(*dest)->mbuf, 0, sizeof((*dest)->mbuf));
+
     assert(!(*dest)->in_use);
     return HS_SUCCESS;
 }
@@ -441,3 +527,161 @@ hs_error_t HS_CDECL hs_scratch_size(const hs_scratch_t *scratch, size_t *size) {
 
     return HS_SUCCESS;
 }
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_set_match_buffer(hs_scratch_t *scratch,
+                                        hs_match_t *matches,
+                                        unsigned int capacity,
+                                        unsigned int policy) {
+    if (!scratch || !ISALIGNED_CL(scratch) || scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+    if (matches && (!capacity || policy > HS_MATCH_BUFFER_RESUME)) {
+        return HS_INVALID;
+    }
+
+    if (markScratchInUse(scratch)) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    struct match_buffer *mb = &scratch->mbuf;
+    memset(mb, 0, sizeof(*mb));
+    if (matches) {
+        mb->buf = matches;
+        mb->capacity = capacity;
+        mb->policy = policy;
+    }
+    mb->overflow_offset = ~0ULL;
+
+    unmarkScratchInUse(scratch);
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_drain_match_buffer(hs_scratch_t *scratch,
+                                          unsigned int *count,
+                                          unsigned long long *dropped) {
+    if (!count || !scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC || !scratch->mbuf.buf) {
+        return HS_INVALID;
+    }
+
+    if (markScratchInUse(scratch)) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    struct match_buffer *mb = &scratch->mbuf;
+    *count = mb->count;
+    if (dropped) {
+        *dropped = mb->dropped;
+    }
+    mb->count = 0;
+    mb->dropped = 0;
+    mb->overflow_offset = ~0ULL;
+
+    unmarkScratchInUse(scratch);
+    return HS_SUCCESS;
+}
+
+#ifdef RUNTIME_PROFILING
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_scratch_stats(const hs_scratch_t *scratch,
+                                     hs_stats_entry_t *entries,
+                                     unsigned int capacity,
+                                     unsigned int *count) {
+    if (!count || !scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC || (capacity && !entries)) {
+        return HS_INVALID;
+    }
+
+    const struct runtime_stats *rs = &scratch->stats;
+    u32 n = 0;
+
+#define ADD_ENTRY(t, k, c, b, cy)                                             \
+    do {                                                                      \
+        if (n < capacity) {                                                   \
+            entries[n].type = (t);                                            \
+            entries[n].key = (k);                                             \
+            entries[n].count = (c);                                           \
+            entries[n].bytes = (b);                                           \
+            entries[n].cycles = (cy);                                         \
+        }                                                                     \
+        n++;                                                                  \
+    } while (0)
+
+    for (u32 i = 0; i < PROFILE_ENGINE_MAX; i++) {
+        const struct profile_slot *slot = &rs->engines[i];
+        if (slot->count) {
+            ADD_ENTRY(HS_STATS_ENGINE, i, slot->count, slot->bytes,
+                      slot->cycles);
+        }
+    }
+
+    for (u32 i = 0; i < rs->queueCount; i++) {
+        const struct profile_slot *slot = &rs->queues[i];
+        if (slot->count) {
+            ADD_ENTRY(HS_STATS_QUEUE, i, slot->count, slot->bytes,
+                      slot->cycles);
+        }
+    }
+
+    const struct profile_table *tables[] = { &rs->literals, &rs->programs,
+                                             &rs->reports };
+    const u32 types[] = { HS_STATS_LITERAL, HS_STATS_PROGRAM,
+                          HS_STATS_REPORT };
+    for (u32 t = 0; t < ARRAY_LENGTH(tables); t++) {
+        const struct profile_table *pt = tables[t];
+        for (u32 i = 0; i < pt->size; i++) {
+            const struct profile_slot *slot = &pt->slots[i];
+            if (slot->count) {
+                ADD_ENTRY(types[t], slot->key, slot->count, 0, slot->cycles);
+            }
+        }
+        if (pt->lost) {
+            ADD_ENTRY(types[t], HS_STATS_KEY_LOST, pt->lost, 0, 0);
+        }
+    }
+
+#undef ADD_ENTRY
+
+    *count = n;
+    return n > capacity ? HS_INSUFFICIENT_SPACE : HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_reset_scratch_stats(hs_scratch_t *scratch) {
+    if (!scratch || !ISALIGNED_CL(scratch) || scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+    if (markScratchInUse(scratch)) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    struct runtime_stats *rs = &scratch->stats;
+    memset(rs->queues, 0, stats_slot_count(scratch) *
+                              sizeof(struct profile_slot));
+    init_stats(rs, (char *)rs->queues, rs->queueCount);
+
+    unmarkScratchInUse(scratch);
+    return HS_SUCCESS;
+}
+
+#else // RUNTIME_PROFILING
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_scratch_stats(UNUSED const hs_scratch_t *scratch,
+                                     UNUSED hs_stats_entry_t *entries,
+                                     UNUSED unsigned int capacity,
+                                     UNUSED unsigned int *count) {
+    return HS_INVALID;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_reset_scratch_stats(UNUSED hs_scratch_t *scratch) {
+    return HS_INVALID;
+}
+
+#endif // RUNTIME_PROFILING
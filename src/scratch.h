@@ -37,6 +37,7 @@
 #define SCRATCH_H_DA6D4FC06FF410
 
 #include "hs_common.h"
+#include "runtime_stats.h"
 #include "ue2common.h"
 #include "rose/rose_types.h"
 
@@ -49,6 +50,7 @@ UNUSED static const u32 SCRATCH_MAGIC = 0x544F4259;
 
 struct fatbit;
 struct hs_scratch;
+struct mcclellan_lane;
 struct RoseEngine;
 struct mq;
 
@@ -164,6 +166,17 @@ struct match_deduper {
     u8 som_log_dirty;
 };
 
+/** \brief Caller-supplied match buffer, see \ref hs_set_match_buffer(). */
+struct match_buffer {
+    struct hs_match *buf; /**< match array, or NULL if not in use */
+    u32 capacity; /**< number of entries in buf */
+    u32 count; /**< number of entries currently filled */
+    u32 policy; /**< overflow policy, one of HS_MATCH_BUFFER_* */
+    u64a dropped; /**< number of matches that did not fit */
+    u64a overflow_offset; /**< end offset of the first match that did not
+                           * fit, or ~0ULL */
+};
+
 /** \brief Hyperscan scratch region header.
  *
  * NOTE: there is no requirement that scratch is 16-byte aligned, as it is
@@ -174,11 +187,12 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     u8 in_use; /**< non-zero when being used by an API call. */
     u32 queueCount;
     u32 activeQueueArraySize; /**< size of active queue array fatbit in bytes */
-    u32 bStateSize; /**< sizeof block mode states */
+    u32 bStateSize; /**< sizeof block mode states; in streaming mode, room
+                     * for a snapshot of a stream */
     u32 tStateSize; /**< sizeof transient rose states */
     u32 fullStateSize; /**< size of uncompressed nfa state */
     struct RoseContext tctxt;
-    char *bstate; /**< block mode states */
+    char *bstate; /**< block mode states, or stream snapshot */
     char *tstate; /**< state for transient roses */
     char *fullState; /**< uncompressed NFA state */
     struct mq *queues;
@@ -190,6 +204,7 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     struct catchup_pq catchup_pq;
     struct core_info core_info;
     struct match_deduper deduper;
+    struct match_buffer mbuf;
     u32 anchored_literal_region_len;
     u32 anchored_literal_fatbit_size; /**< size of each anch fatbit in bytes */
     struct fatbit *handled_roles; /**< fatbit of ROLES (not states) already
@@ -211,6 +226,12 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     u64a *fdr_conf; /**< FDR confirm value */
     u8 fdr_conf_offset; /**< offset where FDR/Teddy front end matches
                          * in buffer */
+    const struct mcclellan_lane *outfix_lane; /**< where the sole outfix
+                                               * resumes after a batch
+                                               * lockstep pass, or NULL */
+#ifdef RUNTIME_PROFILING
+    struct runtime_stats stats; /**< profiling counters */
+#endif
 };
 
 /* array of fatbit ptr; TODO: why not an array of fatbits? */
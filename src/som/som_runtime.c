@@ -39,6 +39,7 @@
  */
 
 #include "hs_internal.h"
+#include "match_buffer.h"
 #include "som_operation.h"
 #include "som_runtime.h"
 #include "scratch.h"
@@ -484,8 +485,8 @@ int clearSomLog(struct hs_scratch *scratch, u64a offset, struct fatbit *log,
              it != MMB_INVALID; it = fatbit_iterate(log, dkeyCount, it)) {
         u64a from_offset = starts[it];
         u32 onmatch = dkey_to_report[it];
-        int halt = ci->userCallback(onmatch, from_offset, offset, flags,
-                                    ci->userContext);
+        int halt = deliverUserMatch(scratch, onmatch, from_offset, offset,
+                                    flags);
         if (halt) {
             ci->status |= STATUS_TERMINATED;
             return 1;
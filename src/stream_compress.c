@@ -28,11 +28,14 @@
 
 #include "stream_compress.h"
 
+#include "scratch.h"
 #include "state.h"
+#include "nfa/nfa_api.h"
 #include "nfa/nfa_internal.h"
 #include "rose/rose_internal.h"
 #include "util/multibit.h"
 #include "util/multibit_compress.h"
+#include "util/unaligned.h"
 #include "util/uniform_ops.h"
 
 #include <string.h>
@@ -89,6 +92,180 @@
         DEBUG_PRINTF("co = %zu\n", currOffset);                             \
     } while (0);
 
+/*
+ * Dense form.
+ *
+ * The stream offset is stored as a u64a with DENSE_FLAG set, which marks the
+ * buffer as dense for expand_stream(). Every other region is zero-run coded:
+ * a control byte below DENSE_ZERO_RUN is followed by that many plus one
+ * literal bytes, while a control byte c at or above it stands for
+ * c - DENSE_ZERO_RUN + 1 zero bytes. Groups and outfix engine states are
+ * XORed with their initial values first, so that idle streams code to little
+ * more than their offset.
+ */
+
+#define DENSE_FLAG (1ULL << 63)
+#define HIBERNATE_FLAG (1ULL << 62)
+#define FORM_FLAGS (DENSE_FLAG | HIBERNATE_FLAG)
+#define DENSE_ZERO_RUN 0x80
+#define DENSE_RUN_MAX 128
+
+/** \brief Outfix states up to this size are coded as deltas. */
+#define DENSE_FRESH_MAX 256
+
+static really_inline
+u8 denseByte(const u8 *p, const u8 *base, size_t i) {
+    return base ? p[i] ^ base[i] : p[i];
+}
+
+/** \brief Codes \a sz bytes at \a p (XORed with \a base, if given) into
+ * \a buf at \a currOffset and returns the new offset. With a NULL \a buf,
+ * only measures. */
+static
+size_t denseEncode(char *buf, size_t currOffset, const u8 *p, const u8 *base,
+                   size_t sz) {
+    size_t i = 0;
+    while (i < sz) {
+        size_t len = 0;
+        while (i + len < sz && len < DENSE_RUN_MAX &&
+               !denseByte(p, base, i + len)) {
+            len++;
+        }
+        if (len) {
+            if (buf) {
+                buf[currOffset] = (char)(DENSE_ZERO_RUN + len - 1);
+            }
+            currOffset++;
+            i += len;
+            continue;
+        }
+
+        /* Literal run: lone zero bytes are cheaper to carry than to code. */
+        while (i + len < sz && len < DENSE_RUN_MAX) {
+            if (!denseByte(p, base, i + len) &&
+                (i + len + 1 == sz || !denseByte(p, base, i + len + 1))) {
+                break;
+            }
+            len++;
+        }
+        assert(len);
+        if (buf) {
+            buf[currOffset] = (char)(len - 1);
+            for (size_t j = 0; j < len; j++) {
+                buf[currOffset + 1 + j] = (char)denseByte(p, base, i + j);
+            }
+        }
+        currOffset += 1 + len;
+        i += len;
+    }
+    DEBUG_PRINTF("co = %zu\n", currOffset);
+    return currOffset;
+}
+
+/** \brief Inverse of denseEncode(); returns zero if \a buf is malformed. */
+static
+size_t denseDecode(u8 *p, const u8 *base, size_t sz, const char *buf,
+                   size_t buf_size, size_t currOffset) {
+    size_t i = 0;
+    while (i < sz) {
+        if (currOffset >= buf_size) {
+            return 0;
+        }
+        u8 c = (u8)buf[currOffset++];
+        size_t len = (c & (DENSE_ZERO_RUN - 1)) + 1;
+        if (len > sz - i) {
+            return 0;
+        }
+        if (c & DENSE_ZERO_RUN) {
+            if (base) {
+                memcpy(p + i, base + i, len);
+            } else {
+                memset(p + i, 0, len);
+            }
+        } else {
+            if (len > buf_size - currOffset) {
+                return 0;
+            }
+            for (size_t j = 0; j < len; j++) {
+                p[i + j] = (u8)buf[currOffset + j] ^ (base ? base[i + j] : 0);
+            }
+            currOffset += len;
+        }
+        i += len;
+    }
+    DEBUG_PRINTF("co = %zu\n", currOffset);
+    return currOffset;
+}
+
+/** \brief True if the state of queue \a qi is coded against a fresh state,
+ * which is then written to \a fresh. */
+static really_inline
+int denseFreshState(const struct RoseEngine *rose, u32 qi,
+                    const struct NFA *nfa, u64a offset, u8 *fresh) {
+    if (qi < rose->outfixBeginQueue || qi >= rose->outfixEndQueue ||
+        nfa->streamStateSize > DENSE_FRESH_MAX) {
+        return 0;
+    }
+    memset(fresh, 0, nfa->streamStateSize);
+    nfaInitCompressedState(nfa, offset, fresh, 0);
+    return 1;
+}
+
+#define DENSE_COPY_IN(p, base, sz) do {                                     \
+        currOffset = denseEncode(buf, currOffset, (const u8 *)(p),          \
+                                 (const u8 *)(base), sz);                   \
+    } while (0);
+
+#define DENSE_COPY_OUT(p, base, sz) do {                                    \
+        currOffset = denseDecode((u8 *)(p), (const u8 *)(base), sz, buf,    \
+                                 buf_size, currOffset);                     \
+        if (!currOffset) {                                                  \
+            return 0; /* error */                                           \
+        }                                                                   \
+    } while (0);
+
+#define DENSE_COPY_SIZE(p, base, sz) do {                                   \
+        currOffset = denseEncode(NULL, currOffset, (const u8 *)(p),         \
+                                 (const u8 *)(base), sz);                   \
+    } while (0);
+
+#define FORM_OFFSET_IN(x, flags) do {                                       \
+        u64a hdr = (x) | (flags);                                           \
+        COPY_IN(&hdr, sizeof(hdr));                                         \
+    } while (0);
+
+#define FORM_OFFSET_OUT(x, flags) do {                                      \
+        u64a hdr;                                                           \
+        COPY_OUT(&hdr, sizeof(hdr));                                        \
+        if ((hdr & FORM_FLAGS) != (flags)) {                                \
+            return 0; /* error */                                           \
+        }                                                                   \
+        (x) = hdr & ~FORM_FLAGS;                                            \
+    } while (0);
+
+#define DENSE_OFFSET_IN(x) FORM_OFFSET_IN(x, DENSE_FLAG)
+#define DENSE_OFFSET_OUT(x) FORM_OFFSET_OUT(x, DENSE_FLAG)
+#define HIBERNATE_OFFSET_IN(x) FORM_OFFSET_IN(x, FORM_FLAGS)
+#define HIBERNATE_OFFSET_OUT(x) FORM_OFFSET_OUT(x, FORM_FLAGS)
+
+/* Steps over a region that the caller restores itself, if at all. */
+#define SKIP_OUT(p, sz) do {                                                \
+        if (currOffset + sz > buf_size) {                                   \
+            return 0;                                                       \
+        }                                                                   \
+        currOffset += sz;                                                   \
+        DEBUG_PRINTF("co = %zu\n", currOffset);                             \
+    } while (0);
+
+#define DENSE_NFA_STATE(qi, nfa, p, offset) do {                            \
+        u8 fresh[DENSE_FRESH_MAX];                                          \
+        if (denseFreshState(rose, qi, nfa, offset, fresh)) {                \
+            COPY_DELTA(p, fresh, (nfa)->streamStateSize);                   \
+        } else {                                                            \
+            COPY(p, (nfa)->streamStateSize);                                \
+        }                                                                   \
+    } while (0);
+
 #define COPY COPY_OUT
 #define COPY_MULTIBIT COPY_MULTIBIT_OUT
 #define ASSIGN(lhs, rhs) do { lhs = rhs; } while (0)
@@ -97,11 +274,6 @@
 #define BUF_QUAL const
 #include "stream_compress_impl.h"
 
-int expand_stream(struct hs_stream *stream, const struct RoseEngine *rose,
-                  const char *buf, size_t buf_size) {
-    return sc_expand(rose, stream, buf, buf_size);
-}
-
 #define COPY COPY_IN
 #define COPY_MULTIBIT COPY_MULTIBIT_IN
 #define ASSIGN(lhs, rhs) do { } while (0)
@@ -128,3 +300,172 @@ size_t size_compress_stream(const struct RoseEngine *rose,
                             const struct hs_stream *stream) {
     return sc_size(rose, stream, NULL, 0);
 }
+
+#define COPY(p, sz) DENSE_COPY_OUT(p, NULL, sz)
+#define COPY_DELTA DENSE_COPY_OUT
+#define COPY_OFFSET DENSE_OFFSET_OUT
+#define COPY_NFA_STATE DENSE_NFA_STATE
+#define COPY_MULTIBIT COPY_MULTIBIT_OUT
+#define ASSIGN(lhs, rhs) do { lhs = rhs; } while (0)
+#define TRIM_BROKEN_STREAMS
+#define CLEAR_TRIMMED(p, sz) memset(p, 0, sz)
+#define FN_SUFFIX expand_dense
+#define STREAM_QUAL
+#define BUF_QUAL const
+#include "stream_compress_impl.h"
+
+#define COPY(p, sz) DENSE_COPY_IN(p, NULL, sz)
+#define COPY_DELTA DENSE_COPY_IN
+#define COPY_OFFSET DENSE_OFFSET_IN
+#define COPY_NFA_STATE DENSE_NFA_STATE
+#define COPY_MULTIBIT COPY_MULTIBIT_IN
+#define ASSIGN(lhs, rhs) do { } while (0)
+#define TRIM_BROKEN_STREAMS
+#define FN_SUFFIX compress_dense
+#define STREAM_QUAL const
+#define BUF_QUAL
+#include "stream_compress_impl.h"
+
+size_t compress_stream_dense(char *buf, size_t buf_size,
+                             const struct RoseEngine *rose,
+                             const struct hs_stream *stream) {
+    assert(!(stream->offset & DENSE_FLAG));
+    return sc_compress_dense(rose, stream, buf, buf_size);
+}
+
+#define COPY(p, sz) DENSE_COPY_SIZE(p, NULL, sz)
+#define COPY_DELTA DENSE_COPY_SIZE
+#define COPY_OFFSET(x) SIZE_COPY_IN(&(x), sizeof(x))
+#define COPY_NFA_STATE DENSE_NFA_STATE
+#define COPY_MULTIBIT COPY_MULTIBIT_SIZE
+#define ASSIGN(lhs, rhs) do { } while (0)
+#define TRIM_BROKEN_STREAMS
+#define FN_SUFFIX size_dense
+#define STREAM_QUAL const
+#define BUF_QUAL UNUSED
+#include "stream_compress_impl.h"
+
+size_t size_compress_stream_dense(const struct RoseEngine *rose,
+                                  const struct hs_stream *stream) {
+    return sc_size_dense(rose, stream, NULL, 0);
+}
+
+/*
+ * Hibernated form: the dense form with HIBERNATE_FLAG also set in the offset
+ * word, and the history moved to the end of the buffer and left uncoded. A
+ * stream can then be woken by scanning its next write against the history
+ * where it lies in the buffer, without restoring it into the stream.
+ */
+
+#define COPY(p, sz) DENSE_COPY_OUT(p, NULL, sz)
+#define COPY_DELTA DENSE_COPY_OUT
+#define COPY_OFFSET HIBERNATE_OFFSET_OUT
+#define COPY_NFA_STATE DENSE_NFA_STATE
+#define COPY_MULTIBIT COPY_MULTIBIT_OUT
+#define COPY_RAW SKIP_OUT
+#define ASSIGN(lhs, rhs) do { lhs = rhs; } while (0)
+#define TRIM_BROKEN_STREAMS
+#define CLEAR_TRIMMED(p, sz) memset(p, 0, sz)
+#define HISTORY_LAST
+#define FN_SUFFIX expand_hibernate
+#define STREAM_QUAL
+#define BUF_QUAL const
+#include "stream_compress_impl.h"
+
+#define COPY(p, sz) DENSE_COPY_IN(p, NULL, sz)
+#define COPY_DELTA DENSE_COPY_IN
+#define COPY_OFFSET HIBERNATE_OFFSET_IN
+#define COPY_NFA_STATE DENSE_NFA_STATE
+#define COPY_MULTIBIT COPY_MULTIBIT_IN
+#define COPY_RAW COPY_IN
+#define ASSIGN(lhs, rhs) do { } while (0)
+#define TRIM_BROKEN_STREAMS
+#define HISTORY_LAST
+#define FN_SUFFIX compress_hibernate
+#define STREAM_QUAL const
+#define BUF_QUAL
+#include "stream_compress_impl.h"
+
+size_t compress_stream_hibernate(char *buf, size_t buf_size,
+                                 const struct RoseEngine *rose,
+                                 const struct hs_stream *stream) {
+    assert(!(stream->offset & FORM_FLAGS));
+    return sc_compress_hibernate(rose, stream, buf, buf_size);
+}
+
+#define COPY(p, sz) DENSE_COPY_SIZE(p, NULL, sz)
+#define COPY_DELTA DENSE_COPY_SIZE
+#define COPY_OFFSET(x) SIZE_COPY_IN(&(x), sizeof(x))
+#define COPY_NFA_STATE DENSE_NFA_STATE
+#define COPY_MULTIBIT COPY_MULTIBIT_SIZE
+#define COPY_RAW SIZE_COPY_IN
+#define ASSIGN(lhs, rhs) do { } while (0)
+#define TRIM_BROKEN_STREAMS
+#define HISTORY_LAST
+#define FN_SUFFIX size_hibernate
+#define STREAM_QUAL const
+#define BUF_QUAL UNUSED
+#include "stream_compress_impl.h"
+
+size_t size_compress_stream_hibernate(const struct RoseEngine *rose,
+                                      const struct hs_stream *stream) {
+    return sc_size_hibernate(rose, stream, NULL, 0);
+}
+
+static really_inline
+u64a formFlags(const char *buf, size_t buf_size) {
+    if (buf_size < sizeof(u64a)) {
+        return 0;
+    }
+    u64a flags = unaligned_load_u64a(buf) & FORM_FLAGS;
+    /* standard offsets never have DENSE_FLAG set */
+    return (flags & DENSE_FLAG) ? flags : 0;
+}
+
+int wake_stream(struct hs_stream *stream, const struct RoseEngine *rose,
+                const char *buf, size_t buf_size, const char **hist,
+                size_t *hlen) {
+    *hist = NULL;
+    *hlen = 0;
+
+    if (formFlags(buf, buf_size) != FORM_FLAGS) {
+        return expand_stream(stream, rose, buf, buf_size);
+    }
+
+    size_t end = sc_expand_hibernate(rose, stream, buf, buf_size);
+    if (!end) {
+        return 0;
+    }
+
+    /* broken streams are trimmed before the history */
+    const u8 status = *(const u8 *)(getMultiStateConst(stream) +
+                                    ROSE_STATE_OFFSET_STATUS_FLAGS);
+    if (!(status & (STATUS_TERMINATED | STATUS_EXHAUSTED | STATUS_ERROR))) {
+        *hlen = getHistoryLength(rose, getMultiStateConst(stream),
+                                 stream->offset);
+    }
+    assert(*hlen <= end);
+    *hist = buf + end - *hlen;
+    return 1;
+}
+
+int expand_stream(struct hs_stream *stream, const struct RoseEngine *rose,
+                  const char *buf, size_t buf_size) {
+    switch (formFlags(buf, buf_size)) {
+    case DENSE_FLAG:
+        return sc_expand_dense(rose, stream, buf, buf_size);
+    case FORM_FLAGS: {
+        const char *hist;
+        size_t hlen;
+        if (!wake_stream(stream, rose, buf, buf_size, &hist, &hlen)) {
+            return 0;
+        }
+        char *hist_end = getMultiState(stream) + rose->stateOffsets.history
+                       + rose->historyRequired;
+        memcpy(hist_end - hlen, hist, hlen);
+        return 1;
+    }
+    default:
+        return sc_expand(rose, stream, buf, buf_size);
+    }
+}
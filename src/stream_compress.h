@@ -48,4 +48,26 @@ size_t compress_stream(char *buf, size_t buf_size,
 size_t size_compress_stream(const struct RoseEngine *rose,
                             const struct hs_stream *stream);
 
+size_t compress_stream_dense(char *buf, size_t buf_size,
+                             const struct RoseEngine *rose,
+                             const struct hs_stream *src);
+
+size_t size_compress_stream_dense(const struct RoseEngine *rose,
+                                  const struct hs_stream *stream);
+
+size_t compress_stream_hibernate(char *buf, size_t buf_size,
+                                 const struct RoseEngine *rose,
+                                 const struct hs_stream *src);
+
+size_t size_compress_stream_hibernate(const struct RoseEngine *rose,
+                                      const struct hs_stream *stream);
+
+/** \brief Expands a compressed stream of any form. For the hibernated form,
+ * the history is not restored: it is left in \a buf, at \a *hist for
+ * \a *hlen bytes. Otherwise \a *hist is NULL. Returns zero if \a buf is
+ * malformed. */
+int wake_stream(struct hs_stream *out, const struct RoseEngine *rose,
+                const char *buf, size_t buf_size, const char **hist,
+                size_t *hlen);
+
 #endif
@@ -29,6 +29,20 @@
 #include "util/join.h"
 
 #define COPY_FIELD(x) COPY(&x, sizeof(x))
+
+/* Forms that code some fields specially override these. */
+#ifndef COPY_OFFSET
+#define COPY_OFFSET(x) COPY_FIELD(x)
+#endif
+#ifndef COPY_DELTA
+#define COPY_DELTA(p, base, sz) COPY(p, sz)
+#endif
+#ifndef COPY_NFA_STATE
+#define COPY_NFA_STATE(qi, nfa, p, offset) COPY(p, (nfa)->streamStateSize)
+#endif
+#ifndef CLEAR_TRIMMED
+#define CLEAR_TRIMMED(p, sz) do { } while (0)
+#endif
 #define COPY_LEFTFIXES JOIN(sc_left_, FN_SUFFIX)
 #define COPY_SOM_INFO JOIN(sc_som_, FN_SUFFIX)
 
@@ -115,16 +129,33 @@ size_t JOIN(sc_, FN_SUFFIX)(const struct RoseEngine *rose,
     STREAM_QUAL char *stream_body
         = ((STREAM_QUAL char *)stream) + sizeof(struct hs_stream);
 
-    COPY_FIELD(stream->offset);
+    COPY_OFFSET(stream->offset);
     ASSIGN(stream->rose, rose);
 
     COPY(stream_body + ROSE_STATE_OFFSET_STATUS_FLAGS, 1);
+
+#ifdef TRIM_BROKEN_STREAMS
+    /* A broken stream is never scanned again and raises nothing at EOD, so
+     * only its offset and status survive; a reset reinitialises the rest.
+     * On expansion the rest is cleared, as it may still be copied or
+     * compressed. */
+    if (*(const u8 *)(stream_body + ROSE_STATE_OFFSET_STATUS_FLAGS) &
+        (STATUS_TERMINATED | STATUS_EXHAUSTED | STATUS_ERROR)) {
+        CLEAR_TRIMMED(stream_body + ROSE_STATE_OFFSET_STATUS_FLAGS + 1,
+                      so->end - (ROSE_STATE_OFFSET_STATUS_FLAGS + 1));
+        return currOffset;
+    }
+#endif
+
     COPY_MULTIBIT(stream_body + ROSE_STATE_OFFSET_ROLE_MMBIT, rose->rolesWithStateCount);
 
     /* stream is valid in compress/size, and stream->offset has been set already
      * on the expand side */
     u64a offset = stream->offset;
-    u32 history = MIN((u32)offset, rose->historyRequired);
+    if (so->historyLength) {
+        COPY(stream_body + so->historyLength, 1);
+    }
+    u32 history = getHistoryLength(rose, stream_body, offset);
 
     /* copy the active mmbits */
     COPY_MULTIBIT(stream_body + so->activeLeafArray, rose->activeArrayCount);
@@ -139,11 +170,14 @@ size_t JOIN(sc_, FN_SUFFIX)(const struct RoseEngine *rose,
         COPY(stream_body + so->anchorState, rose->anchorStateSize);
     }
 
-    COPY(stream_body + so->groups, so->groups_size);
+    COPY_DELTA(stream_body + so->groups, (const u8 *)&rose->initialGroups,
+               so->groups_size);
 
     /* copy the real bits of history */
     UNUSED u32 hend = so->history + rose->historyRequired;
+#ifndef HISTORY_LAST
     COPY(stream_body + hend - history, history);
+#endif
 
     /* copy the exhaustion multibit */
     COPY_MULTIBIT(stream_body + so->exhausted, rose->ekeyCount);
@@ -165,7 +199,7 @@ size_t JOIN(sc_, FN_SUFFIX)(const struct RoseEngine *rose,
         DEBUG_PRINTF("saving stream state for qi=%u\n", qi);
         const struct NfaInfo *nfa_info = getNfaInfoByQueue(rose, qi);
         const struct NFA *nfa = getNfaByInfo(rose, nfa_info);
-        COPY(stream_body + nfa_info->stateOffset, nfa->streamStateSize);
+        COPY_NFA_STATE(qi, nfa, stream_body + nfa_info->stateOffset, offset);
     }
 
     /* copy nfa stream state for leftfixes */
@@ -179,12 +213,24 @@ size_t JOIN(sc_, FN_SUFFIX)(const struct RoseEngine *rose,
         return 0;
     }
 
+#ifdef HISTORY_LAST
+    /* history goes last and uncoded, so that it can be scanned in place */
+    COPY_RAW(stream_body + hend - history, history);
+#endif
+
     return currOffset;
 }
 
 #undef ASSIGN
 #undef COPY
 #undef COPY_FIELD
+#undef COPY_OFFSET
+#undef COPY_DELTA
+#undef COPY_NFA_STATE
+#undef TRIM_BROKEN_STREAMS
+#undef CLEAR_TRIMMED
+#undef HISTORY_LAST
+#undef COPY_RAW
 #undef COPT_LEFTFIXES
 #undef COPY_MULTIBIT
 #undef COPY_SOM_INFO
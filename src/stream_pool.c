@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Stream pool creation, iteration and compaction.
+ *
+ * Opening and closing pooled streams needs the Rose runtime and lives in
+ * runtime.c.
+ */
+
+#include "stream_pool.h"
+
+#include "allocator.h"
+#include "database.h"
+#include "hs_internal.h"
+#include "rose/rose_internal.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static
+hs_error_t poolLayout(const hs_database_t *db, unsigned int capacity,
+                      const struct RoseEngine **rose_out, size_t *slot_size,
+                      size_t *pool_size) {
+    if (!capacity) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_STREAM)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    size_t slot = ROUNDUP_N(sizeof(struct hs_stream) + rose->stateOffsets.end,
+                            STREAM_SLOT_ALIGN);
+    size_t header = ROUNDUP_N(sizeof(struct hs_stream_pool), STREAM_POOL_ALIGN);
+    if (capacity > (SIZE_MAX - header) / slot) {
+        return HS_INVALID;
+    }
+
+    *rose_out = rose;
+    *slot_size = slot;
+    *pool_size = header + (size_t)capacity * slot;
+    return HS_SUCCESS;
+}
+
+/** \brief Marks every slot free, chained in ascending order from \a first. */
+static
+void poolInitFreeList(struct hs_stream_pool *pool, u32 first) {
+    for (u32 i = first; i < pool->capacity; i++) {
+        struct hs_stream *s = poolSlot(pool, i);
+        s->rose = NULL;
+        s->offset = i + 1;
+    }
+    pool->free_head = first;
+}
+
+static
+void poolInit(struct hs_stream_pool *pool, const struct RoseEngine *rose,
+              unsigned int capacity, size_t slot_size, char *pool_alloc) {
+    memset(pool, 0, sizeof(*pool));
+    pool->magic = STREAM_POOL_MAGIC;
+    pool->capacity = capacity;
+    pool->slot_size = slot_size;
+    pool->rose = rose;
+    pool->slots = (char *)pool + ROUNDUP_N(sizeof(struct hs_stream_pool),
+                                           STREAM_POOL_ALIGN);
+    pool->pool_alloc = pool_alloc;
+    poolInitFreeList(pool, 0);
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_stream_pool_size(const hs_database_t *db,
+                                        unsigned int capacity,
+                                        size_t *pool_size) {
+    if (!pool_size) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose;
+    size_t slot_size;
+    return poolLayout(db, capacity, &rose, &slot_size, pool_size);
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_alloc_stream_pool(const hs_database_t *db,
+                                         unsigned int capacity,
+                                         hs_stream_pool_t **pool) {
+    if (!pool) {
+        return HS_INVALID;
+    }
+    *pool = NULL;
+
+    const struct RoseEngine *rose;
+    size_t slot_size, pool_size;
+    hs_error_t err = poolLayout(db, capacity, &rose, &slot_size, &pool_size);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    if (pool_size > SIZE_MAX - STREAM_POOL_ALIGN) {
+        return HS_NOMEM;
+    }
+
+    char *mem = hs_stream_alloc(pool_size + STREAM_POOL_ALIGN);
+    err = hs_check_alloc(mem);
+    if (err != HS_SUCCESS) {
+        hs_stream_free(mem);
+        return err;
+    }
+
+    struct hs_stream_pool *p =
+        (struct hs_stream_pool *)ROUNDUP_PTR(mem, STREAM_POOL_ALIGN);
+    poolInit(p, rose, capacity, slot_size, mem);
+    DEBUG_PRINTF("pool of %u slots of %zu bytes\n", capacity, slot_size);
+
+    *pool = p;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_init_stream_pool_at(const hs_database_t *db,
+                                           unsigned int capacity, void *mem,
+                                           hs_stream_pool_t **pool) {
+    if (!pool) {
+        return HS_INVALID;
+    }
+    *pool = NULL;
+
+    if (!mem) {
+        return HS_INVALID;
+    }
+
+    if (!ISALIGNED_N(mem, STREAM_POOL_ALIGN)) {
+        return HS_BAD_ALIGN;
+    }
+
+    const struct RoseEngine *rose;
+    size_t slot_size, pool_size;
+    hs_error_t err = poolLayout(db, capacity, &rose, &slot_size, &pool_size);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    struct hs_stream_pool *p = mem;
+    poolInit(p, rose, capacity, slot_size, NULL);
+
+    *pool = p;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_free_stream_pool(hs_stream_pool_t *pool) {
+    if (!pool) {
+        return HS_SUCCESS;
+    }
+
+    if (!validStreamPool(pool)) {
+        return HS_INVALID;
+    }
+
+    pool->magic = 0;
+    if (pool->pool_alloc) {
+        hs_stream_free(pool->pool_alloc);
+    }
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_iterate_stream_pool(hs_stream_pool_t *pool,
+                                           hs_stream_visitor_t visit,
+                                           void *context) {
+    if (!validStreamPool(pool) || !visit) {
+        return HS_INVALID;
+    }
+
+    u32 seen = 0;
+    for (u32 i = 0; i < pool->capacity && seen < pool->live; i++) {
+        struct hs_stream *s = poolSlot(pool, i);
+        if (!s->rose) {
+            continue;
+        }
+        seen++;
+        if (visit(s, context)) {
+            DEBUG_PRINTF("iteration stopped at slot %u\n", i);
+            break;
+        }
+    }
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t HS_CDECL hs_compact_stream_pool(hs_stream_pool_t *pool,
+                                           hs_stream_relocate_t relocate,
+                                           void *context) {
+    if (!validStreamPool(pool)) {
+        return HS_INVALID;
+    }
+
+    // Move the highest live stream into the lowest free slot until the two
+    // meet; every slot below `live' is then in use.
+    u32 lo = 0;
+    u32 hi = pool->capacity;
+    for (;;) {
+        while (lo < hi && poolSlot(pool, lo)->rose) {
+            lo++;
+        }
+        while (hi > lo && !poolSlot(pool, hi - 1)->rose) {
+            hi--;
+        }
+        if (lo + 1 >= hi) {
+            break;
+        }
+        struct hs_stream *from = poolSlot(pool, hi - 1);
+        struct hs_stream *to = poolSlot(pool, lo);
+        DEBUG_PRINTF("moving slot %u to %u\n", hi - 1, lo);
+        memcpy(to, from, pool->slot_size);
+        from->rose = NULL;
+        if (relocate) {
+            relocate(from, to, context);
+        }
+    }
+
+    assert(lo == pool->live);
+    poolInitFreeList(pool, pool->live);
+    return HS_SUCCESS;
+}
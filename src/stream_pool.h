@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Stream pools: fixed-size stream slots packed into one region.
+ */
+
+#ifndef STREAM_POOL_H
+#define STREAM_POOL_H
+
+#include "hs_runtime.h"
+#include "state.h"
+#include "ue2common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define STREAM_POOL_MAGIC   (0x50535348U)
+
+/** \brief Alignment of the slot region; each slot is a multiple of this. */
+#define STREAM_POOL_ALIGN   64
+
+/** \brief Slots are padded to this granularity, as heap streams are. */
+#define STREAM_SLOT_ALIGN   16
+
+/** \brief A stream pool.
+ *
+ * The header is followed (at the next cacheline) by \ref capacity slots of
+ * \ref slot_size bytes, each holding a struct hs_stream and its Rose state.
+ * A free slot has a NULL rose pointer and keeps the index of the next free
+ * slot in its offset field, so open and close are O(1) and touch nothing but
+ * the slot itself and the pool header.
+ */
+struct hs_stream_pool {
+    u32 magic;
+    u32 capacity; //!< number of slots
+    u32 live; //!< number of open streams
+    u32 free_head; //!< first free slot, or capacity if the pool is full
+    size_t slot_size; //!< bytes per slot
+    const struct RoseEngine *rose; //!< engine all streams are opened against
+    char *slots; //!< first slot
+    char *pool_alloc; //!< allocation to free; NULL for caller memory
+};
+
+static really_inline
+struct hs_stream *poolSlot(const struct hs_stream_pool *pool, u32 idx) {
+    assert(idx < pool->capacity);
+    return (struct hs_stream *)(pool->slots + (size_t)idx * pool->slot_size);
+}
+
+static really_inline
+int validStreamPool(const struct hs_stream_pool *pool) {
+    return pool && ISALIGNED_N(pool, 8) && pool->magic == STREAM_POOL_MAGIC;
+}
+
+/** \brief Returns the slot index of a pooled stream, or capacity if the
+ * stream is not an open stream in this pool. */
+static really_inline
+u32 poolSlotIndex(const struct hs_stream_pool *pool,
+                  const struct hs_stream *s) {
+    const char *p = (const char *)s;
+    if (p < pool->slots) {
+        return pool->capacity;
+    }
+    size_t delta = (size_t)(p - pool->slots);
+    size_t idx = delta / pool->slot_size;
+    if (idx >= pool->capacity || delta % pool->slot_size || !s->rose) {
+        return pool->capacity;
+    }
+    return (u32)idx;
+}
+
+/** \brief Takes a slot from the free list; NULL if the pool is full. */
+static really_inline
+struct hs_stream *poolTakeSlot(struct hs_stream_pool *pool) {
+    if (unlikely(pool->free_head == pool->capacity)) {
+        return NULL;
+    }
+    struct hs_stream *s = poolSlot(pool, pool->free_head);
+    assert(!s->rose);
+    pool->free_head = (u32)s->offset;
+    pool->live++;
+    return s;
+}
+
+/** \brief Returns slot \a idx to the head of the free list. */
+static really_inline
+void poolReleaseSlot(struct hs_stream_pool *pool, u32 idx) {
+    struct hs_stream *s = poolSlot(pool, idx);
+    assert(s->rose);
+    assert(pool->live);
+    s->rose = NULL;
+    s->offset = pool->free_head;
+    pool->free_head = idx;
+    pool->live--;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -33,6 +33,7 @@
 #include "util/flat_containers.h"
 
 #include <utility>
+#include <vector>
 
 namespace ue2 {
 
@@ -44,6 +45,9 @@ struct AccelScheme {
     CharReach double_cr;
     u32 offset = MAX_ACCEL_DEPTH + 1;
     u32 double_offset = 0;
+    std::vector<CharReach> multi_classes; // empty if no multi-byte scheme
+    CharReach multi_cr;
+    u32 multi_offset = 0;
 };
 
 }
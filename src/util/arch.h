@@ -57,6 +57,10 @@
 #define HAVE_AVX512
 #endif
 
+#if defined(__AVX512VBMI__)
+#define HAVE_AVX512VBMI
+#endif
+
 /*
  * ICC and MSVC don't break out POPCNT or BMI/2 as separate pre-def macros
  */
@@ -314,10 +314,23 @@ m512 pshufb_m512(m512 a, m512 b) {
     return _mm512_shuffle_epi8(a, b);
 }
 
+static really_inline
+u32 movd512(const m512 in) {
+    return _mm_cvtsi128_si32(_mm512_castsi512_si128(in));
+}
+
 static really_inline
 m512 maskz_pshufb_m512(__mmask64 k, m512 a, m512 b) {
     return _mm512_maskz_shuffle_epi8(k, a, b);
 }
+
+#if defined(HAVE_AVX512VBMI)
+/** \brief Full 64-byte table lookup: result byte i is a[b[i] & 63]. */
+static really_inline
+m512 vpermb512(m512 a, m512 b) {
+    return _mm512_permutexvar_epi8(b, a);
+}
+#endif
 #endif
 
 static really_inline
@@ -33,6 +33,13 @@
 
 enum class ScanMode { BLOCK, STREAMING, VECTORED };
 
+/** Where the Hyperscan database is placed in memory for scanning. */
+enum class DbPlacement {
+    HEAP,     //!< the database as allocated by the library
+    HUGEPAGE, //!< a single copy in huge pages, where available
+    NODE      //!< a copy per NUMA node, in huge pages where available
+};
+
 extern bool echo_matches;
 extern bool saveDatabases;
 extern bool loadDatabases;
@@ -41,7 +48,9 @@ extern unsigned int somPrecisionMode;
 extern bool forceEditDistance;
 extern unsigned editDistance;
 extern bool printCompressSize;
+extern bool compressDense;
 extern bool useLiteralApi;
+extern DbPlacement dbPlacement;
 
 /** Structure for the result of a single complete scan. */
 struct ResultEntry {
@@ -33,3 +33,17 @@ EngineContext::~EngineContext() { }
 EngineStream::~EngineStream() { }
 
 Engine::~Engine() { }
+
+std::unique_ptr<EngineContext> Engine::makeNodeContext(int) const {
+    return makeContext();
+}
+
+bool Engine::writeRuntimeStats(const std::vector<const EngineContext *> &,
+                               const std::string &) const {
+    return false;
+}
+
+bool Engine::printRuntimeProfile(const std::vector<const EngineContext *> &,
+                                 const ExpressionMap &, size_t) const {
+    return false;
+}
@@ -30,6 +30,7 @@
 #define ENGINE_H
 
 #include "common.h"
+#include "expressions.h"
 #include "sqldb.h"
 
 #include <memory>
@@ -59,6 +60,10 @@ public:
     // allocate an EngineContext
     virtual std::unique_ptr<EngineContext> makeContext() const = 0;
 
+    // allocate an EngineContext for a thread running on the given NUMA node;
+    // the caller must be running on that node
+    virtual std::unique_ptr<EngineContext> makeNodeContext(int node) const;
+
     // non-streaming scan
     virtual void scan(const char *data, unsigned len, unsigned blockId,
                       ResultEntry &results, EngineContext &ectx) const = 0;
@@ -89,6 +94,18 @@ public:
     virtual void printStats() const = 0;
 
     virtual void sqlStats(SqlDB &db) const = 0;
+
+    // write runtime profiling counters gathered by the given contexts to a
+    // file; returns false if the engine does not support this
+    virtual bool
+    writeRuntimeStats(const std::vector<const EngineContext *> &ctxs,
+                      const std::string &filename) const;
+
+    // print the most costly patterns and runtime counters, as measured by
+    // runtime profiling; returns false if the engine does not support this
+    virtual bool
+    printRuntimeProfile(const std::vector<const EngineContext *> &ctxs,
+                        const ExpressionMap &exprMap, size_t top) const;
 };
 
 #endif // ENGINE_H
@@ -44,10 +44,13 @@
 #include "util/database_util.h"
 #include "util/make_unique.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <fstream>
 #include <functional>
 #include <iomanip>
+#include <map>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -57,7 +60,7 @@
 
 using namespace std;
 
-EngineHSContext::EngineHSContext(const hs_database_t *db) {
+EngineHSContext::EngineHSContext(const hs_database_t *db_in) : db(db_in) {
     hs_alloc_scratch(db, &scratch);
     assert(scratch);
 }
@@ -122,6 +125,9 @@ EngineHyperscan::EngineHyperscan(hs_database_t *db_in, CompileHSStats cs)
 }
 
 EngineHyperscan::~EngineHyperscan() {
+    for (const auto &m : replicas) {
+        release_local(m.second.first, m.second.second);
+    }
     release_huge(db);
 }
 
@@ -129,6 +135,27 @@ unique_ptr<EngineContext> EngineHyperscan::makeContext() const {
     return ue2::make_unique<EngineHSContext>(db);
 }
 
+unique_ptr<EngineContext> EngineHyperscan::makeNodeContext(int node) const {
+    if (dbPlacement != DbPlacement::NODE) {
+        return makeContext();
+    }
+
+    // The first context made for a node makes that node's copy of the
+    // database; the caller is running on the node, so the copy is local to it.
+    auto it = replicas.find(node);
+    if (it == replicas.end()) {
+        size_t mapped = 0;
+        hs_database_t *local = clone_local(db, &mapped);
+        if (!local) {
+            printf("Unable to replicate database for node %d, using the "
+                   "shared copy\n", node);
+            return makeContext();
+        }
+        it = replicas.emplace(node, make_pair(local, mapped)).first;
+    }
+    return ue2::make_unique<EngineHSContext>(it->second.first);
+}
+
 void EngineHyperscan::scan(const char *data, unsigned int len, unsigned int id,
                            ResultEntry &result, EngineContext &ectx) const {
     assert(data);
@@ -136,7 +163,7 @@ void EngineHyperscan::scan(const char *data, unsigned int len, unsigned int id,
     EngineHSContext &ctx = static_cast<EngineHSContext &>(ectx);
     ScanHSContext sc(id, result, nullptr);
     auto callback = echo_matches ? onMatchEcho : onMatch;
-    hs_error_t rv = hs_scan(db, data, len, 0, ctx.scratch, callback, &sc);
+    hs_error_t rv = hs_scan(ctx.db, data, len, 0, ctx.scratch, callback, &sc);
 
     if (rv != HS_SUCCESS) {
         printf("Fatal error: hs_scan returned error %d\n", rv);
@@ -155,7 +182,7 @@ void EngineHyperscan::scan_vectored(const char *const *data,
     ScanHSContext sc(streamId, result, nullptr);
     auto callback = echo_matches ? onMatchEcho : onMatch;
     hs_error_t rv =
-        hs_scan_vector(db, data, len, count, 0, ctx.scratch, callback, &sc);
+        hs_scan_vector(ctx.db, data, len, count, 0, ctx.scratch, callback, &sc);
 
     if (rv != HS_SUCCESS) {
         printf("Fatal error: hs_scan_vector returned error %d\n", rv);
@@ -169,7 +196,7 @@ unique_ptr<EngineStream> EngineHyperscan::streamOpen(EngineContext &ectx,
     auto stream = ue2::make_unique<EngineHSStream>();
     stream->ctx = &ctx;
 
-    hs_open_stream(db, 0, &stream->id);
+    hs_open_stream(ctx.db, 0, &stream->id);
     if (!stream->id) {
         // an error occurred, propagate to caller
         return nullptr;
@@ -217,11 +244,12 @@ void EngineHyperscan::streamCompressExpand(EngineStream &stream,
                                            vector<char> &temp) const {
     size_t used = 0;
     auto &s = static_cast<EngineHSStream &>(stream);
-    hs_error_t err = hs_compress_stream(s.id, temp.data(), temp.size(),
-                                        &used);
+    auto compress = compressDense ? hs_compress_stream_dense
+                                  : hs_compress_stream;
+    hs_error_t err = compress(s.id, temp.data(), temp.size(), &used);
     if (err == HS_INSUFFICIENT_SPACE) {
         temp.resize(used);
-        err = hs_compress_stream(s.id, temp.data(), temp.size(), &used);
+        err = compress(s.id, temp.data(), temp.size(), &used);
     }
 
     if (err != HS_SUCCESS) {
@@ -294,6 +322,186 @@ void EngineHyperscan::sqlStats(SqlDB &sqldb) const {
                      compile_stats.compileSecs, compile_stats.peakMemorySize);
 }
 
+static
+const char *statsTypeName(unsigned int type) {
+    switch (type) {
+    case HS_STATS_ENGINE:
+        return "engine";
+    case HS_STATS_QUEUE:
+        return "queue";
+    case HS_STATS_LITERAL:
+        return "literal";
+    case HS_STATS_PROGRAM:
+        return "program";
+    case HS_STATS_REPORT:
+        return "report";
+    default:
+        return "unknown";
+    }
+}
+
+static
+string statsKeyName(unsigned int type, unsigned int key) {
+    if (key == HS_STATS_KEY_LOST) {
+        return "lost";
+    }
+    if (type == HS_STATS_ENGINE) {
+        switch (key) {
+        case HS_STATS_ENGINE_ANCHORED:
+            return "anchored";
+        case HS_STATS_ENGINE_FLOATING:
+            return "floating";
+        case HS_STATS_ENGINE_EOD:
+            return "eod";
+        case HS_STATS_ENGINE_SMALL_BLOCK:
+            return "small_block";
+        case HS_STATS_ENGINE_DELAY_REBUILD:
+            return "delay_rebuild";
+        case HS_STATS_ENGINE_SMALL_WRITE:
+            return "small_write";
+        case HS_STATS_ENGINE_CATCHUP:
+            return "catchup";
+        case HS_STATS_ENGINE_CONFIRM:
+            return "confirm";
+        case HS_STATS_ENGINE_CALLBACK:
+            return "callback";
+        default:
+            break;
+        }
+    }
+    return to_string(key);
+}
+
+namespace /* anonymous */ {
+
+/** Runtime profiling counter totals, keyed by (type, key). */
+struct StatsTotal {
+    unsigned long long count = 0;
+    unsigned long long bytes = 0;
+    unsigned long long cycles = 0;
+};
+
+using StatsTotals = map<pair<unsigned int, unsigned int>, StatsTotal>;
+
+} // namespace
+
+/** Sum the runtime profiling counters over all threads. */
+static
+bool sumRuntimeStats(const vector<const EngineContext *> &ctxs,
+                     StatsTotals &totals) {
+    vector<hs_stats_entry_t> entries;
+    for (const EngineContext *ectx : ctxs) {
+        const auto &ctx = static_cast<const EngineHSContext &>(*ectx);
+        unsigned int count = 0;
+        hs_error_t err = hs_scratch_stats(ctx.scratch, nullptr, 0, &count);
+        if (err == HS_INSUFFICIENT_SPACE) {
+            entries.resize(count);
+            err = hs_scratch_stats(ctx.scratch, entries.data(), count, &count);
+        }
+        if (err != HS_SUCCESS) {
+            printf("Unable to read runtime stats (is the library built with "
+                   "RUNTIME_PROFILING?)\n");
+            return false;
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            const hs_stats_entry_t &e = entries[i];
+            auto &t = totals[make_pair(e.type, e.key)];
+            t.count += e.count;
+            t.bytes += e.bytes;
+            t.cycles += e.cycles;
+        }
+    }
+    return true;
+}
+
+bool EngineHyperscan::writeRuntimeStats(
+        const vector<const EngineContext *> &ctxs,
+        const string &filename) const {
+    StatsTotals totals;
+    if (!sumRuntimeStats(ctxs, totals)) {
+        return false;
+    }
+
+    ofstream os(filename);
+    if (!os) {
+        printf("Unable to open stats file '%s'\n", filename.c_str());
+        return false;
+    }
+
+    os << "# type key count bytes cycles" << endl;
+    for (const auto &m : totals) {
+        unsigned int type = m.first.first;
+        unsigned int key = m.first.second;
+        os << statsTypeName(type) << " " << statsKeyName(type, key) << " "
+           << m.second.count << " " << m.second.bytes << " "
+           << m.second.cycles << endl;
+    }
+    return true;
+}
+
+bool EngineHyperscan::printRuntimeProfile(
+        const vector<const EngineContext *> &ctxs,
+        const ExpressionMap &exprMap, size_t top) const {
+    StatsTotals totals;
+    if (!sumRuntimeStats(ctxs, totals)) {
+        return false;
+    }
+
+    // Report counters share their cycles with the other counters, so they
+    // are left out of the total.
+    unsigned long long totalCycles = 0;
+    vector<StatsTotals::const_iterator> patterns, components;
+    for (auto it = totals.begin(); it != totals.end(); ++it) {
+        if (it->first.second == HS_STATS_KEY_LOST) {
+            continue;
+        }
+        if (it->first.first == HS_STATS_REPORT) {
+            patterns.push_back(it);
+        } else {
+            totalCycles += it->second.cycles;
+            components.push_back(it);
+        }
+    }
+
+    auto byCycles = [](StatsTotals::const_iterator a,
+                       StatsTotals::const_iterator b) {
+        return a->second.cycles > b->second.cycles;
+    };
+    stable_sort(patterns.begin(), patterns.end(), byCycles);
+    stable_sort(components.begin(), components.end(), byCycles);
+
+    auto share = [&](unsigned long long cycles) {
+        return totalCycles ? 100.0 * cycles / totalCycles : 0.0;
+    };
+
+    printf("Most costly patterns:\n");
+    printf("%6s %10s %12s %16s %7s  %s\n", "Rank", "ID", "Matches", "Cycles",
+           "Share", "Expression");
+    for (size_t i = 0; i < patterns.size() && i < top; i++) {
+        unsigned int id = patterns[i]->first.second;
+        const StatsTotal &t = patterns[i]->second;
+        auto expr = exprMap.find(id);
+        printf("%6zu %10u %12llu %16llu %6.2f%%  %s\n", i + 1, id, t.count,
+               t.cycles, share(t.cycles),
+               expr == exprMap.end() ? "" : expr->second.c_str());
+    }
+    printf("\n");
+
+    printf("Most costly runtime components:\n");
+    printf("%6s %-8s %-14s %12s %16s %7s\n", "Rank", "Type", "Key", "Count",
+           "Cycles", "Share");
+    for (size_t i = 0; i < components.size() && i < top; i++) {
+        unsigned int type = components[i]->first.first;
+        unsigned int key = components[i]->first.second;
+        const StatsTotal &t = components[i]->second;
+        printf("%6zu %-8s %-14s %12llu %16llu %6.2f%%\n", i + 1,
+               statsTypeName(type), statsKeyName(type, key).c_str(), t.count,
+               t.cycles, share(t.cycles));
+    }
+    printf("\n");
+    return true;
+}
+
 
 static
 unsigned makeModeFlags(ScanMode scan_mode) {
@@ -472,9 +680,11 @@ buildEngineHyperscan(const ExpressionMap &expressions, ScanMode scan_mode,
     }
 
     // copy the db into huge pages (where available) to reduce TLB pressure
-    db = get_huge(db);
-    if (!db) {
-        return nullptr;
+    if (dbPlacement != DbPlacement::HEAP) {
+        db = get_huge(db);
+        if (!db) {
+            return nullptr;
+        }
     }
 
     err = hs_database_size(db, &compiledSize);
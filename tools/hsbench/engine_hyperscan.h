@@ -33,8 +33,10 @@
 #include "engine.h"
 #include "hs_runtime.h"
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 /** Infomation about the database compile */
@@ -55,9 +57,10 @@ struct CompileHSStats {
 /** Engine context which is allocated on a per-thread basis. */
 class EngineHSContext : public EngineContext {
 public:
-    explicit EngineHSContext(const hs_database_t *db);
+    explicit EngineHSContext(const hs_database_t *db_in);
     ~EngineHSContext();
 
+    const hs_database_t *db; //!< database copy used by this context
     hs_scratch_t *scratch = nullptr;
 };
 
@@ -77,6 +80,8 @@ public:
 
     std::unique_ptr<EngineContext> makeContext() const;
 
+    std::unique_ptr<EngineContext> makeNodeContext(int node) const;
+
     void scan(const char *data, unsigned int len, unsigned int id,
               ResultEntry &result, EngineContext &ectx) const;
 
@@ -100,8 +105,17 @@ public:
 
     void sqlStats(SqlDB &db) const;
 
+    bool writeRuntimeStats(const std::vector<const EngineContext *> &ctxs,
+                           const std::string &filename) const;
+
+    bool printRuntimeProfile(const std::vector<const EngineContext *> &ctxs,
+                             const ExpressionMap &exprMap, size_t top) const;
+
 private:
     hs_database_t *db;
+
+    /** Per-NUMA node database copies, with the size of their mappings. */
+    mutable std::map<int, std::pair<hs_database_t *, size_t>> replicas;
     CompileHSStats compile_stats;
 };
 
@@ -35,6 +35,7 @@
 #include "huge.h"
 
 #ifndef _WIN32
+#include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <errno.h>
@@ -42,12 +43,16 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #if defined(HAVE_SHMGET)
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #endif
+#if defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif
 
-UNUSED static int hsdb_shmid;
+UNUSED static int hsdb_shmid = -1;
 
 using namespace std;
 
@@ -57,8 +62,6 @@ hs_database_t *get_huge(hs_database_t *db) {
 #if defined(HAVE_SHMGET) && defined(SHM_HUGETLB)
     /* move the database to huge pages where possible, but fail politely */
     hs_error_t err;
-    size_t len;
-    char *bytes;
 
     long hpage_size = gethugepagesize();
     if (hpage_size < 0) {
@@ -67,15 +70,8 @@ hs_database_t *get_huge(hs_database_t *db) {
         return db;
     }
 
-    err = hs_serialize_database(db, &bytes, &len);
-    if (err != HS_SUCCESS) {
-        printf("Failed to serialize database for copy: %d\n", err);
-        // this is weird - don't fail gracefully this time
-        return nullptr;
-    }
-
     size_t size;
-    err = hs_serialized_database_size(bytes, len, &size);
+    err = hs_database_size(db, &size);
     if (err != HS_SUCCESS) {
         printf("Failed to get database size: %d\n", err);
         // this is weird - don't fail gracefully this time
@@ -99,19 +95,17 @@ hs_database_t *get_huge(hs_database_t *db) {
     // Mark this segment to be destroyed after this process detaches.
     shmctl(hsdb_shmid, IPC_RMID, nullptr);
 
-    err = hs_deserialize_database_at(bytes, len, (hs_database_t *)shmaddr);
+    err = hs_clone_database_at(db, (hs_database_t *)shmaddr);
     if (err != HS_SUCCESS) {
-        printf("Failed to deserialize database into shm: %d\n", err);
+        printf("Failed to copy database into shm: %d\n", err);
         shmdt((const void *)shmaddr);
         goto fini;
     }
 
-    free(bytes);
     hs_free_database(db);
     return (hs_database_t *)shmaddr;
 
 fini:
-    free(bytes);
     hsdb_shmid = -1;
     return db;
 #else
@@ -134,6 +128,88 @@ void release_huge(hs_database_t *db) {
 #endif
 }
 
+hs_database_t *clone_local(const hs_database_t *db, size_t *mapped) {
+    assert(mapped);
+#if defined(HAVE_MMAP)
+    size_t size;
+    hs_error_t err = hs_database_size(db, &size);
+    if (err != HS_SUCCESS) {
+        printf("Failed to get database size: %d\n", err);
+        return nullptr;
+    }
+
+    void *addr = MAP_FAILED;
+    size_t len = 0;
+#if defined(MAP_HUGETLB)
+    long hpage_size = gethugepagesize();
+    if (hpage_size > 0) {
+        len = ROUNDUP_N(size, hpage_size);
+        addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (addr == MAP_FAILED) {
+        // No huge pages available to us, which is OK.
+        len = size;
+        addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            perror("Database mapping failure");
+            return nullptr;
+        }
+    }
+
+    // The copy is the first touch of these pages, so they will be allocated on
+    // the NUMA node of the calling thread.
+    err = hs_clone_database_at(db, (hs_database_t *)addr);
+    if (err != HS_SUCCESS) {
+        printf("Failed to copy database: %d\n", err);
+        munmap(addr, len);
+        return nullptr;
+    }
+
+    *mapped = len;
+    return (hs_database_t *)addr;
+#else
+    *mapped = 0;
+    return nullptr;
+#endif
+}
+
+void release_local(hs_database_t *db, UNUSED size_t mapped) {
+#if defined(HAVE_MMAP)
+    if (munmap((void *)db, mapped) != 0) {
+        perror("Unmap failure");
+    }
+#endif
+}
+
+int cpu_node(int cpu) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return 0;
+    }
+
+    // The CPU's directory contains a "nodeN" link for the node it belongs to.
+    int node = 0;
+    while (struct dirent *ent = readdir(dir)) {
+        char *end;
+        if (strncmp(ent->d_name, "node", 4) != 0) {
+            continue;
+        }
+        long val = strtol(ent->d_name + 4, &end, 10);
+        if (end != ent->d_name + 4 && *end == '\0') {
+            node = (int)val;
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
 #define BUF_SIZE 4096
 static long read_meminfo(const char *tag) {
     int fd;
@@ -198,4 +274,13 @@ hs_database_t *get_huge(hs_database_t *db) { return db; }
 
 void release_huge(hs_database_t *db) { hs_free_database(db); }
 
+hs_database_t *clone_local(const hs_database_t *, size_t *mapped) {
+    *mapped = 0;
+    return nullptr;
+}
+
+void release_local(hs_database_t *, size_t) {}
+
+int cpu_node(int) { return 0; }
+
 #endif
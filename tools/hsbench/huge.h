@@ -34,4 +34,15 @@
 hs_database_t *get_huge(hs_database_t *db);
 void release_huge(hs_database_t *db);
 
+/**
+ * Copy the database into fresh memory owned by the calling thread's NUMA node,
+ * using huge pages where possible. The size of the mapping is returned in
+ * \a mapped. Returns nullptr on failure.
+ */
+hs_database_t *clone_local(const hs_database_t *db, size_t *mapped);
+void release_local(hs_database_t *db, size_t mapped);
+
+/** Returns the NUMA node of the given CPU, or zero if it cannot be found. */
+int cpu_node(int cpu);
+
 #endif /* HUGE_H */
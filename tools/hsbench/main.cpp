@@ -36,6 +36,7 @@
 #include "engine_pcre.h"
 #endif
 #include "expressions.h"
+#include "huge.h"
 #include "sqldb.h"
 #include "thread_barrier.h"
 #include "timer.h"
@@ -51,6 +52,7 @@
 #include <clocale>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <numeric>
@@ -87,7 +89,9 @@ unsigned int somPrecisionMode = HS_MODE_SOM_HORIZON_LARGE;
 bool forceEditDistance = false;
 unsigned editDistance = 0;
 bool printCompressSize = false;
+bool compressDense = false;
 bool useLiteralApi = false;
+DbPlacement dbPlacement = DbPlacement::HUGEPAGE;
 
 // Globals local to this file.
 static bool compressStream = false;
@@ -102,6 +106,8 @@ unsigned repeats = 20;
 string exprPath("");
 string corpusFile("");
 string sqloutFile("");
+string statsFile("");
+unsigned profileTop = 0; // number of costly patterns to show, 0 for none
 string sigName(""); // info only
 vector<unsigned int> threadCores;
 Timer totalTimer;
@@ -114,10 +120,11 @@ typedef void (*thread_func_t)(void *context);
 class ThreadContext : boost::noncopyable {
 public:
     ThreadContext(unsigned num_in, const Engine &db_in,
+                  unique_ptr<EngineContext> enginectx_in,
                   thread_barrier &tb_in, thread_func_t function_in,
                   vector<DataBlock> corpus_data_in)
         : num(num_in), results(repeats), engine(db_in),
-          enginectx(db_in.makeContext()), corpus_data(move(corpus_data_in)),
+          enginectx(move(enginectx_in)), corpus_data(move(corpus_data_in)),
           tb(tb_in), function(function_in) {}
 
     // Start the thread.
@@ -219,7 +226,31 @@ void usage(const char *error) {
     printf("  --per-scan      Display per-scan Mbit/sec results.\n");
     printf("  --echo-matches  Display all matches that occur during scan.\n");
     printf("  --sql-out FILE  Output sqlite db.\n");
+    printf("  --stats-out FILE\n");
+    printf("                  Write runtime profiling counters to FILE (needs a"
+           " library\n"
+           "                  built with RUNTIME_PROFILING).\n");
+    printf("  --profile NUM   Show the NUM most costly patterns and runtime"
+           " counters\n"
+           "                  (needs a library built with"
+           " RUNTIME_PROFILING).\n");
     printf("  --literal-on    Use Hyperscan pure literal matching.\n");
+    printf("  --compress-stream\n");
+    printf("                  Compress and expand each stream between"
+           " writes.\n");
+    printf("  --compress-dense\n");
+    printf("                  As --compress-stream, using the dense"
+           " compressed form.\n");
+    printf("  --db-placement MODE\n");
+    printf("                  Place the database in memory with MODE: 'heap'"
+           " (as\n"
+           "                  allocated), 'huge' (one copy in huge pages,"
+           " default)"
+#ifdef HAVE_DECL_PTHREAD_SETAFFINITY_NP
+           " or\n"
+           "                  'node' (a copy per NUMA node of the -T CPUs)"
+#endif
+           ".\n");
     printf("  -S NAME         Signature set name (for sqlite db).\n");
     printf("\n\n");
 
@@ -248,9 +279,13 @@ void processArgs(int argc, char *argv[], vector<BenchmarkSigs> &sigSets,
     int in_sigfile = 0;
     int do_per_scan = 0;
     int do_compress = 0;
+    int do_compress_dense = 0;
     int do_compress_size = 0;
     int do_echo_matches = 0;
     int do_sql_output = 0;
+    int do_stats_output = 0;
+    int do_profile = 0;
+    int do_placement = 0;
     int option_index = 0;
     int literalFlag = 0;
     vector<string> sigFiles;
@@ -259,8 +294,12 @@ void processArgs(int argc, char *argv[], vector<BenchmarkSigs> &sigSets,
         {"per-scan", no_argument, &do_per_scan, 1},
         {"echo-matches", no_argument, &do_echo_matches, 1},
         {"compress-stream", no_argument, &do_compress, 1},
+        {"compress-dense", no_argument, &do_compress_dense, 1},
         {"sql-out", required_argument, &do_sql_output, 1},
+        {"stats-out", required_argument, &do_stats_output, 1},
+        {"profile", required_argument, &do_profile, 1},
         {"literal-on", no_argument, &literalFlag, 1},
+        {"db-placement", required_argument, &do_placement, 1},
         {nullptr, 0, nullptr, 0}
     };
 
@@ -382,6 +421,33 @@ void processArgs(int argc, char *argv[], vector<BenchmarkSigs> &sigSets,
                 sqloutFile.assign(optarg);
                 do_sql_output = 0;
             }
+            if (do_stats_output) {
+                statsFile.assign(optarg);
+                do_stats_output = 0;
+            }
+            if (do_profile) {
+                if (!fromString(optarg, profileTop) || profileTop == 0) {
+                    usage("Couldn't parse argument to --profile flag, should"
+                          " be a positive integer.");
+                    exit(1);
+                }
+                do_profile = 0;
+            }
+            if (do_placement) {
+                if (!strcmp(optarg, "heap")) {
+                    dbPlacement = DbPlacement::HEAP;
+                } else if (!strcmp(optarg, "huge")) {
+                    dbPlacement = DbPlacement::HUGEPAGE;
+#ifdef HAVE_DECL_PTHREAD_SETAFFINITY_NP
+                } else if (!strcmp(optarg, "node")) {
+                    dbPlacement = DbPlacement::NODE;
+#endif
+                } else {
+                    usage("Unrecognised argument to --db-placement flag.");
+                    exit(1);
+                }
+                do_placement = 0;
+            }
             break;
         case 1:
             if (in_sigfile) {
@@ -409,6 +475,10 @@ void processArgs(int argc, char *argv[], vector<BenchmarkSigs> &sigSets,
     if (do_compress) {
         compressStream = true;
     }
+    if (do_compress_dense) {
+        compressStream = true;
+        compressDense = true;
+    }
     if (do_compress_size) {
         printCompressSize = true;
     }
@@ -455,12 +525,18 @@ void processArgs(int argc, char *argv[], vector<BenchmarkSigs> &sigSets,
             exit(1);
         }
 
-        if (forceEditDistance || loadDatabases || saveDatabases) {
+        if (forceEditDistance || loadDatabases || saveDatabases ||
+            !statsFile.empty() || profileTop) {
             usage("No extended options are supported in Chimera or PCRE.");
             exit(1);
         }
     }
 
+    if (dbPlacement == DbPlacement::NODE && threadCores.empty()) {
+        usage("Per-node database placement needs CPUs given with -T.");
+        exit(1);
+    }
+
     // Read in any -s signature sets.
     for (const auto &file : sigFiles) {
         SignatureSet sigs;
@@ -907,6 +983,46 @@ void sqlResults(const vector<unique_ptr<ThreadContext>> &threads,
     }
 }
 
+/**
+ * Construct the engine context for a thread that will run on the given CPU
+ * (or -1 if it is not bound to one).
+ *
+ * With per-node database placement, we run on the thread's CPU while the
+ * context is made, so that the memory it first touches (database copy and
+ * scratch) is allocated on that CPU's NUMA node.
+ */
+static
+unique_ptr<EngineContext> makeEngineContext(const Engine &db,
+                                            UNUSED int cpu) {
+#ifdef HAVE_DECL_PTHREAD_SETAFFINITY_NP
+    if (dbPlacement == DbPlacement::NODE && cpu >= 0) {
+#if defined(__FreeBSD__)
+        cpuset_t saved, cpuset;
+#else
+        cpu_set_t saved, cpuset;
+#endif
+        pthread_t self = pthread_self();
+        if (pthread_getaffinity_np(self, sizeof(saved), &saved) != 0) {
+            printf("Unable to query processor affinity\n");
+            exit(1);
+        }
+
+        CPU_ZERO(&cpuset);
+        assert(cpu < CPU_SETSIZE);
+        (void)CPU_SET(cpu, &cpuset);
+        if (pthread_setaffinity_np(self, sizeof(cpuset), &cpuset) != 0) {
+            printf("Unable to run on CPU %d\n", cpu);
+            exit(1);
+        }
+
+        auto ctx = db.makeNodeContext(cpu_node(cpu));
+        pthread_setaffinity_np(self, sizeof(saved), &saved);
+        return ctx;
+    }
+#endif
+    return db.makeContext();
+}
+
 /**
  * Construct a thread context for this scanning mode.
  *
@@ -917,8 +1033,10 @@ void sqlResults(const vector<unique_ptr<ThreadContext>> &threads,
 static
 unique_ptr<ThreadContext> makeThreadContext(const Engine &db,
                                             const vector<DataBlock> &blocks,
-                                            unsigned id,
+                                            unsigned id, int cpu,
                                             thread_barrier &sync_barrier) {
+    unique_ptr<EngineContext> enginectx = makeEngineContext(db, cpu);
+
     thread_func_t fn = nullptr;
     switch (scan_mode) {
     case ScanMode::STREAMING:
@@ -937,12 +1055,13 @@ unique_ptr<ThreadContext> makeThreadContext(const Engine &db,
     }
     assert(fn);
 
-    return ue2::make_unique<ThreadContext>(id, db, sync_barrier, fn, blocks);
+    return ue2::make_unique<ThreadContext>(id, db, move(enginectx),
+                                           sync_barrier, fn, blocks);
 }
 
 /** Run the given benchmark. */
 static
-void runBenchmark(const Engine &db,
+void runBenchmark(const Engine &db, const ExpressionMap &exprMap,
                   const vector<DataBlock> &corpus_blocks) {
     size_t numThreads;
     bool useAffinity = false;
@@ -965,8 +1084,8 @@ void runBenchmark(const Engine &db,
     vector<unique_ptr<ThreadContext>> threads;
 
     for (unsigned i = 0; i < numThreads; i++) {
-        auto t = makeThreadContext(db, corpus_blocks, i, sync_barrier);
         int core = useAffinity ? (int)threadCores[i] : -1;
+        auto t = makeThreadContext(db, corpus_blocks, i, core, sync_barrier);
         if (!t->start(core)) {
             printf("Unable to start processing thread %u\n", i);
             exit(1);
@@ -979,6 +1098,19 @@ void runBenchmark(const Engine &db,
         t->join();
     }
 
+    if (!statsFile.empty() || profileTop) {
+        vector<const EngineContext *> ctxs;
+        for (const auto &t : threads) {
+            ctxs.push_back(t->enginectx.get());
+        }
+        if (!statsFile.empty() && !db.writeRuntimeStats(ctxs, statsFile)) {
+            exit(1);
+        }
+        if (profileTop && !db.printRuntimeProfile(ctxs, exprMap, profileTop)) {
+            exit(1);
+        }
+    }
+
     if (sqloutFile.empty()) {
         // Display global results.
         displayResults(threads, corpus_blocks);
@@ -1066,7 +1198,7 @@ int HS_CDECL main(int argc, char *argv[]) {
                 engine->sqlStats(out_db);
             }
 
-            runBenchmark(*engine, corpus_blocks);
+            runBenchmark(*engine, exprMap, corpus_blocks);
         }
     } catch (const SqlFailure &f) {
         cerr << f.message << '\n';
@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+
+'''
+Script to generate a large set of random literal signatures, in the form of
+domain names, for benchmarking the pure literal API at dictionary scale.
+'''
+
+from __future__ import print_function
+
+import sys, getopt, os.path, random
+
+ALPHABET = 'abcdefghijklmnopqrstuvwxyz0123456789-'
+TLDS = [ 'com', 'net', 'org', 'io', 'ru', 'cn', 'info', 'biz' ]
+
+def randomDomain(rng):
+    label = ''.join(rng.choice(ALPHABET) for _ in range(rng.randint(3, 16)))
+    return '%s.%s' % (label.strip('-') or 'x', rng.choice(TLDS))
+
+def literalSignatures(count, outFN, seed):
+    '''
+    Write @count distinct domain name literals to a signature file with name
+    @outFN, one per line, with caseless and single-match flags.
+    '''
+
+    rng = random.Random(seed)
+    seen = set()
+
+    with open(outFN, 'w') as out:
+        while len(seen) < count:
+            d = randomDomain(rng)
+            if d in seen:
+                continue
+            seen.add(d)
+            print('%u:/%s/iH' % (len(seen), d), file=out)
+
+def usage(exeName):
+    errmsg = "Usage: %s -n <count> -o <output file> [-s <seed>]"
+    errmsg = errmsg % exeName
+    print(errmsg, file=sys.stderr)
+    sys.exit(-1)
+
+if __name__ == '__main__':
+    args = getopt.getopt(sys.argv[1:], 'n:o:s:')
+    args = dict(args[0])
+
+    requiredKeys = [ '-n', '-o' ]
+    for k in requiredKeys:
+        if k not in args:
+            usage(os.path.basename(sys.argv[0]))
+
+    literalSignatures(int(args['-n']), args['-o'], int(args.get('-s', 0)))
@@ -498,14 +498,16 @@ bool UltimateTruth::blockScan(const BaseDB &bdb, const string &buffer,
 
 static
 vector<char> compressAndCloseStream(hs_stream_t *stream) {
+    auto compress = use_compress_dense ? hs_compress_stream_dense
+                                       : hs_compress_stream;
     size_t needed;
-    hs_error_t err = hs_compress_stream(stream, nullptr, 0, &needed);
+    hs_error_t err = compress(stream, nullptr, 0, &needed);
     if (err != HS_INSUFFICIENT_SPACE) {
         return {};
     }
 
     vector<char> buf(needed);
-    err = hs_compress_stream(stream, buf.data(), needed, &needed);
+    err = compress(stream, buf.data(), needed, &needed);
     if (err != HS_SUCCESS) {
         return {};
     }
@@ -109,6 +109,7 @@ void usage(const char *name, const char *error) {
            "scan call.\n");
     printf("  --compress-reset-expand Compress, reset and expand stream state "
            "after each scan call.\n");
+    printf("  --compress-dense Use the dense compressed form for the above.\n");
     printf("  --mangle-scratch Mangle scratch space after each scan call.\n");
     printf("  --no-nfa        Disable NFA graph execution engine.\n");
     printf("  --no-pcre       Disable PCRE engine.\n");
@@ -175,6 +176,7 @@ void processArgs(int argc, char *argv[], CorpusProperties &corpus_gen_prop,
     int mangleScratch = 0;
     int compressFlag = 0;
     int compressResetFlag = 0;
+    int compressDenseFlag = 0;
     int literalFlag = 0;
     static const struct option longopts[] = {
         {"copy-scratch", 0, &copyScratch, 1},
@@ -188,6 +190,7 @@ void processArgs(int argc, char *argv[], CorpusProperties &corpus_gen_prop,
         {"no-signal-handler", 0, &no_signal_handler, 1},
         {"compress-expand", 0, &compressFlag, 1},
         {"compress-reset-expand", 0, &compressResetFlag, 1},
+        {"compress-dense", 0, &compressDenseFlag, 1},
         {"no-groups", 0, &no_groups, 1},
         {"literal-on", 0, &literalFlag, 1},
         {nullptr, 0, nullptr, 0}};
@@ -582,6 +585,11 @@ void processArgs(int argc, char *argv[], CorpusProperties &corpus_gen_prop,
               "Only use one of --compress-expand and --compress-reset-expand.");
         exit(1);
     }
+    if (compressDenseFlag && !compressFlag && !compressResetFlag) {
+        usage(argv[0], "--compress-dense needs --compress-expand or "
+                       "--compress-reset-expand.");
+        exit(1);
+    }
 
     // set booleans appropriately
     use_NFA = (bool) nfaFlag;
@@ -592,5 +600,6 @@ void processArgs(int argc, char *argv[], CorpusProperties &corpus_gen_prop,
     use_mangle_scratch = (bool) mangleScratch;
     use_compress_expand = (bool)compressFlag;
     use_compress_reset_expand = (bool)compressResetFlag;
+    use_compress_dense = (bool)compressDenseFlag;
     use_literal_api = (bool)literalFlag;
 }
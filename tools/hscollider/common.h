@@ -82,6 +82,7 @@ extern bool use_copy_stream;
 extern bool use_mangle_scratch;
 extern bool use_compress_expand;
 extern bool use_compress_reset_expand;
+extern bool use_compress_dense;
 extern bool use_literal_api;
 extern int abort_on_failure;
 extern int no_signal_handler;
@@ -118,6 +118,7 @@ bool use_copy_stream = false;
 bool use_mangle_scratch = false;
 bool use_compress_expand = false;
 bool use_compress_reset_expand = false;
+bool use_compress_dense = false;
 bool use_literal_api = false;
 int abort_on_failure = 0;
 int no_signal_handler = 0;
@@ -446,6 +447,9 @@ void printMode(void) {
             if (use_compress_reset_expand) {
                 cout << " [compress+reset]";
             }
+            if (use_compress_dense) {
+                cout << " [dense]";
+            }
             break;
         case MODE_VECTORED:
             cout << "Vectored-" << g_streamBlocks;
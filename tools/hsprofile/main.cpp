@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \file
+ * \brief hsprofile: Tool to map runtime profiling counters back to patterns.
+ *
+ * hsprofile reads the runtime counters written by "hsbench --stats-out" (or by
+ * any application using hs_scratch_stats() in the same format) and annotates
+ * them with the information found in the output of hsdump for the same set of
+ * patterns: the engine behind each queue, the literal fragments and reports
+ * of each Rose program, and the expression behind each report.
+ *
+ * The library must be built with the RUNTIME_PROFILING CMake option for
+ * counters to be gathered. For example:
+ *
+ *     $ bin/hsdump -e regex -o dump
+ *     $ bin/hsbench -e regex -c corpus.db --stats-out stats.txt
+ *     $ bin/hsprofile -d dump/dump stats.txt
+ *
+ * Use "hsprofile -h" for complete usage information.
+ */
+
+#include "config.h"
+
+#include "expressions.h"
+#include "hs_runtime.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <getopt.h>
+#else
+#include "win_getopt.h"
+#endif
+
+using namespace std;
+
+namespace /* anonymous */ {
+
+/** A counter read from the stats file. */
+struct Counter {
+    string type;
+    string key;
+    unsigned long long count = 0;
+    unsigned long long bytes = 0;
+    unsigned long long cycles = 0;
+};
+
+/** What we know about a Rose program from the hsdump output. */
+struct ProgramInfo {
+    string kind;
+    vector<string> fragments;
+    set<unsigned> reports;
+};
+
+string dumpDir;
+string statsFile;
+size_t topCount = 20;
+
+} // namespace
+
+static
+void usage(const char *name, const char *error) {
+    printf("Usage: %s [OPTIONS...] STATS_FILE\n\n", name);
+    printf("Options:\n\n");
+    printf("  -h              Display help and exit.\n");
+    printf("  -d DIR          Directory containing hsdump output for the"
+           " database.\n");
+    printf("  -n NUM          Show the top NUM entries of each kind"
+           " (default: 20, 0 for all).\n");
+    printf("\n");
+    printf("Example:\n");
+    printf("$ %s -d dump/dump stats.txt\n", name);
+    printf("\n");
+
+    if (error) {
+        printf("Error: %s\n", error);
+    }
+}
+
+static
+void processArgs(int argc, char *argv[]) {
+    static const char *options = "d:hn:";
+    for (;;) {
+        int c = getopt(argc, argv, options);
+        if (c < 0) {
+            break;
+        }
+        switch (c) {
+        case 'd':
+            dumpDir = optarg;
+            break;
+        case 'h':
+            usage(argv[0], nullptr);
+            exit(0);
+        case 'n': {
+            char *end;
+            topCount = strtoul(optarg, &end, 10);
+            if (*end != '\0') {
+                usage(argv[0], "Argument to '-n' flag must be an integer");
+                exit(1);
+            }
+            break;
+        }
+        default:
+            usage(argv[0], "Unrecognised command line argument.");
+            exit(1);
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0], "Must specify a single stats file.");
+        exit(1);
+    }
+    statsFile = argv[optind];
+
+    if (dumpDir.empty()) {
+        usage(argv[0], "Must specify a dump directory with the -d option.");
+        exit(1);
+    }
+}
+
+static
+vector<Counter> readStats(const string &filename) {
+    ifstream is(filename);
+    if (!is) {
+        printf("ERROR: unable to open %s\n", filename.c_str());
+        exit(1);
+    }
+
+    vector<Counter> counters;
+    string line;
+    while (getline(is, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream ss(line);
+        Counter c;
+        if (!(ss >> c.type >> c.key >> c.count >> c.bytes)) {
+            printf("ERROR: bad line in %s: %s\n", filename.c_str(),
+                   line.c_str());
+            exit(1);
+        }
+        ss >> c.cycles; // absent from older stats files
+        counters.push_back(c);
+    }
+
+    // Most costly first, then busiest.
+    stable_sort(counters.begin(), counters.end(),
+                [](const Counter &a, const Counter &b) {
+                    if (a.cycles != b.cycles) {
+                        return a.cycles > b.cycles;
+                    }
+                    return a.count > b.count;
+                });
+    return counters;
+}
+
+/** Read the Rose programs in one of the hsdump program files. */
+static
+void readPrograms(const string &filename, const string &kind,
+                  map<string, ProgramInfo> &programs) {
+    ifstream is(dumpDir + "/" + filename);
+    if (!is) {
+        return;
+    }
+
+    ProgramInfo *curr = nullptr;
+    string line;
+    while (getline(is, line)) {
+        size_t pos = line.find("Program @ ");
+        if (pos != string::npos) {
+            string offset = line.substr(pos + 10);
+            offset = offset.substr(0, offset.find(':'));
+            curr = &programs[offset];
+            curr->kind = kind;
+            continue;
+        }
+        if (!curr) {
+            continue;
+        }
+        if (line.compare(0, 11, "  fragment ") == 0) {
+            curr->fragments.push_back(line.substr(line.find('"')));
+            continue;
+        }
+        pos = line.find("onmatch ");
+        if (pos != string::npos) {
+            curr->reports.insert(stoul(line.substr(pos + 8)));
+        }
+    }
+}
+
+/** Read the engine description of each queue from rose_components.txt. */
+static
+map<string, string> readQueues() {
+    map<string, string> queues;
+    ifstream is(dumpDir + "/rose_components.txt");
+    string line;
+    getline(is, line); // header
+    while (getline(is, line)) {
+        istringstream ss(line);
+        string qi, offset;
+        if (!(ss >> qi >> offset)) {
+            continue;
+        }
+        string desc;
+        getline(ss, desc);
+        desc.erase(0, desc.find_first_not_of(" \t"));
+        queues[qi] = desc;
+    }
+    return queues;
+}
+
+static
+string describeReports(const set<unsigned> &reports,
+                       const ExpressionMap &exprMap) {
+    ostringstream os;
+    for (unsigned id : reports) {
+        os << (os.tellp() ? ", " : "") << id;
+        auto it = exprMap.find(id);
+        if (it != exprMap.end()) {
+            os << ":" << it->second;
+        }
+    }
+    return os.str();
+}
+
+static
+void printSection(const vector<Counter> &counters, const string &type,
+                  const char *title, const char *countName,
+                  const char *descName, bool withBytes,
+                  const function<string(const string &)> &describe) {
+    if (withBytes) {
+        printf("%-16s %14s %16s %16s  %s\n", title, countName, "bytes",
+               "cycles", descName);
+    } else {
+        printf("%-16s %14s %16s  %s\n", title, countName, "cycles", descName);
+    }
+
+    size_t n = 0;
+    for (const Counter &c : counters) {
+        if (c.type != type) {
+            continue;
+        }
+        if (topCount && n++ == topCount) {
+            printf("  ...\n");
+            break;
+        }
+        if (withBytes) {
+            printf("  %-14s %14llu %16llu %16llu  %s\n", c.key.c_str(),
+                   c.count, c.bytes, c.cycles, describe(c.key).c_str());
+        } else {
+            printf("  %-14s %14llu %16llu  %s\n", c.key.c_str(), c.count,
+                   c.cycles, describe(c.key).c_str());
+        }
+    }
+    printf("\n");
+}
+
+int HS_CDECL main(int argc, char *argv[]) {
+    processArgs(argc, argv);
+
+    vector<Counter> counters = readStats(statsFile);
+
+    ExpressionMap exprMap;
+    if (ifstream(dumpDir + "/patterns.txt")) {
+        loadExpressionsFromFile(dumpDir + "/patterns.txt", exprMap);
+    }
+
+    map<string, ProgramInfo> programs;
+    readPrograms("rose_lit_programs.txt", "literal", programs);
+    readPrograms("rose_anchored_programs.txt", "anchored", programs);
+    readPrograms("rose_delay_programs.txt", "delay", programs);
+    readPrograms("rose_report_programs.txt", "report", programs);
+    readPrograms("rose_eod_programs.txt", "eod", programs);
+    readPrograms("rose_flush_comb_programs.txt", "flush_comb", programs);
+    readPrograms("rose_last_flush_comb_programs.txt", "last_flush_comb",
+                 programs);
+
+    map<string, string> queues = readQueues();
+
+    auto noDescription = [](const string &) { return string(); };
+    auto describeQueue = [&](const string &key) {
+        auto it = queues.find(key);
+        return it == queues.end() ? string() : it->second;
+    };
+    auto describeProgram = [&](const string &key) {
+        auto it = programs.find(key);
+        if (it == programs.end()) {
+            return string();
+        }
+        const ProgramInfo &info = it->second;
+        string desc = info.kind;
+        for (const auto &frag : info.fragments) {
+            desc += " " + frag;
+        }
+        if (!info.reports.empty()) {
+            desc += " -> " + describeReports(info.reports, exprMap);
+        }
+        return desc;
+    };
+    auto describeReport = [&](const string &key) {
+        auto it = exprMap.find(strtoul(key.c_str(), nullptr, 10));
+        return it == exprMap.end() ? string() : it->second;
+    };
+
+    printSection(counters, "report", "Costly pattern", "matches", "pattern",
+                 false, describeReport);
+    printSection(counters, "engine", "Engine", "runs", "", true,
+                 noDescription);
+    printSection(counters, "queue", "Queue", "runs", "engine", true,
+                 describeQueue);
+    printSection(counters, "literal", "Literal program", "matches",
+                 "fragments", false, describeProgram);
+    printSection(counters, "program", "Program", "runs", "kind", false,
+                 describeProgram);
+
+    return 0;
+}
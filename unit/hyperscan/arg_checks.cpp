@@ -475,6 +475,84 @@ TEST(HyperscanArgChecks, ScanStreamNoScratch) {
     hs_free_database(db);
 }
 
+// hs_scan_stream_batch: Call with no stream array, or a null stream in it
+TEST(HyperscanArgChecks, ScanStreamBatchNoStream) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_stream_batch(nullptr, data, len, nullptr, 2, 0, scratch,
+                               dummy_cb);
+    EXPECT_EQ(HS_INVALID, err);
+
+    hs_stream_t *ids[] = {stream, nullptr};
+    err = hs_scan_stream_batch(ids, data, len, nullptr, 2, 0, scratch,
+                               dummy_cb);
+    EXPECT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_close_stream(stream, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_stream_batch: Call with no data
+TEST(HyperscanArgChecks, ScanStreamBatchNoData) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    hs_stream_t *ids[] = {stream};
+    unsigned int len[] = {4};
+    err = hs_scan_stream_batch(ids, nullptr, len, nullptr, 1, 0, scratch,
+                               dummy_cb);
+    EXPECT_EQ(HS_INVALID, err);
+
+    const char *data[] = {nullptr};
+    err = hs_scan_stream_batch(ids, data, len, nullptr, 1, 0, scratch,
+                               dummy_cb);
+    EXPECT_EQ(HS_INVALID, err);
+
+    // no scratch
+    const char *data2[] = {"data"};
+    err = hs_scan_stream_batch(ids, data2, len, nullptr, 1, 0, nullptr,
+                               dummy_cb);
+    EXPECT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_close_stream(stream, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
 // hs_close_stream: Call with no stream
 TEST(HyperscanArgChecks, CloseStreamNoStream) {
     hs_database_t *db = nullptr;
@@ -1337,6 +1415,99 @@ TEST(HyperscanArgChecks, ScanVectorNoHandler) {
     hs_free_database(db);
 }
 
+// hs_scan_batch: Call with no database
+TEST(HyperscanArgChecks, ScanBatchNoDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(nullptr, data, len, nullptr, 2, 0, scratch, dummy_cb);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with a database built for streaming mode
+TEST(HyperscanArgChecks, ScanBatchStreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(db, data, len, nullptr, 2, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with null data array, or a null entry in it
+TEST(HyperscanArgChecks, ScanBatchNoData) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(db, nullptr, len, nullptr, 2, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+
+    const char *data[] = {"data", nullptr};
+    err = hs_scan_batch(db, data, len, nullptr, 2, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_scan_batch(db, data, nullptr, nullptr, 2, 0, scratch, dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with no scratch
+TEST(HyperscanArgChecks, ScanBatchNoScratch) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    hs_error_t err = hs_scan_batch(db, data, len, nullptr, 2, 0, nullptr,
+                                   dummy_cb);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
 // hs_alloc_scratch: Call with no database
 TEST(HyperscanArgChecks, AllocScratchNoDatabase) {
     hs_scratch_t *scratch = nullptr;
@@ -2031,6 +2202,58 @@ TEST(HyperscanArgChecks, ScratchSizeBadScratch) {
     ASSERT_EQ(HS_INVALID, err);
 }
 
+TEST(HyperscanArgChecks, SetMatchBufferNoScratch) {
+    hs_match_t matches[4];
+    hs_error_t err = hs_set_match_buffer(nullptr, matches, 4,
+                                         HS_MATCH_BUFFER_STOP);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, SetMatchBufferBadArgs) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db, &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    hs_match_t matches[4];
+    err = hs_set_match_buffer(scratch, matches, 0, HS_MATCH_BUFFER_STOP);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_set_match_buffer(scratch, matches, 4, 0xdead);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // no buffer attached
+    unsigned int count = 0;
+    err = hs_drain_match_buffer(scratch, &count, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_set_match_buffer(scratch, matches, 4, HS_MATCH_BUFFER_STOP);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_drain_match_buffer(scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, DrainMatchBufferBadScratch) {
+    hs_scratch_t *scratch = (hs_scratch_t *)garbage;
+    unsigned int count;
+    hs_error_t err = hs_drain_match_buffer(scratch, &count, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
 // hs_clone_scratch: bad scratch arg
 TEST(HyperscanArgChecks, CloneBadScratch) {
     // Try cloning the scratch
@@ -2393,6 +2616,41 @@ TEST(HyperscanArgChecks, CompressStreamSmallBuff) {
     ASSERT_EQ(HS_SUCCESS, err);
 }
 
+TEST(HyperscanArgChecks, CompressStreamDenseNoStream) {
+    char buf[100];
+    size_t used;
+    hs_error_t err = hs_compress_stream_dense(nullptr, buf, sizeof(buf),
+                                              &used);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, CompressStreamDenseBadArgs) {
+    hs_database_t *db = buildDB("(foo.*bar){3,}", 0, 0, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+
+    hs_stream_t *stream;
+    hs_error_t err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[100];
+    size_t used = 0;
+    err = hs_compress_stream_dense(stream, buf, sizeof(buf), nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_compress_stream_dense(stream, nullptr, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_compress_stream_dense(stream, buf, 1, &used);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_LT(1, used);
+
+    err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_database(db);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
 TEST(HyperscanArgChecks, ExpandNoDb) {
     hs_database_t *db = buildDB("(foo.*bar){3,}", 0, 0, HS_MODE_STREAM);
     ASSERT_NE(nullptr, db);
@@ -2609,6 +2867,92 @@ TEST(HyperscanArgChecks, ResetAndExpandNoScratch) {
     ASSERT_EQ(HS_SUCCESS, err);
 }
 
+TEST(HyperscanArgChecks, HibernateStreamBadArgs) {
+    hs_database_t *db = buildDB("(foo.*bar){3,}", 0, 0, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+
+    hs_stream_t *stream;
+    hs_error_t err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[100];
+    size_t used = 0;
+    err = hs_hibernate_stream(nullptr, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_hibernate_stream(stream, buf, sizeof(buf), nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_hibernate_stream(stream, nullptr, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_hibernate_stream(stream, buf, 1, &used);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_LT(1, used);
+
+    err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_database(db);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
+TEST(HyperscanArgChecks, WakeStreamBadArgs) {
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("(foo.*bar){3,}", 0, 0,
+                                          HS_MODE_STREAM, &scratch);
+    ASSERT_NE(nullptr, db);
+
+    hs_stream_t *stream1;
+    hs_error_t err = hs_open_stream(db, 0, &stream1);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[2000];
+    size_t used = 0;
+    err = hs_hibernate_stream(stream1, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const char data[] = "foobar";
+    hs_stream_t *stream2 = nullptr;
+    err = hs_wake_stream(db, buf, used, data, sizeof(data), 0, scratch,
+                         nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_wake_stream(nullptr, buf, used, data, sizeof(data), 0, scratch,
+                         nullptr, nullptr, &stream2);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+
+    err = hs_wake_stream(db, nullptr, used, data, sizeof(data), 0, scratch,
+                         nullptr, nullptr, &stream2);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+
+    err = hs_wake_stream(db, buf, used, nullptr, sizeof(data), 0, scratch,
+                         nullptr, nullptr, &stream2);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+
+    err = hs_wake_stream(db, buf, used, data, sizeof(data), 0, nullptr,
+                         nullptr, nullptr, &stream2);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+
+    err = hs_wake_stream(db, buf, used / 2, data, sizeof(data), 0, scratch,
+                         nullptr, nullptr, &stream2);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+
+    err = hs_close_stream(stream1, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_database(db);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
 class BadModeTest : public testing::TestWithParam<unsigned> {};
 
 // hs_compile: Compile a pattern with bogus mode flags set.
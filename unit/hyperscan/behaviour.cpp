@@ -1272,6 +1272,413 @@ TEST(HyperscanTestBehaviour, MultiStream2) {
     hs_free_database(db);
 }
 
+TEST(HyperscanTestBehaviour, Batch1) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo.*bar", HS_FLAG_DOTALL, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // each block is scanned independently, so the foo/bar split over the
+    // first two blocks must not match.
+    const char *data[] = { "foo", "bar", "foobar", "", "xxfooxxbarxx" };
+    unsigned int len[] = { 3, 3, 6, 0, 12 };
+    CallBackContext c[5];
+    void *ctxt[] = { &c[0], &c[1], &c[2], &c[3], &c[4] };
+
+    err = hs_scan_batch(db, data, len, ctxt, 5, 0, scratch, record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    EXPECT_TRUE(c[0].matches.empty());
+    EXPECT_TRUE(c[1].matches.empty());
+    ASSERT_EQ(1U, c[2].matches.size());
+    EXPECT_EQ(MatchRecord(6, 0), c[2].matches[0]);
+    EXPECT_TRUE(c[3].matches.empty());
+    ASSERT_EQ(1U, c[4].matches.size());
+    EXPECT_EQ(MatchRecord(10, 0), c[4].matches[0]);
+
+    // a batch with no blocks is a no-op
+    err = hs_scan_batch(db, nullptr, nullptr, nullptr, 0, 0, scratch,
+                        record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, Batch2) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo", 0, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // halting in one block stops only that block
+    const char *data[] = { "foofoofoo", "foofoofoo", "foofoofoo" };
+    unsigned int len[] = { 9, 9, 9 };
+    CallBackContext c[3];
+    c[1].halt = true;
+    void *ctxt[] = { &c[0], &c[1], &c[2] };
+
+    err = hs_scan_batch(db, data, len, ctxt, 3, 0, scratch, record_cb);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    EXPECT_EQ(3U, c[0].matches.size());
+    EXPECT_EQ(1U, c[1].matches.size());
+    EXPECT_EQ(3U, c[2].matches.size());
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// Fills each block with a cheap deterministic mix of digits and hex letters,
+// so that a pattern over those classes matches in some blocks but not others.
+static
+vector<string> makeBatchBlocks(unsigned int count) {
+    const string alpha = "0123456789abcdefx";
+    vector<string> blocks;
+    unsigned int seed = 1;
+    for (unsigned int i = 0; i < count; i++) {
+        string b;
+        for (unsigned int j = 0; j < 5 + (i * 37) % 300; j++) {
+            seed = seed * 1103515245 + 12345;
+            b.push_back(alpha[(seed >> 16) % alpha.size()]);
+        }
+        blocks.push_back(b);
+    }
+    return blocks;
+}
+
+TEST(HyperscanTestBehaviour, Batch3) {
+    hs_error_t err;
+
+    // a pattern with no useful literals, which is built as a lone DFA
+    hs_database_t *db = buildDB("[0-9][a-f][0-9][a-f]{2}[0-9]", 0, 0,
+                                HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // more blocks than are run together, so that groups are split
+    const unsigned int N = 21;
+    vector<string> blocks = makeBatchBlocks(N);
+    const char *data[N];
+    unsigned int len[N];
+    CallBackContext c[N];
+    void *ctxt[N];
+    for (unsigned int i = 0; i < N; i++) {
+        data[i] = blocks[i].c_str();
+        len[i] = blocks[i].size();
+        ctxt[i] = &c[i];
+    }
+
+    err = hs_scan_batch(db, data, len, ctxt, N, 0, scratch, record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // every block must match exactly as it does on its own
+    size_t total = 0;
+    for (unsigned int i = 0; i < N; i++) {
+        CallBackContext single;
+        err = hs_scan(db, data[i], len[i], 0, scratch, record_cb, &single);
+        ASSERT_EQ(HS_SUCCESS, err);
+        EXPECT_EQ(single.matches, c[i].matches);
+        total += single.matches.size();
+    }
+    EXPECT_LT(0U, total);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, MultiStreamBatch) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo.*bar", 0, 0, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    const unsigned int N = 5;
+    hs_stream_t *ids[N];
+    CallBackContext c[N];
+    void *ctxt[N];
+    for (unsigned int i = 0; i < N; i++) {
+        err = hs_open_stream(db, 0, &ids[i]);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_TRUE(ids[i] != nullptr);
+        ctxt[i] = &c[i];
+    }
+
+    // first write: streams 0, 2 and 4 see the start of a match.
+    const char *data1[] = { "xxfoo", "xxxxx", "foo", "", "foobar" };
+    unsigned int len1[] = { 5, 5, 3, 0, 6 };
+    err = hs_scan_stream_batch(ids, data1, len1, ctxt, N, 0, scratch,
+                               record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(c[0].matches.empty());
+    EXPECT_TRUE(c[1].matches.empty());
+    EXPECT_TRUE(c[2].matches.empty());
+    EXPECT_TRUE(c[3].matches.empty());
+    ASSERT_EQ(1U, c[4].matches.size());
+    EXPECT_EQ(MatchRecord(6, 0), c[4].matches[0]);
+
+    // second write, in a different order; matches span the writes.
+    hs_stream_t *ids2[] = { ids[4], ids[3], ids[2], ids[1], ids[0] };
+    void *ctxt2[] = { ctxt[4], ctxt[3], ctxt[2], ctxt[1], ctxt[0] };
+    const char *data2[] = { "bar", "bar", "xbar", "bar", "bar" };
+    unsigned int len2[] = { 3, 3, 4, 3, 3 };
+    err = hs_scan_stream_batch(ids2, data2, len2, ctxt2, N, 0, scratch,
+                               record_cb);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c[0].matches.size());
+    EXPECT_EQ(MatchRecord(8, 0), c[0].matches[0]);
+    EXPECT_TRUE(c[1].matches.empty());
+    ASSERT_EQ(1U, c[2].matches.size());
+    EXPECT_EQ(MatchRecord(7, 0), c[2].matches[0]);
+    EXPECT_TRUE(c[3].matches.empty());
+    ASSERT_EQ(2U, c[4].matches.size());
+    EXPECT_EQ(MatchRecord(9, 0), c[4].matches[1]);
+
+    for (unsigned int i = 0; i < N; i++) {
+        err = hs_close_stream(ids[i], scratch, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, MultiStreamBatch2) {
+    hs_error_t err;
+
+    // a pattern with no useful literals, which is built as a lone DFA
+    hs_database_t *db = buildDB("[0-9][a-f][0-9][a-f]{2}[0-9]", 0, 0,
+                                HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    // each stream gets two writes, batched, and a reference stream that is
+    // written one call at a time.
+    const unsigned int N = 11;
+    vector<string> blocks = makeBatchBlocks(2 * N);
+    hs_stream_t *ids[N];
+    hs_stream_t *refs[N];
+    CallBackContext c[N];
+    CallBackContext r[N];
+    void *ctxt[N];
+    for (unsigned int i = 0; i < N; i++) {
+        err = hs_open_stream(db, 0, &ids[i]);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_open_stream(db, 0, &refs[i]);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ctxt[i] = &c[i];
+    }
+
+    for (unsigned int w = 0; w < 2; w++) {
+        const char *data[N];
+        unsigned int len[N];
+        for (unsigned int i = 0; i < N; i++) {
+            const string &b = blocks[w * N + i];
+            data[i] = b.c_str();
+            len[i] = b.size();
+            err = hs_scan_stream(refs[i], data[i], len[i], 0, scratch,
+                                 record_cb, &r[i]);
+            ASSERT_EQ(HS_SUCCESS, err);
+        }
+
+        err = hs_scan_stream_batch(ids, data, len, ctxt, N, 0, scratch,
+                                   record_cb);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    size_t total = 0;
+    for (unsigned int i = 0; i < N; i++) {
+        EXPECT_EQ(r[i].matches, c[i].matches);
+        total += r[i].matches.size();
+        err = hs_close_stream(ids[i], scratch, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_close_stream(refs[i], scratch, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    EXPECT_LT(0U, total);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, MatchBuffer1) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo", 0, 0, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    const char data[] = "foofoofoofoo";
+    hs_match_t matches[8];
+    unsigned int count = 0;
+    unsigned long long dropped = 0;
+
+    // room for everything: matches are stored, not passed to the callback
+    err = hs_set_match_buffer(scratch, matches, 8, HS_MATCH_BUFFER_STOP);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan(db, data, strlen(data), 0, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(c.matches.empty());
+
+    err = hs_drain_match_buffer(scratch, &count, &dropped);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(4U, count);
+    EXPECT_EQ(0ULL, dropped);
+    for (unsigned int i = 0; i < count; i++) {
+        EXPECT_EQ(0U, matches[i].id);
+        EXPECT_EQ(3ULL * (i + 1), matches[i].to);
+    }
+
+    // too small, stop policy: scanning halts at the first lost match
+    err = hs_set_match_buffer(scratch, matches, 2, HS_MATCH_BUFFER_STOP);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data, strlen(data), 0, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    err = hs_drain_match_buffer(scratch, &count, &dropped);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(2U, count);
+    EXPECT_EQ(1ULL, dropped);
+
+    // too small, drop policy: scanning continues and losses are counted
+    err = hs_set_match_buffer(scratch, matches, 2, HS_MATCH_BUFFER_DROP);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data, strlen(data), 0, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_drain_match_buffer(scratch, &count, &dropped);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(2U, count);
+    EXPECT_EQ(2ULL, dropped);
+
+    // detach: the callback is used again
+    err = hs_set_match_buffer(scratch, nullptr, 0, 0);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data, strlen(data), 0, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(4U, c.matches.size());
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanTestBehaviour, MatchBufferResume) {
+    hs_error_t err;
+
+    // build a database
+    hs_database_t *db = buildDB("foo", 0, 0, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    // alloc some scratch
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_TRUE(scratch != nullptr);
+
+    string data;
+    for (size_t i = 0; i < 100; i++) {
+        data += "xfoo";
+    }
+
+    // reference matches from the callback
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    CallBackContext c;
+    err = hs_scan_stream(stream, data.c_str(), data.size(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(100U, c.matches.size());
+
+    // the same scan through a small buffer, draining whenever it fills
+    hs_match_t matches[7];
+    err = hs_set_match_buffer(scratch, matches, 7, HS_MATCH_BUFFER_RESUME);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    vector<MatchRecord> got;
+    const char *ptr = data.c_str();
+    unsigned int remaining = data.size();
+    while (remaining) {
+        unsigned int consumed = 0;
+        err = hs_scan_stream_partial(stream, ptr, remaining, remaining, 0,
+                                     scratch, nullptr, nullptr, &consumed);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ptr += consumed;
+        remaining -= consumed;
+
+        unsigned int count = 0;
+        unsigned long long dropped = 0;
+        err = hs_drain_match_buffer(scratch, &count, &dropped);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(0ULL, dropped);
+        ASSERT_TRUE(count != 0);
+        for (unsigned int i = 0; i < count; i++) {
+            got.push_back(MatchRecord(matches[i].to, matches[i].id));
+        }
+    }
+    EXPECT_EQ(c.matches, got);
+
+    err = hs_close_stream(stream, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
 TEST(regression, UE_1005) {
     hs_error_t err;
     vector<pattern> patterns;
@@ -291,4 +291,60 @@ TEST(scratch, damagedScratch) {
     hs_free_database(db);
 }
 
+TEST(scratch, runtimeStats) {
+    hs_database_t *db = buildDB("foobar", 0, 7, HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const char data[] = "xxfoobarxxfoobar";
+    err = hs_scan(db, data, strlen(data), 0, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    unsigned int count = 0;
+    err = hs_scratch_stats(scratch, nullptr, 0, &count);
+
+#ifdef RUNTIME_PROFILING
+    // There must be at least the report counter.
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_LT(0U, count);
+
+    vector<hs_stats_entry_t> entries(count);
+    err = hs_scratch_stats(scratch, entries.data(), count, &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(entries.size(), count);
+
+    bool found = false;
+    for (const auto &e : entries) {
+        EXPECT_NE(0ULL, e.count);
+        if (e.type == HS_STATS_REPORT) {
+            EXPECT_EQ(7U, e.key);
+            EXPECT_EQ(2ULL, e.count);
+            // The literal program that reported it should have been charged.
+            EXPECT_NE(0ULL, e.cycles);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+
+    err = hs_reset_scratch_stats(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_stats(scratch, nullptr, 0, &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, count);
+#else
+    // Counters are not available without the instrumented build.
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_reset_scratch_stats(scratch);
+    ASSERT_EQ(HS_INVALID, err);
+#endif
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_free_database(db);
+}
+
 } // namespace
@@ -237,9 +237,228 @@ TEST_P(SerializeP, DeserializeAtFromAnyAlignment) {
     delete[] mem;
 }
 
+// Check that we can clone a database to any 8-byte aligned location and that
+// the copy serializes identically to the original.
+TEST_P(SerializeP, CloneAtAnyAlignment) {
+    const unsigned mode = get<0>(GetParam());
+    const pattern &pat = get<1>(GetParam());
+    SCOPED_TRACE(mode);
+    SCOPED_TRACE(pat);
+
+    hs_error_t err;
+    hs_database_t *db = buildDB(pat, mode);
+    ASSERT_TRUE(db != nullptr) << "database build failed.";
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    err = hs_serialize_database(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err) << "serialize failed.";
+
+    size_t dblength;
+    err = hs_database_size(db, &dblength);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Backing store is 8-byte aligned; offsets cover every position within a
+    // cache line.
+    const size_t maxalign = 64;
+    vector<unsigned long long> store((dblength + maxalign) / 8 + 1);
+    char *mem = (char *)store.data();
+
+    for (size_t i = 0; i < maxalign; i += 8) {
+        SCOPED_TRACE(i);
+
+        // Scrub target memory.
+        memset(mem, 0xff, dblength + maxalign);
+
+        hs_database_t *clone = (hs_database_t *)(mem + i);
+        err = hs_clone_database_at(db, clone);
+        ASSERT_EQ(HS_SUCCESS, err) << "clone failed.";
+
+        char *clone_bytes = nullptr;
+        size_t clone_length = 0;
+        err = hs_serialize_database(clone, &clone_bytes, &clone_length);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(length, clone_length);
+        ASSERT_EQ(0, memcmp(bytes, clone_bytes, length));
+        free(clone_bytes);
+    }
+
+    // Unaligned targets are rejected.
+    err = hs_clone_database_at(db, (hs_database_t *)(mem + 1));
+    ASSERT_EQ(HS_BAD_ALIGN, err);
+
+    free(bytes);
+    hs_free_database(db);
+}
+
+// Check that a mappable serialized database can be used in place and has the
+// same info as the original.
+TEST_P(SerializeP, DeserializeMapped) {
+    const unsigned mode = get<0>(GetParam());
+    const pattern &pat = get<1>(GetParam());
+    SCOPED_TRACE(mode);
+    SCOPED_TRACE(pat);
+
+    hs_error_t err;
+    hs_database_t *db = buildDB(pat, mode);
+    ASSERT_TRUE(db != nullptr) << "database build failed.";
+
+    char *original_info;
+    err = hs_database_info(db, &original_info);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    err = hs_serialize_database_mappable(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err) << "serialize failed.";
+    ASSERT_NE(nullptr, bytes);
+    hs_free_database(db);
+
+    // Place the bytes at a cache line boundary, as mmap would.
+    vector<char> store(length + 64);
+    char *mem = (char *)(((uintptr_t)store.data() + 63) & ~(uintptr_t)63);
+    memcpy(mem, bytes, length);
+
+    const hs_database_t *mapped = nullptr;
+    err = hs_deserialize_database_mapped(mem, length, 0, &mapped);
+    ASSERT_EQ(HS_SUCCESS, err) << "deserialize failed.";
+    ASSERT_EQ((const hs_database_t *)mem, mapped);
+
+    char *info;
+    err = hs_database_info(mapped, &info);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_STREQ(original_info, info);
+    free(info);
+
+    // Scratch can be allocated for the database in place.
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(mapped, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+
+    // Anything other than a cache line boundary is rejected.
+    memmove(mem + 8, mem, length);
+    err = hs_deserialize_database_mapped(mem + 8, length, 0, &mapped);
+    ASSERT_EQ(HS_BAD_ALIGN, err);
+    ASSERT_EQ(nullptr, mapped);
+
+    free(original_info);
+    free(bytes);
+}
+
 INSTANTIATE_TEST_CASE_P(Serialize, SerializeP,
                         Combine(ValuesIn(validModes), ValuesIn(testPatterns)));
 
+TEST(Serialize, CloneAtBadArgs) {
+    hs_database_t *db = buildDB("hatstand.*teakettle", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_error_t err = hs_clone_database_at(db, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    size_t dblength;
+    err = hs_database_size(db, &dblength);
+    ASSERT_EQ(HS_SUCCESS, err);
+    vector<unsigned long long> mem(dblength / sizeof(unsigned long long) + 1);
+    hs_database_t *dest = (hs_database_t *)mem.data();
+
+    err = hs_clone_database_at(nullptr, dest);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // A database cannot be cloned over itself.
+    err = hs_clone_database_at(db, db);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_free_database(db);
+}
+
+TEST(Serialize, DeserializeMappedScan) {
+    hs_database_t *db = buildDB("hatstand.*teakettle", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    hs_error_t err = hs_serialize_database_mappable(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+
+    vector<char> store(length + 64);
+    char *mem = (char *)(((uintptr_t)store.data() + 63) & ~(uintptr_t)63);
+    memcpy(mem, bytes, length);
+    free(bytes);
+
+    const hs_database_t *mapped = nullptr;
+    err = hs_deserialize_database_mapped(mem, length, 0, &mapped);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(mapped, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    const string data("__hatstand__teakettle__");
+    err = hs_scan(mapped, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(21, 1), c.matches[0]);
+
+    hs_free_scratch(scratch);
+}
+
+TEST(Serialize, DeserializeMappedChecks) {
+    hs_database_t *db = buildDB("hatstand.*teakettle", 0, 1, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    hs_error_t err = hs_serialize_database_mappable(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    vector<char> store(length + 64);
+    char *mem = (char *)(((uintptr_t)store.data() + 63) & ~(uintptr_t)63);
+    memcpy(mem, bytes, length);
+
+    const hs_database_t *mapped = nullptr;
+    err = hs_deserialize_database_mapped(nullptr, length, 0, &mapped);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_deserialize_database_mapped(mem, length, 0, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_deserialize_database_mapped(mem, length, 0x80, &mapped);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_deserialize_database_mapped(mem, length - 1, 0, &mapped);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // Corrupt the last byte of bytecode: only caught by the CRC check.
+    mem[length - 1] ^= 0xff;
+    err = hs_deserialize_database_mapped(mem, length, 0, &mapped);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_deserialize_database_mapped(mem, length, HS_MAPPED_SKIP_CRC,
+                                         &mapped);
+    ASSERT_EQ(HS_SUCCESS, err);
+    mem[length - 1] ^= 0xff;
+
+    // The two serialized forms are not interchangeable.
+    char *plain = nullptr;
+    size_t plain_length = 0;
+    err = hs_serialize_database(db, &plain, &plain_length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_database_t *plain_db = nullptr;
+    err = hs_deserialize_database(mem, length, &plain_db);
+    ASSERT_EQ(HS_INVALID, err);
+
+    vector<char> plain_store(plain_length + 64);
+    char *plain_mem =
+        (char *)(((uintptr_t)plain_store.data() + 63) & ~(uintptr_t)63);
+    memcpy(plain_mem, plain, plain_length);
+    err = hs_deserialize_database_mapped(plain_mem, plain_length, 0, &mapped);
+    ASSERT_EQ(HS_INVALID, err);
+
+    free(plain);
+    free(bytes);
+    hs_free_database(db);
+}
+
 // Attempt to reproduce the scenario in UE-1946.
 TEST(Serialize, CrossCompileSom) {
     hs_platform_info plat;
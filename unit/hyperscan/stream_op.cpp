@@ -26,6 +26,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -573,6 +575,739 @@ TEST(StreamUtil, copy_reset_matches) {
     hs_free_database(db);
 }
 
+TEST(StreamUtil, partial1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+
+    CallBackContext c, c2;
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &stream2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string data;
+    for (size_t i = 0; i < 100; i++) {
+        data += "xxxfooxxxxxbarxx";
+    }
+
+    err = hs_scan_stream(stream, data.c_str(), data.size(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(c.matches.empty());
+
+    // Scan the same data in budgeted pieces; matches must be identical.
+    const char *ptr = data.c_str();
+    unsigned int remaining = data.size();
+    size_t calls = 0;
+    while (remaining) {
+        unsigned int consumed = 0;
+        err = hs_scan_stream_partial(stream2, ptr, remaining, 7, 0, scratch,
+                                     record_cb, (void *)&c2, &consumed);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(min(7U, remaining), consumed);
+        ptr += consumed;
+        remaining -= consumed;
+        calls++;
+    }
+    ASSERT_EQ((data.size() + 6) / 7, calls);
+    ASSERT_EQ(c.matches, c2.matches);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_close_stream(stream2, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, partial_badargs) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    unsigned int consumed = 1;
+    err = hs_scan_stream_partial(stream, data1, sizeof(data1), 0, 0, scratch,
+                                 dummy_cb, nullptr, &consumed);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_EQ(0U, consumed);
+
+    err = hs_scan_stream_partial(stream, data1, sizeof(data1), 4, 0, scratch,
+                                 dummy_cb, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_scan_stream_partial(stream, data1, sizeof(data1), 4, 0, nullptr,
+                                 dummy_cb, nullptr, &consumed);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_scan_stream_partial(nullptr, data1, sizeof(data1), 4, 0, scratch,
+                                 dummy_cb, nullptr, &consumed);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+static
+vector<char> compressDense(const hs_stream_t *stream) {
+    size_t used = 0;
+    hs_error_t err = hs_compress_stream_dense(stream, nullptr, 0, &used);
+    EXPECT_EQ(HS_INSUFFICIENT_SPACE, err);
+    vector<char> buf(used);
+    err = hs_compress_stream_dense(stream, buf.data(), buf.size(), &used);
+    EXPECT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(buf.size(), used);
+    return buf;
+}
+
+TEST(StreamUtil, compress_dense1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    vector<pattern> patterns = {pattern("foo.*bar", 0, 1),
+                                pattern("abc[^x]{10,20}zzz$", 0, 2),
+                                pattern("^xyzzy", 0, 3)};
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string data;
+    for (size_t i = 0; i < 50; i++) {
+        data += "-foo--abc------------zzzbar-";
+    }
+    data += "abc------------zzz";
+
+    // Scan the data in pieces, moving the stream through the dense form
+    // between writes; matches must be the same as for a plain stream.
+    hs_stream_t *plain = nullptr;
+    hs_stream_t *dense = nullptr;
+    err = hs_open_stream(db, 0, &plain);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &dense);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c, c2;
+    for (size_t i = 0; i < data.size(); i += 13) {
+        size_t len = min((size_t)13, data.size() - i);
+        err = hs_scan_stream(plain, data.c_str() + i, len, 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        vector<char> buf = compressDense(dense);
+        err = hs_close_stream(dense, nullptr, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_expand_stream(db, &dense, buf.data(), buf.size());
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        err = hs_scan_stream(dense, data.c_str() + i, len, 0, scratch,
+                             record_cb, (void *)&c2);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    // EOD matches survive a trip through the dense form, too.
+    vector<char> buf = compressDense(dense);
+    err = hs_reset_and_expand_stream(dense, buf.data(), buf.size(), nullptr,
+                                     nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(plain, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(dense, scratch, record_cb, (void *)&c2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_FALSE(c.matches.empty());
+    ASSERT_EQ(c.matches, c2.matches);
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, compress_dense_terminated) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    c.halt = 1;
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+
+    // Only the offset and status of a terminated stream are kept.
+    vector<char> buf = compressDense(stream);
+    ASSERT_GE(16U, buf.size());
+    err = hs_reset_and_expand_stream(stream, buf.data(), buf.size(), nullptr,
+                                     nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+
+    // A trimmed stream expanded into fresh memory can still be copied and
+    // compressed in the standard form.
+    hs_stream_t *expanded = nullptr;
+    err = hs_expand_stream(db, &expanded, buf.data(), buf.size());
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_stream_t *copy = nullptr;
+    err = hs_copy_stream(&copy, expanded);
+    ASSERT_EQ(HS_SUCCESS, err);
+    char std_buf[2000];
+    size_t used = 0;
+    err = hs_compress_stream(copy, std_buf, sizeof(std_buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_reset_and_expand_stream(expanded, std_buf, used, nullptr,
+                                     nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan_stream(expanded, data1, sizeof(data1), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    hs_close_stream(copy, nullptr, nullptr, nullptr);
+    hs_close_stream(expanded, nullptr, nullptr, nullptr);
+
+    // After a reset, the stream matches as normal.
+    err = hs_reset_stream(stream, 0, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    c.halt = 0;
+    c.matches.clear();
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(9, 0), c.matches[0]);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+static
+vector<char> hibernate(const hs_stream_t *stream) {
+    size_t used = 0;
+    hs_error_t err = hs_hibernate_stream(stream, nullptr, 0, &used);
+    EXPECT_EQ(HS_INSUFFICIENT_SPACE, err);
+    vector<char> buf(used);
+    err = hs_hibernate_stream(stream, buf.data(), buf.size(), &used);
+    EXPECT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(buf.size(), used);
+    return buf;
+}
+
+TEST(StreamUtil, hibernate1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    vector<pattern> patterns = {pattern("foo.*bar", 0, 1),
+                                pattern("abc[^x]{10,20}zzz$", 0, 2),
+                                pattern("0123456789abcdefghijklm", 0, 3)};
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string data;
+    for (size_t i = 0; i < 20; i++) {
+        data += "-foo--abc------------zzzbar-0123456789abcdefghijklm--";
+    }
+    data += "abc------------zzz";
+
+    hs_stream_t *plain = nullptr;
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &plain);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    vector<char> buf = hibernate(stream);
+    err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Wake the stream for each write and hibernate it again afterwards.
+    // Writes alternate between short ones, which need the history restored,
+    // and long ones, which are scanned against the history in the buffer.
+    CallBackContext c, c2;
+    size_t n = 0;
+    for (size_t i = 0; i < data.size(); n++) {
+        size_t len = min(n % 2 ? (size_t)7 : (size_t)150, data.size() - i);
+        err = hs_scan_stream(plain, data.c_str() + i, len, 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        stream = nullptr;
+        err = hs_wake_stream(db, buf.data(), buf.size(), data.c_str() + i,
+                             len, 0, scratch, record_cb, (void *)&c2, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_TRUE(stream != nullptr);
+        i += len;
+
+        buf = hibernate(stream);
+        err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    // A hibernated stream expands as any other compressed stream does.
+    err = hs_expand_stream(db, &stream, buf.data(), buf.size());
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(plain, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_FALSE(c.matches.empty());
+    ASSERT_EQ(c.matches, c2.matches);
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, hibernate_wake_compressed) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    err = hs_scan_stream(stream, "xxfoo", 5, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // hs_wake_stream also takes the standard compressed form.
+    char buf[2000];
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    stream = nullptr;
+    err = hs_wake_stream(db, buf, used, "xxbar", 5, 0, scratch, record_cb,
+                         (void *)&c, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(10, 0), c.matches[0]);
+
+    // A terminated stream stays terminated when woken.
+    c.halt = 1;
+    err = hs_scan_stream(stream, "bar", 3, 0, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    vector<char> hib = hibernate(stream);
+    err = hs_close_stream(stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    stream = nullptr;
+    err = hs_wake_stream(db, hib.data(), hib.size(), "bar", 3, 0, scratch,
+                         record_cb, (void *)&c, &stream);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_TRUE(stream != nullptr);
+    ASSERT_EQ(2U, c.matches.size());
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// Streams keep only the history their state needs; lagged prefixes and
+// delayed literals must still see theirs across writes of any size, whether
+// or not the stream is compressed in between.
+TEST(StreamUtil, history_chunked) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    vector<pattern> patterns = {pattern("abc[^x]{0,30}defghijklmn", 0, 1),
+                                pattern("foo[a-z]{4}barbazquux", 0, 2),
+                                pattern("zz[0-9]{3}", 0, 3),
+                                pattern("\\d{8}[a-f]*0123456789$", 0, 4)};
+    hs_database_t *bdb = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, bdb);
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    err = hs_alloc_scratch(bdb, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string data;
+    for (size_t i = 0; i < 10; i++) {
+        data += "--abc-----------------defghijklmn--foowxyzbarbazquux-zz012-";
+        data += "12345678abcdef0123456789";
+    }
+
+    CallBackContext expected;
+    err = hs_scan(bdb, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(expected.matches.empty());
+
+    for (size_t chunk = 1; chunk < 40; chunk += 3) {
+        for (int compress = 0; compress < 2; compress++) {
+            SCOPED_TRACE(chunk);
+            SCOPED_TRACE(compress);
+            hs_stream_t *stream = nullptr;
+            err = hs_open_stream(db, 0, &stream);
+            ASSERT_EQ(HS_SUCCESS, err);
+
+            CallBackContext c;
+            for (size_t i = 0; i < data.size(); i += chunk) {
+                size_t len = min(chunk, data.size() - i);
+                err = hs_scan_stream(stream, data.c_str() + i, len, 0,
+                                     scratch, record_cb, (void *)&c);
+                ASSERT_EQ(HS_SUCCESS, err);
+                if (compress) {
+                    char buf[2000];
+                    size_t used = 0;
+                    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+                    ASSERT_EQ(HS_SUCCESS, err);
+                    err = hs_reset_and_expand_stream(stream, buf, used,
+                                                     nullptr, nullptr,
+                                                     nullptr);
+                    ASSERT_EQ(HS_SUCCESS, err);
+                }
+            }
+            err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+            ASSERT_EQ(HS_SUCCESS, err);
+            ASSERT_EQ(expected.matches, c.matches);
+        }
+    }
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+    hs_free_database(bdb);
+}
+
+// A prefix with stop characters may be killed by a miracle found in history
+// kept from an earlier write; the miracle must still fire (and suppress the
+// match) when it lands just before a write boundary.
+TEST(StreamUtil, history_miracle) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    vector<pattern> patterns = {pattern("[^X]{24}abcdefgh", 0, 1),
+                                pattern("q[^Y]{10,20}rstuvwxy", 0, 2)};
+    hs_database_t *bdb = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, bdb);
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    err = hs_alloc_scratch(bdb, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Put the stop character at every distance before the literal, including
+    // none at all, so that some prefixes survive and some are killed.
+    string data;
+    for (size_t i = 0; i < 30; i++) {
+        string run(32, '-');
+        if (i < run.size()) {
+            run[run.size() - 1 - i] = 'X';
+        }
+        data += run + "abcdefgh";
+        string tail(24, '.');
+        if (i < tail.size()) {
+            tail[tail.size() - 1 - i] = 'Y';
+        }
+        data += "q" + tail.substr(0, 10 + i % 10) + "rstuvwxy";
+    }
+
+    CallBackContext expected;
+    err = hs_scan(bdb, data.c_str(), data.size(), 0, scratch, record_cb,
+                  (void *)&expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(expected.matches.empty());
+
+    for (size_t chunk = 1; chunk < 48; chunk++) {
+        SCOPED_TRACE(chunk);
+        hs_stream_t *stream = nullptr;
+        err = hs_open_stream(db, 0, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        CallBackContext c;
+        for (size_t i = 0; i < data.size(); i += chunk) {
+            size_t len = min(chunk, data.size() - i);
+            err = hs_scan_stream(stream, data.c_str() + i, len, 0, scratch,
+                                 record_cb, (void *)&c);
+            ASSERT_EQ(HS_SUCCESS, err);
+        }
+        err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(expected.matches, c.matches);
+    }
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+    hs_free_database(bdb);
+}
+
+// Tiny writes that cannot end a literal skip most of the scan; matches that
+// straddle them must still be found at the right offsets.
+TEST(StreamUtil, tiny_writes) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    vector<pattern> patterns = {pattern("foobar", 0, 1),
+                                pattern("abc\\d{2}xyz", 0, 2),
+                                pattern("^-+q", 0, 3)};
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const vector<string> writes = {"---", "fo", "o", "----", "ba", "r", "--",
+                                   "ab", "c1", "2", "xy", "z", "q", "foo",
+                                   "-bar", "q"};
+    CallBackContext c;
+    for (const auto &w : writes) {
+        err = hs_scan_stream(stream, w.c_str(), w.size(), 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // "foo----bar" does not match; "abc12xyz" ends at 23.
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(23, 2), c.matches[0]);
+
+    stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    c.matches.clear();
+    const vector<string> writes2 = {"--", "-", "q", "-f", "oob", "-", "ar",
+                                    "foob", "a", "r"};
+    for (const auto &w : writes2) {
+        err = hs_scan_stream(stream, w.c_str(), w.size(), 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    ASSERT_EQ(2U, c.matches.size());
+    ASSERT_EQ(MatchRecord(4, 3), c.matches[0]);
+    ASSERT_EQ(MatchRecord(18, 1), c.matches[1]);
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, pool1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar$", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_pool_t *pool = nullptr;
+    err = hs_alloc_stream_pool(db, 2, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(pool != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+    hs_stream_t *stream3 = nullptr;
+    err = hs_pool_open_stream(pool, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_pool_open_stream(pool, 0, &stream2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(stream, stream2);
+
+    // pool is full
+    err = hs_pool_open_stream(pool, 0, &stream3);
+    ASSERT_EQ(HS_NOMEM, err);
+    ASSERT_TRUE(stream3 == nullptr);
+
+    CallBackContext c, c2;
+    err = hs_scan_stream(stream, data1, strlen(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    // other streams in the pool are unaffected by a reset
+    err = hs_reset_stream(stream2, 0, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // EOD match on close, after which the slot is reused
+    err = hs_pool_close_stream(pool, stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(9, 0), c.matches[0]);
+
+    err = hs_pool_close_stream(pool, stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    err = hs_pool_open_stream(pool, 0, &stream3);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(stream, stream3);
+
+    err = hs_scan_stream(stream3, data1, strlen(data1), 0, scratch, record_cb,
+                         (void *)&c2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_pool_close_stream(pool, stream3, scratch, record_cb, (void *)&c2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(c.matches, c2.matches);
+
+    // streams from outside the pool are rejected
+    hs_stream_t *heap_stream = nullptr;
+    err = hs_open_stream(db, 0, &heap_stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_pool_close_stream(pool, heap_stream, nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    hs_close_stream(heap_stream, nullptr, nullptr, nullptr);
+
+    err = hs_free_stream_pool(pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+static
+int count_streams(hs_stream_t *, void *ctxt) {
+    ++*(unsigned *)ctxt;
+    return 0;
+}
+
+static
+void record_move(hs_stream_t *from, hs_stream_t *to, void *ctxt) {
+    auto *streams = (vector<hs_stream_t *> *)ctxt;
+    replace(streams->begin(), streams->end(), from, to);
+}
+
+TEST(StreamUtil, pool_compact) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    size_t size = 0;
+    err = hs_stream_pool_size(db, 8, &size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    size_t stream_size = 0;
+    err = hs_stream_size(db, &stream_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_LE(8 * stream_size, size);
+
+    // caller-provided memory must be cacheline aligned
+    vector<char> mem(size + 128);
+    char *base = (char *)(((uintptr_t)mem.data() + 63) & ~(uintptr_t)63);
+    hs_stream_pool_t *pool = nullptr;
+    err = hs_init_stream_pool_at(db, 8, base + 8, &pool);
+    ASSERT_EQ(HS_BAD_ALIGN, err);
+    err = hs_init_stream_pool_at(db, 8, base, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Open eight streams, write "foo" to each and close every other one.
+    vector<hs_stream_t *> opened, streams;
+    for (size_t i = 0; i < 8; i++) {
+        hs_stream_t *stream = nullptr;
+        err = hs_pool_open_stream(pool, 0, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+        opened.push_back(stream);
+        err = hs_scan_stream(stream, "foo", 3, 0, scratch, dummy_cb, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+        if (i % 2 == 0) {
+            err = hs_pool_close_stream(pool, stream, nullptr, nullptr,
+                                       nullptr);
+            ASSERT_EQ(HS_SUCCESS, err);
+        } else {
+            streams.push_back(stream);
+        }
+    }
+
+    unsigned count = 0;
+    err = hs_iterate_stream_pool(pool, count_streams, &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(4U, count);
+
+    // the open streams now occupy the first four slots
+    err = hs_compact_stream_pool(pool, record_move, &streams);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(is_permutation(streams.begin(), streams.end(),
+                               opened.begin()));
+
+    // relocated streams keep their state
+    for (const auto &stream : streams) {
+        CallBackContext c;
+        err = hs_scan_stream(stream, "bar", 3, 0, scratch, record_cb,
+                             (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(1U, c.matches.size());
+        ASSERT_EQ(MatchRecord(6, 0), c.matches[0]);
+        err = hs_pool_close_stream(pool, stream, nullptr, nullptr, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    count = 0;
+    err = hs_iterate_stream_pool(pool, count_streams, &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, count);
+
+    err = hs_free_stream_pool(pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, pool_badargs) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_BLOCK,
+                                          &scratch);
+
+    hs_stream_pool_t *pool = nullptr;
+    err = hs_alloc_stream_pool(db, 4, &pool);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    ASSERT_TRUE(pool == nullptr);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+
+    db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM, &scratch);
+    err = hs_alloc_stream_pool(nullptr, 4, &pool);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_alloc_stream_pool(db, 0, &pool);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_alloc_stream_pool(db, 4, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_pool_open_stream(nullptr, 0, &stream);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_iterate_stream_pool(nullptr, count_streams, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_compact_stream_pool(nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_free_stream_pool(nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
 static size_t last_alloc;
 
 static
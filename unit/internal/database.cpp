@@ -56,10 +56,76 @@ TEST(DB, flagsToPlatform) {
     p.cpu_features |= HS_CPU_FEATURES_AVX512;
 #endif
 
+#if defined(HAVE_AVX512VBMI)
+    p.cpu_features |= HS_CPU_FEATURES_AVX512VBMI;
+#endif
+
     platform_t pp = target_to_platform(target_t(p));
     ASSERT_EQ(pp, hs_current_platform);
 }
 
+// A database may be loaded by a runtime that has every feature it was built
+// for, and by no other.
+TEST(DB, platformCompatibility) {
+    hs_platform_info built;
+    memset(&built, 0, sizeof(built));
+#if defined(HAVE_AVX2)
+    built.cpu_features |= HS_CPU_FEATURES_AVX2;
+#endif
+#if defined(HAVE_AVX512)
+    built.cpu_features |= HS_CPU_FEATURES_AVX512;
+#endif
+#if defined(HAVE_AVX512VBMI)
+    built.cpu_features |= HS_CPU_FEATURES_AVX512VBMI;
+#endif
+    const target_t runtime(built);
+
+    const unsigned long long tiers[] = {
+        0,
+        HS_CPU_FEATURES_AVX2,
+        HS_CPU_FEATURES_AVX2 | HS_CPU_FEATURES_AVX512,
+        HS_CPU_FEATURES_AVX2 | HS_CPU_FEATURES_AVX512
+            | HS_CPU_FEATURES_AVX512VBMI,
+    };
+    const platform_t tier_platforms[] = {
+        HS_PLATFORM_NOAVX2 | HS_PLATFORM_NOAVX512 | HS_PLATFORM_NOAVX512VBMI,
+        HS_PLATFORM_NOAVX512 | HS_PLATFORM_NOAVX512VBMI,
+        HS_PLATFORM_NOAVX512VBMI,
+        0,
+    };
+
+    for (size_t i = 0; i < sizeof(tiers) / sizeof(tiers[0]); i++) {
+        SCOPED_TRACE(i);
+        hs_platform_info p;
+        memset(&p, 0, sizeof(p));
+        p.cpu_features = tiers[i];
+        const target_t code(p);
+        ASSERT_EQ(tier_platforms[i], target_to_platform(code));
+
+        hs_database_t *db = nullptr;
+        hs_compile_error_t *compile_err = nullptr;
+        hs_error_t err = hs_compile("foo[0-9]+bar", 0, HS_MODE_BLOCK, &p, &db,
+                                    &compile_err);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        char *bytes = nullptr;
+        size_t length = 0;
+        err = hs_serialize_database(db, &bytes, &length);
+        ASSERT_EQ(HS_SUCCESS, err);
+        hs_free_database(db);
+
+        hs_database_t *db2 = nullptr;
+        err = hs_deserialize_database(bytes, length, &db2);
+        free(bytes);
+        if (runtime.can_run_on_code_built_for(code)) {
+            ASSERT_EQ(HS_SUCCESS, err);
+            hs_free_database(db2);
+        } else {
+            ASSERT_EQ(HS_DB_PLATFORM_ERROR, err);
+        }
+    }
+}
+
 TEST(CRC, alignments) {
     std::array<u8, 4096> a;
     a.fill('a');
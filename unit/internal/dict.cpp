@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "ue2common.h"
+#include "hwlm/dict_build.h"
+#include "hwlm/dict_engine.h"
+#include "hwlm/hwlm.h"
+#include "hwlm/hwlm_literal.h"
+#include "lit_matcher_common.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+using std::set;
+using std::string;
+using std::vector;
+using namespace ue2;
+
+namespace {
+
+static
+vector<litMatch> scan(const dictTable *t, const string &data,
+                      size_t start = 0,
+                      hwlm_group_t groups = HWLM_ALL_GROUPS) {
+    auto &matches = recordedMatches();
+    recordedMatches().clear();
+    hwlm_error_t rv = dictExec(t, (const u8 *)data.c_str(), data.size(), start,
+                               recordCallback, nullptr, groups);
+    EXPECT_EQ(HWLM_SUCCESS, rv);
+    // matches must be in end offset order
+    EXPECT_TRUE(std::is_sorted(matches.begin(), matches.end(),
+                               [](const litMatch &a, const litMatch &b) {
+                                   return a.to < b.to;
+                               }));
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+static
+vector<litMatch> scanStreaming(const dictTable *t, const string &hist,
+                               const string &data) {
+    auto &matches = recordedMatches();
+    recordedMatches().clear();
+    hwlm_error_t rv = dictExecStreaming(
+        t, (const u8 *)hist.c_str(), hist.size(), (const u8 *)data.c_str(),
+        data.size(), recordCallback, nullptr, HWLM_ALL_GROUPS);
+    EXPECT_EQ(HWLM_SUCCESS, rv);
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+// The dictionary does not report matches ending at the same offset in literal
+// order, so compare sorted against the reference.
+static
+vector<litMatch> sortedReference(const vector<hwlmLiteral> &lits,
+                                 const string &data, size_t from,
+                                 size_t floor, size_t adj) {
+    auto rv = reference(lits, data, from, floor, adj);
+    std::sort(rv.begin(), rv.end());
+    return rv;
+}
+
+} // namespace
+
+TEST(DictMatcher, Basic) {
+    vector<hwlmLiteral> lits = {{"evil.com", false, 1},
+                                {"bad", true, 2},
+                                {"x", false, 3}};
+    auto t = dictBuildTable(lits);
+    ASSERT_TRUE(t != nullptr);
+
+    auto m = scan(t.get(), "www.evil.com BAD x");
+    vector<litMatch> expected = {{11, 1}, {15, 2}, {17, 3}};
+    ASSERT_EQ(expected, m);
+
+    // A match may not start before the start offset.
+    m = scan(t.get(), "www.evil.com BAD x", 5);
+    expected = {{15, 2}, {17, 3}};
+    ASSERT_EQ(expected, m);
+}
+
+TEST(DictMatcher, MaskedLiteral) {
+    hwlmLiteral lit("bc", false, false, 1, HWLM_ALL_GROUPS, {0xff, 0, 0},
+                    {'a', 0, 0});
+    auto t = dictBuildTable({lit});
+    ASSERT_TRUE(t != nullptr);
+
+    auto m = scan(t.get(), "xbc abc");
+    vector<litMatch> expected = {{6, 1}};
+    ASSERT_EQ(expected, m);
+}
+
+TEST(DictMatcher, Groups) {
+    hwlmLiteral lit1("abc", false, false, 1, 0x1, {}, {});
+    hwlmLiteral lit2("def", false, false, 2, 0x2, {}, {});
+    auto t = dictBuildTable({lit1, lit2});
+    ASSERT_TRUE(t != nullptr);
+
+    auto m = scan(t.get(), "abc def", 0, 0x2);
+    vector<litMatch> expected = {{6, 2}};
+    ASSERT_EQ(expected, m);
+}
+
+TEST(DictMatcher, Terminate) {
+    vector<hwlmLiteral> lits = {{"abc", false, 1}, {"def", false, 2}};
+    auto t = dictBuildTable(lits);
+    ASSERT_TRUE(t != nullptr);
+
+    const string data = "abc def abc";
+    recordedMatches().clear();
+    hwlm_error_t rv = dictExec(t.get(), (const u8 *)data.c_str(), data.size(),
+                               0, recordTerminateCallback, nullptr,
+                               HWLM_ALL_GROUPS);
+    ASSERT_EQ(HWLM_TERMINATED, rv);
+    ASSERT_EQ(1U, recordedMatches().size());
+}
+
+TEST(DictMatcher, Streaming) {
+    vector<hwlmLiteral> lits = {{"abcdefgh", false, 1}, {"fg", false, 2}};
+    auto t = dictBuildTable(lits);
+    ASSERT_TRUE(t != nullptr);
+
+    auto m = scanStreaming(t.get(), "xxabcde", "fghfg");
+    vector<litMatch> expected = {{1, 2}, {2, 1}, {4, 2}};
+    ASSERT_EQ(expected, m);
+
+    // not enough history for the long literal
+    m = scanStreaming(t.get(), "de", "fgh");
+    expected = {{1, 2}};
+    ASSERT_EQ(expected, m);
+}
+
+TEST(DictMatcher, Large) {
+    srand(11);
+    const char *alphabet = "abcdAB";
+
+    // A large dictionary of mixed length literals, with short literals
+    // sharing suffixes with long ones.
+    set<string> seen;
+    vector<hwlmLiteral> lits;
+    while (lits.size() < 20000) {
+        string s = randomString(3 + rand() % 6, alphabet);
+        if (!seen.insert(s).second) {
+            continue;
+        }
+        lits.emplace_back(s, false, lits.size());
+    }
+    for (const char *s : {"a", "bb", "dAb"}) {
+        lits.emplace_back(s, true, lits.size());
+    }
+
+    auto t = dictBuildTable(lits);
+    ASSERT_TRUE(t != nullptr);
+
+    for (u32 iter = 0; iter < 20; iter++) {
+        string data = randomString(1 + rand() % 500, alphabet);
+        size_t start = rand() % data.size();
+        ASSERT_EQ(sortedReference(lits, data, start, start, 0),
+                  scan(t.get(), data, start));
+
+        size_t split = rand() % data.size();
+        ASSERT_EQ(sortedReference(lits, data, split,
+                                  split < 8 ? 0 : split - 8, split),
+                  scanStreaming(t.get(), data.substr(0, split),
+                                data.substr(split)));
+    }
+}
@@ -177,7 +177,7 @@ TEST_P(FDRp, Simple) {
                                     Grey());
     CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     fdrExec(fdr.get(), (const u8 *)data, sizeof(data), 0, decentCallback,
             &scratch, HWLM_ALL_GROUPS);
@@ -202,7 +202,7 @@ TEST_P(FDRp, SimpleSingle) {
                                     Grey());
     CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     fdrExec(fdr.get(), (const u8 *)data, sizeof(data) - 1 /* skip nul */, 0,
             decentCallback, &scratch, HWLM_ALL_GROUPS);
@@ -230,7 +230,7 @@ TEST_P(FDRp, MultiLocation) {
 
     vector<u8> data(testSize, 0);
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     for (u32 i = 0; i < testSize - 3; i++) {
         memcpy(data.data() + i, "abc", 3);
@@ -243,6 +243,53 @@ TEST_P(FDRp, MultiLocation) {
     }
 }
 
+TEST_P(FDRp, ConfirmBlocks) {
+    const u32 hint = GetParam();
+    SCOPED_TRACE(hint);
+
+    // Literals sharing suffixes, of mixed lengths, some caseless and some
+    // noruns.
+    const string prefixes = "0123456789abcdefghijklmnopqrstuvwxyz";
+    vector<hwlmLiteral> lits;
+    u32 id = 0;
+    for (const char *suffix : {"z", "az", "Qaz"}) {
+        for (u32 i = 0; i < prefixes.size(); i += 3) {
+            string s = string(1, prefixes[i]) + suffix;
+            lits.push_back(hwlmLiteral(s, i % 2, i % 5 == 0, id++,
+                                       HWLM_ALL_GROUPS, {}, {}));
+        }
+    }
+
+    string data;
+    for (u32 i = 0; i < prefixes.size(); i++) {
+        data += string("__") + prefixes[prefixes.size() - i - 1] + "qAZ";
+        data += prefixes[i] + string("z") + prefixes[i] + "z";
+    }
+
+    // Build once with confirm blocks disabled and once with every hash chain
+    // laid out as a confirm block; the matches must be the same.
+    vector<match> expected;
+    for (u32 minChain : {0U, 1U}) {
+        Grey grey;
+        grey.fdrConfirmBlockMinChain = minChain;
+        auto fdr = buildFDREngineHinted(lits, false, hint,
+                                        get_current_target(), grey);
+        CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
+
+        struct hs_scratch scratch = {};
+        scratch.fdr_conf = NULL;
+        fdrExec(fdr.get(), (const u8 *)data.c_str(), data.size(), 0,
+                decentCallback, &scratch, HWLM_ALL_GROUPS);
+        if (!minChain) {
+            ASSERT_FALSE(matches.empty());
+            expected = matches;
+        } else {
+            ASSERT_EQ(expected, matches);
+        }
+        matches.clear();
+    }
+}
+
 TEST_P(FDRp, NoRepeat1) {
     const u32 hint = GetParam();
     SCOPED_TRACE(hint);
@@ -256,7 +303,7 @@ TEST_P(FDRp, NoRepeat1) {
                                     Grey());
     CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     fdrExec(fdr.get(), (const u8 *)data, sizeof(data) - 1 /* skip nul */, 0,
             decentCallback, &scratch, HWLM_ALL_GROUPS);
@@ -280,7 +327,7 @@ TEST_P(FDRp, NoRepeat2) {
                                     Grey());
     CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     fdrExec(fdr.get(), (const u8 *)data, sizeof(data) - 1 /* skip nul */, 0,
             decentCallback, &scratch, HWLM_ALL_GROUPS);
@@ -305,7 +352,7 @@ TEST_P(FDRp, NoRepeat3) {
                                     Grey());
     CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     fdrExec(fdr.get(), (const u8 *)data, sizeof(data) - 1 /* skip nul */, 0,
             decentCallback, &scratch, HWLM_ALL_GROUPS);
@@ -330,7 +377,7 @@ hwlm_error_t safeExecStreaming(const FDR *fdr, const u8 *hbuf, size_t hlen,
         memcpy(new_hbuf, hbuf, hlen);
         hbuf = new_hbuf;
     }
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     return fdrExecStreaming(fdr, hbuf, hlen, buf, len, start, cb, &scratch,
                             groups);
@@ -431,7 +478,7 @@ TEST_P(FDRp, moveByteStream) {
     }
 
     // check matches
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
 
     hwlm_error_t fdrStatus = fdrExec(fdrTable.get(), (const u8 *)data,
@@ -513,7 +560,7 @@ TEST_P(FDRpp, AlignAndTooEarly) {
         aligned_free_internal);
 
     vector<hwlmLiteral> lits;
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     for (size_t litLen = 1; litLen <= patLen; litLen++) {
 
@@ -636,7 +683,7 @@ TEST_P(FDRpa, ShortWritings) {
     }
 
     // run the literal matching through all generated literals
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     for (size_t patIdx = 0; patIdx < pats.size();) {
         // group them in the sets of 32
@@ -732,7 +779,7 @@ TEST(FDR, FDRTermB) {
     ASSERT_TRUE(fdr != nullptr);
 
     // check matches
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
 
     fdrStatus = fdrExec(fdr.get(), (const u8 *)data1, data_len1,
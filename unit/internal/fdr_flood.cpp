@@ -152,7 +152,7 @@ TEST_P(FDRFloodp, NoMask) {
     vector<u8> data(dataSize);
     u8 c = 0;
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     while (1) {
         SCOPED_TRACE((unsigned int)c);
@@ -246,7 +246,7 @@ TEST_P(FDRFloodp, WithMask) {
     vector<u8> data(dataSize);
     u8 c = '\0';
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     while (1) {
         u8 bit = 1 << (c & 0x7);
@@ -412,7 +412,7 @@ TEST_P(FDRFloodp, StreamingMask) {
     vector<u8> tempdata(dataSize + fake_history_size); // headroom
     u8 c = '\0';
 
-    struct hs_scratch scratch;
+    struct hs_scratch scratch = {};
     scratch.fdr_conf = NULL;
     while (1) {
         u8 bit = 1 << (c & 0x7);
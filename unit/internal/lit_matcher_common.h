@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIT_MATCHER_COMMON_H
+#define LIT_MATCHER_COMMON_H
+
+#include "ue2common.h"
+#include "hwlm/hwlm.h"
+#include "hwlm/hwlm_literal.h"
+#include "util/compare.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ue2 {
+
+// A match reported by a literal matcher under test.
+struct litMatch {
+    size_t to;
+    u32 id;
+    litMatch(size_t end, u32 identifier) : to(end), id(identifier) {}
+    bool operator==(const litMatch &b) const {
+        return to == b.to && id == b.id;
+    }
+    bool operator<(const litMatch &b) const {
+        return to < b.to || (to == b.to && id < b.id);
+    }
+};
+
+// Matches recorded by the callbacks below.
+inline
+std::vector<litMatch> &recordedMatches() {
+    static std::vector<litMatch> matches;
+    return matches;
+}
+
+inline
+hwlmcb_rv_t recordCallback(size_t to, u32 id, UNUSED struct hs_scratch *) {
+    DEBUG_PRINTF("match @%zu = %u\n", to, id);
+    recordedMatches().emplace_back(to, id);
+    return HWLM_ALL_GROUPS;
+}
+
+inline
+hwlmcb_rv_t recordTerminateCallback(size_t to, u32 id,
+                                    UNUSED struct hs_scratch *) {
+    recordedMatches().emplace_back(to, id);
+    return HWLM_TERMINATE_MATCHING;
+}
+
+inline
+bool litMatches(const hwlmLiteral &lit, const char *p) {
+    for (size_t i = 0; i < lit.s.size(); i++) {
+        char a = lit.s[i], b = p[i];
+        if (lit.nocase ? mytoupper(a) != mytoupper(b) : a != b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reference matcher: every literal ending at or after from and lying entirely
+// inside [floor, data.size()), reported in end offset order, then literal
+// order. Reported offsets have adj subtracted.
+inline
+std::vector<litMatch> reference(const std::vector<hwlmLiteral> &lits,
+                                const std::string &data, size_t from,
+                                size_t floor, size_t adj) {
+    std::vector<litMatch> rv;
+    for (size_t end = from; end < data.size(); end++) {
+        for (const auto &lit : lits) {
+            size_t len = lit.s.size();
+            if (end + 1 < floor + len) {
+                continue;
+            }
+            if (litMatches(lit, data.c_str() + end + 1 - len)) {
+                rv.emplace_back(end - adj, lit.id);
+            }
+        }
+    }
+    return rv;
+}
+
+inline
+std::string randomString(size_t len, const char *alphabet) {
+    size_t alen = strlen(alphabet);
+    std::string s(len, '\0');
+    for (auto &c : s) {
+        c = alphabet[rand() % alen];
+    }
+    return s;
+}
+
+} // namespace ue2
+
+#endif // LIT_MATCHER_COMMON_H
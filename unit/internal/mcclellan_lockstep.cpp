@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "gtest/gtest.h"
+
+#include "database.h"
+#include "grey.h"
+#include "hs_internal.h"
+#include "nfa/nfa_internal.h"
+#include "rose/rose_internal.h"
+
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace testing;
+using namespace ue2;
+
+// Each of these becomes its own 8-bit McClellan outfix.
+static const char *const LOCKSTEP_EXPRS[] = {
+    "[\\x01-\\x08]",
+    "[a-f][0-9]",
+    "[0-9]{2}[g-k]",
+    "[A-Z][a-z]{3}[A-Z]",
+    "q[0-9a-f]{2}r",
+    "[xyz][^xyz]z",
+    "--[0-9]",
+    "[#$%][a-z]",
+    "[^a-z]{3}[aeiou]",
+};
+
+static const u32 LOCKSTEP_EXPR_COUNT =
+    sizeof(LOCKSTEP_EXPRS) / sizeof(LOCKSTEP_EXPRS[0]);
+
+static const vector<string> LOCKSTEP_CORPORA = {
+    "\x01",                          // match at offset 0, end of buffer
+    "a1",                            // match starting at offset 0
+    "________________________q3fr",  // match at the end of the buffer
+    "Abcd_______--______________",   // lane leaving at its first accept
+    "________________________________________________",
+    "\x02" "a1Abc" "dE__77h_--3_%x_qa0rxaz___...u_y_z_0ff__q3fr",
+    "c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4c4",
+    "9999999999999999999999999999999999999999999999999999999999j",
+};
+
+typedef set<tuple<unsigned, unsigned long long, unsigned long long>> MatchSet;
+
+static
+int recordMatch(unsigned id, unsigned long long from, unsigned long long to,
+                unsigned, void *ctx) {
+    MatchSet *matches = (MatchSet *)ctx;
+    matches->emplace(id, from, to);
+    return 0;
+}
+
+static
+hs_database_t *buildLockstepDb(u32 count, bool lockstep) {
+    Grey grey;
+    grey.lockstepOutfixes = lockstep;
+    grey.mergeOutfixes = false;
+    grey.allowSmallWrite = false;
+    grey.allowSheng = false;
+    grey.allowMcSheng = false;
+    grey.allowViolet = false;
+    grey.allowDecoratedLiteral = false;
+    grey.allowSmallLiteralSet = false;
+    grey.allowAnchoredAcyclic = false;
+    grey.allowPuff = false;
+    grey.roseMasks = false;
+    grey.accelerateDFA = false;
+
+    vector<unsigned> flags(count, 0);
+    vector<unsigned> ids;
+    for (u32 i = 0; i < count; i++) {
+        ids.push_back(i + 1);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_multi_int(LOCKSTEP_EXPRS, flags.data(),
+                                          ids.data(), nullptr, count,
+                                          HS_MODE_BLOCK, nullptr, &db,
+                                          &compile_err, grey);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return nullptr;
+    }
+    return db;
+}
+
+static
+u32 countLockstepOutfixes(const hs_database_t *db) {
+    const RoseEngine *t = (const RoseEngine *)hs_get_bytecode(db);
+    u32 count = 0;
+    for (u32 qi = t->outfixBeginQueue; qi < t->outfixEndQueue; qi++) {
+        const NfaInfo *info = getNfaInfoByQueue(t, qi);
+        if (info->lockstep) {
+            EXPECT_EQ(MCCLELLAN_NFA_8, getNfaByInfo(t, info)->type);
+            count++;
+        }
+    }
+    return count;
+}
+
+class LockstepOutfixTest : public TestWithParam<u32> {};
+
+// Outfixes run in lockstep must report exactly what they report when each is
+// run alone, however many share the group and wherever their lanes leave it.
+TEST_P(LockstepOutfixTest, MatchesAgree) {
+    const u32 count = GetParam();
+
+    hs_database_t *db = buildLockstepDb(count, false);
+    ASSERT_NE(nullptr, db);
+    hs_database_t *ls_db = buildLockstepDb(count, true);
+    ASSERT_NE(nullptr, ls_db);
+
+    EXPECT_EQ(0U, countLockstepOutfixes(db));
+    EXPECT_LE(2U, countLockstepOutfixes(ls_db));
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_alloc_scratch(ls_db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    for (const auto &corpus : LOCKSTEP_CORPORA) {
+        SCOPED_TRACE(corpus);
+        MatchSet expected;
+        err = hs_scan(db, corpus.c_str(), corpus.size(), 0, scratch,
+                      recordMatch, &expected);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        MatchSet actual;
+        err = hs_scan(ls_db, corpus.c_str(), corpus.size(), 0, scratch,
+                      recordMatch, &actual);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_EQ(expected, actual);
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(ls_db);
+    hs_free_database(db);
+}
+
+INSTANTIATE_TEST_CASE_P(Lockstep, LockstepOutfixTest,
+                        Range(2U, LOCKSTEP_EXPR_COUNT + 1));
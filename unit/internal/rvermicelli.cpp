@@ -218,3 +218,42 @@ TEST(RDoubleVermicelli, Exec5) {
         }
     }
 }
+
+TEST(RVermicelli, ExecLong) {
+    // Long enough for the wide loops used on AVX2 and AVX-512 targets.
+    char t1[300];
+
+    for (size_t i = 0; i < 16; i++) {
+        for (size_t pos = 1; pos + i < sizeof(t1); pos += 7) {
+            memset(t1, 'b', sizeof(t1));
+            t1[pos] = 'a';
+            const u8 *begin = (const u8 *)t1;
+            const u8 *end = (const u8 *)t1 + sizeof(t1) - i;
+
+            const u8 *rv = rvermicelliExec('a', 0, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = rvermicelliExec('A', 1, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = rnvermicelliExec('b', 0, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = rnvermicelliExec('B', 1, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            // The double scan doesn't look at the first few bytes, leaving
+            // those to the caller.
+            if (pos < 32) {
+                continue;
+            }
+            t1[pos - 1] = 'A';
+
+            rv = rvermicelliDoubleExec('A', 'a', 0, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = rvermicelliDoubleExec('A', 'A', 1, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+        }
+    }
+}
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "gtest/gtest.h"
+
+#include "grey.h"
+#include "compiler/compiler.h"
+#include "nfa/mcclellan.h"
+#include "nfa/mcclellancompile.h"
+#include "nfa/mcsheng_compile.h"
+#include "nfa/nfa_api.h"
+#include "nfa/nfa_api_util.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/rdfa.h"
+#include "nfa/sheng.h"
+#include "nfa/shengcompile.h"
+#include "nfagraph/ng.h"
+#include "nfagraph/ng_mcclellan.h"
+#include "nfagraph/ng_util.h"
+#include "util/bytecode_ptr.h"
+#include "util/compile_context.h"
+#include "util/report_manager.h"
+#include "util/target_info.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(HAVE_AVX512VBMI)
+
+using namespace std;
+using namespace testing;
+using namespace ue2;
+
+static const u32 MATCH_REPORT = 1024;
+
+static
+int onMatch(u64a, u64a to, ReportID, void *ctx) {
+    vector<u64a> *matches = (vector<u64a> *)ctx;
+    matches->push_back(to);
+    return MO_CONTINUE_MATCHING;
+}
+
+struct ShengTestParam {
+    const char *expr;
+    const char *corpus;
+    u8 type; //!< expected NFAEngineType
+};
+
+static
+ostream &operator<<(ostream &os, const ShengTestParam &p) {
+    return os << "/" << p.expr << "/ type " << (int)p.type;
+}
+
+static
+unique_ptr<raw_dfa> buildRawDfa(ReportManager &rm, const CompileContext &cc,
+                                const char *expr) {
+    ParsedExpression parsed(0, expr, 0, 0);
+    auto built_expr = buildGraph(rm, cc, parsed);
+    if (!built_expr.g) {
+        return nullptr;
+    }
+    clearReports(*built_expr.g);
+    rm.setProgramOffset(0, MATCH_REPORT);
+    return buildMcClellan(*built_expr.g, &rm, cc.grey);
+}
+
+/** Tries the Sheng widths in the same order as the Rose and SmallWrite
+ * builders. */
+static
+bytecode_ptr<NFA> buildSheng(raw_dfa &rdfa, const CompileContext &cc,
+                             const ReportManager &rm, bool only_accel_init) {
+    auto nfa = shengCompile(rdfa, cc, rm, only_accel_init);
+    if (!nfa) {
+        nfa = sheng32Compile(rdfa, cc, rm, only_accel_init);
+    }
+    if (!nfa) {
+        nfa = sheng64Compile(rdfa, cc, rm, only_accel_init);
+    }
+    return nfa;
+}
+
+/** Scans data as one block through the queue API, or as two stream writes
+ * with the state compressed and expanded in between if split is nonzero. */
+static
+vector<u64a> scanQueue(const NFA *nfa, const string &data, size_t split) {
+    vector<u64a> matches;
+    auto full_state = make_bytecode_ptr<char>(nfa->scratchStateSize, 64);
+    auto stream_state = make_bytecode_ptr<char>(nfa->streamStateSize);
+    const u8 *buf = (const u8 *)data.c_str();
+    const size_t first = split ? split : data.size();
+
+    struct mq q;
+    q.nfa = nfa;
+    q.cur = 0;
+    q.end = 0;
+    q.state = full_state.get();
+    q.streamState = stream_state.get();
+    q.offset = 0;
+    q.buffer = buf;
+    q.length = first;
+    q.history = nullptr;
+    q.hlength = 0;
+    q.scratch = nullptr; /* DFAs do not use scratch */
+    q.report_current = 0;
+    q.cb = onMatch;
+    q.context = &matches;
+
+    nfaQueueInitState(nfa, &q);
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, first);
+    nfaQueueExec(nfa, &q, first);
+
+    if (!split) {
+        return matches;
+    }
+
+    nfaQueueCompressState(nfa, &q, first);
+    memset(full_state.get(), 0xff, nfa->scratchStateSize);
+    nfaExpandState(nfa, full_state.get(), stream_state.get(), split,
+                   buf[split - 1]);
+
+    const size_t rest = data.size() - split;
+    q.cur = 0;
+    q.end = 0;
+    q.offset = split;
+    q.buffer = buf + split;
+    q.length = rest;
+    q.history = buf;
+    q.hlength = split;
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_END, rest);
+    nfaQueueExec(nfa, &q, rest);
+
+    return matches;
+}
+
+/** Scans data with the engine's block entry point, as SmallWrite does. */
+static
+vector<u64a> scanSmallWrite(const NFA *nfa, const string &data) {
+    vector<u64a> matches;
+    const u8 *buf = (const u8 *)data.c_str();
+
+    switch (nfa->type) {
+    case MCCLELLAN_NFA_8:
+        nfaExecMcClellan8_B(nfa, 0, buf, data.size(), onMatch, &matches);
+        break;
+    case MCCLELLAN_NFA_16:
+        nfaExecMcClellan16_B(nfa, 0, buf, data.size(), onMatch, &matches);
+        break;
+    case SHENG_NFA_32:
+        nfaExecSheng32_B(nfa, 0, buf, data.size(), onMatch, &matches);
+        break;
+    case SHENG_NFA_64:
+        nfaExecSheng64_B(nfa, 0, buf, data.size(), onMatch, &matches);
+        break;
+    default:
+        ADD_FAILURE() << "unexpected engine type " << (int)nfa->type;
+        break;
+    }
+
+    return matches;
+}
+
+// Parameterized with an expression whose DFA needs a wide Sheng, a corpus
+// and the Sheng width expected for it.
+class ShengWideTest : public TestWithParam<ShengTestParam> {
+protected:
+    virtual void SetUp() {
+        // These engines only run on hosts with VBMI.
+        vbmi = get_current_target().has_avx512vbmi();
+    }
+
+    bool vbmi = false;
+};
+
+static const ShengTestParam shengWideParams[] = {
+    // 17 to 32 states
+    {"abcdefghijklmnopqrst",
+     "abcdefghijklmnopqrst__abcdefghijklmnopqrsabcdefghijklmnopqrst"
+     "abcdefghijklmnopqrstabcdefghij_abcdefghijklmnopqrst",
+     SHENG_NFA_32},
+    {"^[0-9]{4}-[a-z]{4}-[0-9]{4}-xyz", "1234-abcd-5678-xyz-9012-efgh-xyz",
+     SHENG_NFA_32},
+    // 33 to 64 states
+    {"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN",
+     "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN_abcdefghijklmnopqrstuvwxyz"
+     "ABCDEFGHIJKLMabcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN",
+     SHENG_NFA_64},
+    {"^[0-9]{10}:[a-z]{10}:[0-9]{10}",
+     "0123456789:abcdefghij:0123456789:klmnopqrst",
+     SHENG_NFA_64},
+};
+
+INSTANTIATE_TEST_CASE_P(Sheng, ShengWideTest, ValuesIn(shengWideParams));
+
+// The wide Sheng chosen for the DFA must report the same matches as the
+// McClellan DFA built when Sheng is not allowed, in block mode, across a
+// stream write boundary and through the SmallWrite entry point.
+TEST_P(ShengWideTest, MatchesMcClellan) {
+    if (!vbmi) {
+        return;
+    }
+
+    const ShengTestParam &p = GetParam();
+    const string corpus(p.corpus);
+    const u32 min_states = p.type == SHENG_NFA_32 ? 17 : 33;
+    const u32 max_states = p.type == SHENG_NFA_32 ? 32 : 64;
+
+    Grey no_sheng;
+    no_sheng.allowSheng = false;
+
+    for (int streaming = 0; streaming < 2; streaming++) {
+        SCOPED_TRACE(streaming);
+        CompileContext cc(streaming, false, get_current_target(), Grey());
+        CompileContext cc_ref(streaming, false, get_current_target(),
+                              no_sheng);
+        ReportManager rm(cc.grey);
+
+        auto rdfa = buildRawDfa(rm, cc, p.expr);
+        ASSERT_TRUE(rdfa != nullptr);
+        ASSERT_LE(min_states, rdfa->states.size());
+        ASSERT_GE(max_states, rdfa->states.size());
+        auto rdfa_ref = buildRawDfa(rm, cc_ref, p.expr);
+        ASSERT_TRUE(rdfa_ref != nullptr);
+
+        // SmallWrite only looks for acceleration from the start states.
+        const bool only_accel_init = !streaming;
+        auto sheng = buildSheng(*rdfa, cc, rm, only_accel_init);
+        ASSERT_TRUE(sheng != nullptr);
+        ASSERT_EQ(p.type, sheng->type);
+        ASSERT_TRUE(buildSheng(*rdfa_ref, cc_ref, rm, only_accel_init)
+                    == nullptr);
+        auto ref = mcclellanCompile(*rdfa_ref, cc_ref, rm, only_accel_init);
+        ASSERT_TRUE(ref != nullptr);
+
+        const auto expected = scanQueue(ref.get(), corpus, 0);
+        ASSERT_FALSE(expected.empty());
+        ASSERT_EQ(expected, scanQueue(sheng.get(), corpus, 0));
+
+        if (streaming) {
+            for (size_t split = 1; split < corpus.size(); split++) {
+                SCOPED_TRACE(split);
+                ASSERT_EQ(expected, scanQueue(sheng.get(), corpus, split));
+            }
+        } else {
+            ASSERT_EQ(expected, scanSmallWrite(ref.get(), corpus));
+            ASSERT_EQ(expected, scanSmallWrite(sheng.get(), corpus));
+        }
+    }
+}
+
+// A DFA of more than 64 states whose floating start leads into a sticky
+// region of more than 16 states without reports, so that it needs McSheng and
+// can use a 64-state Sheng region.
+static const char MCSHENG64_EXPR[] =
+    "(abcdefghijklmnopqrstuvwxyz|ABCDEFGHIJKLMNOPQRSTUVWXYZ)[0-9]{40}";
+
+static
+string mcsheng64Corpus() {
+    const string digits(40, '7');
+    string corpus = "__abcdefghijklmnopqrstuvwxyz" + digits + "__";
+    corpus += "ABCDEFGHIJKLMNOPQRSTUVWXYZ" + digits + digits;
+    corpus += "abcdefghijklmABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789x";
+    corpus += "abcdefghijklmnopqrstuvwxyz" + digits.substr(0, 39) + "_";
+    corpus += "abcdefghijklmnopqrstuvwxyz" + digits;
+    return corpus;
+}
+
+/** Builds the DFA in the order the Rose builder uses for a non-transient
+ * engine once the Sheng widths have been tried. */
+static
+bytecode_ptr<NFA> buildMcSheng(raw_dfa &rdfa, const CompileContext &cc,
+                               const ReportManager &rm) {
+    auto nfa = mcshengCompile64(rdfa, cc, rm);
+    if (!nfa) {
+        nfa = mcshengCompile(rdfa, cc, rm);
+    }
+    if (!nfa) {
+        nfa = mcclellanCompile(rdfa, cc, rm, false);
+    }
+    return nfa;
+}
+
+// Parameterized with allowMcClellan8.
+class McSheng64Test : public TestWithParam<bool> {
+protected:
+    virtual void SetUp() {
+        // These engines only run on hosts with VBMI.
+        vbmi = get_current_target().has_avx512vbmi();
+    }
+
+    bool vbmi = false;
+};
+
+INSTANTIATE_TEST_CASE_P(McSheng64, McSheng64Test, Bool());
+
+// McSheng64 must be chosen for a Sheng region of more than 16 states, and
+// must report the same matches as the engine built when it is not allowed,
+// both in block mode and across a stream write boundary.
+TEST_P(McSheng64Test, MatchesWithoutMcSheng64) {
+    if (!vbmi) {
+        return;
+    }
+
+    const string corpus = mcsheng64Corpus();
+
+    Grey grey;
+    grey.allowMcClellan8 = GetParam();
+    Grey no_mcsheng64 = grey;
+    no_mcsheng64.allowMcSheng64 = false;
+
+    for (int streaming = 0; streaming < 2; streaming++) {
+        SCOPED_TRACE(streaming);
+        CompileContext cc(streaming, false, get_current_target(), grey);
+        CompileContext cc_ref(streaming, false, get_current_target(),
+                              no_mcsheng64);
+        ReportManager rm(cc.grey);
+
+        auto rdfa = buildRawDfa(rm, cc, MCSHENG64_EXPR);
+        ASSERT_TRUE(rdfa != nullptr);
+        ASSERT_LT(64U, rdfa->states.size());
+        ASSERT_GE(256U, rdfa->states.size());
+        auto rdfa_ref = buildRawDfa(rm, cc_ref, MCSHENG64_EXPR);
+        ASSERT_TRUE(rdfa_ref != nullptr);
+
+        // Too big for any Sheng, so McSheng is the first candidate.
+        ASSERT_TRUE(buildSheng(*rdfa, cc, rm, false) == nullptr);
+
+        auto mcsheng = buildMcSheng(*rdfa, cc, rm);
+        ASSERT_TRUE(mcsheng != nullptr);
+        ASSERT_EQ(grey.allowMcClellan8 ? MCSHENG_64_NFA_8 : MCSHENG_64_NFA_16,
+                  mcsheng->type);
+        auto ref = buildMcSheng(*rdfa_ref, cc_ref, rm);
+        ASSERT_TRUE(ref != nullptr);
+        ASSERT_NE(MCSHENG_64_NFA_8, ref->type);
+        ASSERT_NE(MCSHENG_64_NFA_16, ref->type);
+
+        const auto expected = scanQueue(ref.get(), corpus, 0);
+        ASSERT_FALSE(expected.empty());
+        ASSERT_EQ(expected, scanQueue(mcsheng.get(), corpus, 0));
+
+        if (streaming) {
+            for (size_t split = 1; split < corpus.size(); split++) {
+                SCOPED_TRACE(split);
+                ASSERT_EQ(expected, scanQueue(mcsheng.get(), corpus, split));
+            }
+        }
+    }
+}
+
+#endif // HAVE_AVX512VBMI
@@ -29,6 +29,7 @@
 #include "config.h"
 
 #include <set>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "nfa/shufti.h"
@@ -1111,3 +1112,137 @@ TEST(ReverseShufti, ExecMatch6) {
         ASSERT_EQ((const u8 *)t1 + i, rv);
     }
 }
+
+static
+const u8 *multiShuftiRef(const CharReach &onechar,
+                         const std::vector<CharReach> &classes, const u8 *buf,
+                         const u8 *buf_end) {
+    for (const u8 *c = buf; c < buf_end; c++) {
+        if (onechar.test(*c)) {
+            return c;
+        }
+        size_t i = 0;
+        while (i < classes.size() && c + i < buf_end
+               && classes[i].test(c[i])) {
+            i++;
+        }
+        if (i == classes.size() || c + i == buf_end) {
+            return c;
+        }
+    }
+    return buf_end;
+}
+
+TEST(MultiShufti, BuildMasks) {
+    CharReach hex;
+    hex.setRange('a', 'f');
+    hex.setRange('0', '9');
+    CharReach sep;
+    sep.set('-');
+    sep.set(':');
+    CharReach nl;
+    nl.set('\n');
+    std::vector<CharReach> classes = {hex, hex, sep};
+
+    m128 lo1, hi1, lo2, hi2;
+    u16 onechar;
+    u16 buckets[3];
+    shuftiBuildMultiMasks(nl, classes, (u8 *)&lo1, (u8 *)&hi1, (u8 *)&lo2,
+                          (u8 *)&hi2, &onechar, buckets);
+
+    const u8 *l1 = (const u8 *)&lo1;
+    const u8 *h1 = (const u8 *)&hi1;
+    const u8 *l2 = (const u8 *)&lo2;
+    const u8 *h2 = (const u8 *)&hi2;
+    for (u32 c = 0; c < 256; c++) {
+        u32 t = (l1[c & 0xf] & h1[c >> 4])
+              | (l2[c & 0xf] & h2[c >> 4]) << 8;
+        ASSERT_EQ(nl.test(c), !!(t & onechar));
+        for (size_t i = 0; i < classes.size(); i++) {
+            ASSERT_EQ(classes[i].test(c), !!(t & buckets[i]));
+        }
+    }
+}
+
+TEST(MultiShufti, BuildMasksWiden) {
+    // classes needing more buckets than we have are widened, never narrowed
+    std::vector<CharReach> classes(4);
+    for (u32 c = 0; c < 256; c += 7) {
+        classes[c % 4].set(c);
+    }
+
+    m128 lo1, hi1, lo2, hi2;
+    u16 onechar;
+    u16 buckets[4];
+    shuftiBuildMultiMasks(CharReach(), classes, (u8 *)&lo1, (u8 *)&hi1,
+                          (u8 *)&lo2, (u8 *)&hi2, &onechar, buckets);
+    ASSERT_EQ(0, onechar);
+
+    const u8 *l1 = (const u8 *)&lo1;
+    const u8 *h1 = (const u8 *)&hi1;
+    const u8 *l2 = (const u8 *)&lo2;
+    const u8 *h2 = (const u8 *)&hi2;
+    for (u32 c = 0; c < 256; c++) {
+        u32 t = (l1[c & 0xf] & h1[c >> 4])
+              | (l2[c & 0xf] & h2[c >> 4]) << 8;
+        for (size_t i = 0; i < classes.size(); i++) {
+            if (classes[i].test(c)) {
+                ASSERT_TRUE(t & buckets[i]);
+            }
+        }
+    }
+}
+
+TEST(MultiShufti, ExecMatch) {
+    CharReach hex;
+    hex.setRange('a', 'f');
+    hex.setRange('0', '9');
+    CharReach sep;
+    sep.set('-');
+    sep.set(':');
+    CharReach colon;
+    colon.set(':');
+
+    for (u32 len = 3; len <= 4; len++) {
+        std::vector<CharReach> classes = {hex, hex, sep};
+        if (len == 4) {
+            classes.push_back(colon);
+        }
+        for (u32 use_onechar = 0; use_onechar < 2; use_onechar++) {
+            CharReach nl;
+            if (use_onechar) {
+                nl.set('\n');
+            }
+
+            m128 lo1, hi1, lo2, hi2;
+            u16 onechar;
+            u16 buckets[4];
+            shuftiBuildMultiMasks(nl, classes, (u8 *)&lo1, (u8 *)&hi1,
+                                  (u8 *)&lo2, (u8 *)&hi2, &onechar, buckets);
+
+            // lots of near misses: hex digits without separators
+            const size_t size = 128;
+            u8 t[size];
+            for (size_t i = 0; i < size; i++) {
+                t[i] = "0a9fzq"[i % 6];
+            }
+
+            for (size_t pos = 0; pos < size; pos++) {
+                u8 u[size];
+                memcpy(u, t, size);
+                u[pos] = use_onechar && pos % 2 ? '\n' : ':';
+                for (size_t start = 0; start < 24; start++) {
+                    for (size_t end = start + 16; end <= size; end += 5) {
+                        const u8 *rv = shuftiMultiExec(lo1, hi1, lo2, hi2,
+                                                       onechar, buckets, len,
+                                                       u + start, u + end);
+                        ASSERT_EQ(multiShuftiRef(nl, classes, u + start,
+                                                 u + end), rv)
+                            << "len " << len << " pos " << pos << " start "
+                            << start << " end " << end;
+                    }
+                }
+            }
+        }
+    }
+}
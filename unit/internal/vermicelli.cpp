@@ -522,3 +522,44 @@ TEST(DoubleVermicelliMasked, Exec4) {
     }
 }
 
+
+TEST(Vermicelli, ExecLong) {
+    // Long enough for the wide loops used on AVX2 and AVX-512 targets.
+    char t1[300];
+
+    for (size_t i = 0; i < 16; i++) {
+        for (size_t pos = i; pos < sizeof(t1); pos += 7) {
+            memset(t1, 'b', sizeof(t1));
+            t1[pos] = 'a';
+            const u8 *begin = (const u8 *)t1 + i;
+            const u8 *end = (const u8 *)t1 + sizeof(t1);
+
+            const u8 *rv = vermicelliExec('a', 0, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = vermicelliExec('A', 1, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = nvermicelliExec('b', 0, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = nvermicelliExec('B', 1, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            if (pos + 1 == sizeof(t1)) {
+                continue;
+            }
+            t1[pos + 1] = 'A';
+
+            rv = vermicelliDoubleExec('a', 'A', 0, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = vermicelliDoubleExec('A', 'A', 1, begin, end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+
+            rv = vermicelliDoubleMaskedExec('A', 'A', CASE_CLEAR, 0xff, begin,
+                                            end);
+            ASSERT_EQ((const u8 *)t1 + pos, rv);
+        }
+    }
+}
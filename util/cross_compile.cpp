@@ -44,6 +44,8 @@ struct XcompileMode {
 };
 
 static const XcompileMode xcompile_options[] = {
+    { "avx512vbmi", HS_CPU_FEATURES_AVX512VBMI | HS_CPU_FEATURES_AVX512 |
+                    HS_CPU_FEATURES_AVX2 },
     { "avx512", HS_CPU_FEATURES_AVX512 },
     { "avx2", HS_CPU_FEATURES_AVX2 },
     { "base", 0 },
@@ -86,6 +88,11 @@ string to_string(const hs_platform_info &p) {
 
     if (p.cpu_features) {
         u64a features = p.cpu_features;
+        if (features & HS_CPU_FEATURES_AVX512VBMI) {
+            out << " avx512vbmi";
+            features &= ~HS_CPU_FEATURES_AVX512VBMI;
+        }
+
         if (features & HS_CPU_FEATURES_AVX512) {
             out << " avx512";
             features &= ~HS_CPU_FEATURES_AVX512;